@@ -0,0 +1,508 @@
+/* FILE: array.c */
+/*
+ *  module  : array.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A packed array holds numbers side by side, outside of node memory: a
+FLOATARRAY_ holds doubles and an INTARRAY_ holds integers. Arrays are
+never modified after they are made, so that they can be shared. The
+kernels are plain loops over restrict pointers that the compiler turns
+into vector instructions; with gcc on x86 each kernel is also compiled
+for AVX2 and the version that fits the processor is chosen at load time.
+Sums keep four partial results, so that they vectorize as well.
+Integer arithmetic that overflows delivers a FLOATARRAY_ instead, and
+integer sums and dot products continue as a bignum.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc_atomic
+#endif
+
+#define ARRAY(OP)	((OP) == FLOATARRAY_ || (OP) == INTARRAY_)
+
+PRIVATE Farray *alloc_farray(long size)
+{
+    Farray *a;
+
+    if ((a = malloc(sizeof(Farray) + size * sizeof(double))) == 0)
+	execerror("memory", "array");
+    a->size = size;
+    a->rows = 0;
+    return a;
+}
+
+PRIVATE Iarray *alloc_iarray(long size)
+{
+    Iarray *a;
+
+    if ((a = malloc(sizeof(Iarray) + size * sizeof(Num))) == 0)
+	execerror("memory", "array");
+    a->size = size;
+    return a;
+}
+
+/*
+    arr_new delivers a packed matrix, to be filled in by the caller.
+*/
+PUBLIC Farray *arr_new(long rows, long cols)
+{
+    Farray *a;
+
+    a = alloc_farray(rows * cols);
+    a->rows = rows;
+    return a;
+}
+
+PRIVATE long arr_length(Node *n)
+{
+    return n->op == FLOATARRAY_ ? n->u.farr->size : n->u.iarr->size;
+}
+
+PRIVATE long arr_rows(Node *n)		/* 0 unless a packed matrix */
+{
+    return n->op == FLOATARRAY_ ? n->u.farr->rows : 0;
+}
+
+PRIVATE double *as_doubles(Node *n)	/* the elements of n as doubles */
+{
+    Farray *a;
+    long i;
+
+    if (n->op == FLOATARRAY_)
+	return n->u.farr->dbl;
+    a = alloc_farray(n->u.iarr->size);
+    for (i = 0; i < a->size; i++)
+	a->dbl[i] = (double)n->u.iarr->num[i];
+    return a->dbl;
+}
+
+PRIVATE double scalar_double(Node *n)
+{
+    switch (n->op) {
+    case FLOAT_:
+	return n->u.dbl;
+    case BIGNUM_:
+	return num_double(n);
+    case RATIONAL_:
+	return rat_double(n);
+    default:
+	return (double)n->u.num;
+    }
+}
+
+/*
+    arr_pack makes an array of type op from a list of numbers or from
+    another array. Floats become integers by truncation.
+*/
+PUBLIC Operator arr_pack(Node *n, Operator op, Types *u, char *name)
+{
+    Node *m;
+    long i, size = 0;
+
+    if (ARRAY(n->op)) {
+	size = arr_length(n);
+	if (n->op == op) {
+	    *u = n->u;
+	    return op;
+	}
+	if (op == FLOATARRAY_) {
+	    u->farr = alloc_farray(size);
+	    for (i = 0; i < size; i++)
+		u->farr->dbl[i] = (double)n->u.iarr->num[i];
+	} else {
+	    u->iarr = alloc_iarray(size);
+	    for (i = 0; i < size; i++)
+		u->iarr->num[i] = (Num)n->u.farr->dbl[i];
+	}
+	return op;
+    }
+    if (n->op != LIST_)
+	execerror("list or array", name);
+    for (m = n->u.lis; m; m = m->next, size++)
+	if (m->op != INTEGER_ && (op == INTARRAY_ || (m->op != FLOAT_ &&
+	    m->op != BIGNUM_ && m->op != RATIONAL_)))
+	    execerror(op == INTARRAY_ ? "list of integers" : "list of numbers",
+		      name);
+    if (op == FLOATARRAY_) {
+	u->farr = alloc_farray(size);
+	for (m = n->u.lis, i = 0; m; m = m->next)
+	    u->farr->dbl[i++] = scalar_double(m);
+    } else {
+	u->iarr = alloc_iarray(size);
+	for (m = n->u.lis, i = 0; m; m = m->next)
+	    u->iarr->num[i++] = m->u.num;
+    }
+    return op;
+}
+
+/*
+    arr_unpack builds the list of the elements of an array, from the end,
+    so that the partial list is kept up to date by newnode.
+*/
+PUBLIC Node *arr_unpack(Node *n)
+{
+    Node *list = 0;
+    Farray *f;
+    Iarray *a;
+    long i;
+
+    if (n->op == FLOATARRAY_)
+	for (f = n->u.farr, i = f->size - 1; i >= 0; i--)
+	    list = FLOAT_NEWNODE(f->dbl[i], list);
+    else
+	for (a = n->u.iarr, i = a->size - 1; i >= 0; i--)
+	    list = INTEGER_NEWNODE(a->num[i], list);
+    return list;
+}
+
+PUBLIC long arr_size(Node *n)
+{
+    return arr_length(n);
+}
+
+PUBLIC void arr_at(Node *n, long i, Node *result)
+{
+    if (n->op == FLOATARRAY_) {
+	result->op = FLOAT_;
+	result->u.dbl = n->u.farr->dbl[i];
+    } else {
+	result->op = INTEGER_;
+	result->u.num = n->u.iarr->num[i];
+    }
+}
+
+/*
+    arr_equal compares two arrays element by element. An integer equals
+    a float of the same value, as with 1 1.0 =.
+*/
+PUBLIC int arr_equal(Node *a, Node *b)
+{
+    long i, size;
+
+    if ((b->op != FLOATARRAY_ && b->op != INTARRAY_) ||
+	(size = arr_length(a)) != arr_length(b) || arr_rows(a) != arr_rows(b))
+	return 0;
+    if (a->op == INTARRAY_ && b->op == INTARRAY_)
+	return !memcmp(a->u.iarr->num, b->u.iarr->num, size * sizeof(Num));
+    for (i = 0; i < size; i++)
+	if ((a->op == FLOATARRAY_ ? a->u.farr->dbl[i] : a->u.iarr->num[i]) !=
+	    (b->op == FLOATARRAY_ ? b->u.farr->dbl[i] : b->u.iarr->num[i]))
+	    return 0;
+    return 1;
+}
+
+/*
+    The float kernels: r = a OPER b, where a and b are arrays (mode 0),
+    or one of them is a single number: b (mode 'r') or a (mode 'l').
+*/
+#define FLOOP(OPER)						\
+    switch (mode) {						\
+    case 'l':							\
+	for (x = a[0], i = 0; i < n; i++)			\
+	    r[i] = x OPER b[i];					\
+	break;							\
+    case 'r':							\
+	for (x = b[0], i = 0; i < n; i++)			\
+	    r[i] = a[i] OPER x;					\
+	break;							\
+    default:							\
+	for (i = 0; i < n; i++)					\
+	    r[i] = a[i] OPER b[i];				\
+	break;							\
+    }
+
+KERNEL
+PRIVATE void float_kernel(double *restrict r, const double *restrict a,
+			  const double *restrict b, long n, int oper, int mode)
+{
+    double x;
+    long i;
+
+    switch (oper) {
+    case '+':
+	FLOOP(+);
+	break;
+    case '-':
+	FLOOP(-);
+	break;
+    case '*':
+	FLOOP(*);
+	break;
+    default:
+	FLOOP(/);
+	break;
+    }
+}
+
+/*
+    The integer kernels for + and - compute with wraparound and record
+    in a flag whether any element overflowed, which keeps them free of
+    branches. Multiplication and division are checked per element.
+*/
+#define ILOOP(X, Y)						\
+    for (i = 0; i < n; i++) {					\
+	s = oper == '+' ? (Setword)(X) + (Setword)(Y)		\
+			: (Setword)(X) - (Setword)(Y);		\
+	t = (Num)s;						\
+	flag |= oper == '+' ? ((X) ^ t) & ((Y) ^ t)		\
+			    : ((X) ^ (Y)) & ((X) ^ t);		\
+	r[i] = t;						\
+    }
+
+KERNEL
+PRIVATE int addsub_kernel(Num *restrict r, const Num *restrict a,
+			  const Num *restrict b, long n, int oper, int mode)
+{
+    Num x, t, flag = 0;
+    Setword s;
+    long i;
+
+    switch (mode) {
+    case 'l':
+	x = a[0];
+	ILOOP(x, b[i]);
+	break;
+    case 'r':
+	x = b[0];
+	ILOOP(a[i], x);
+	break;
+    default:
+	ILOOP(a[i], b[i]);
+	break;
+    }
+    return flag < 0;
+}
+
+PRIVATE int muldiv_kernel(Num *r, const Num *a, const Num *b, long n,
+			  int oper, int mode, char *name)
+{
+    Num x, y;
+    long i;
+
+    for (i = 0; i < n; i++) {
+	x = mode == 'l' ? a[0] : a[i];
+	y = mode == 'r' ? b[0] : b[i];
+	if (oper == '*') {
+	    if (OVERFLOW(x, y, mul, &r[i]))
+		return 1;
+	} else {
+	    if (y == 0)
+		execerror("non-zero divisor", name);
+	    if (y == -1 && x == -MAXINT - 1)
+		return 1;
+	    r[i] = x / y;
+	}
+    }
+    return 0;
+}
+
+/*
+    arr_arith computes a OPER b, where OPER is one of + - * / and at
+    least one of a and b is an array. The other one may be a number.
+    Integers stay integers, unless a float takes part or the result
+    does not fit, in which case a FLOATARRAY_ is delivered.
+*/
+PUBLIC Operator arr_arith(Node *a, Node *b, int oper, Types *u, char *name)
+{
+    Node *v = ARRAY(a->op) ? a : b, *s = ARRAY(a->op) ? b : a;
+    double x, *fa, *fb;
+    Num i, *ia, *ib;
+    long size;
+    int mode = 0;
+
+    size = arr_length(v);
+    if (ARRAY(s->op)) {
+	if (arr_length(s) != size || arr_rows(s) != arr_rows(v))
+	    execerror("arrays of equal size", name);
+    } else if (s->op == INTEGER_ || s->op == FLOAT_ ||
+	       s->op == BIGNUM_ || s->op == RATIONAL_)
+	mode = s == a ? 'l' : 'r';
+    else
+	execerror("array and number", name);
+    if (a->op != FLOATARRAY_ && b->op != FLOATARRAY_ &&
+	(!mode || s->op == INTEGER_)) {
+	u->iarr = alloc_iarray(size);
+	ia = mode == 'l' ? &i : a->u.iarr->num;
+	ib = mode == 'r' ? &i : b->u.iarr->num;
+	if (mode)
+	    i = s->u.num;
+	if (oper == '+' || oper == '-') {
+	    if (!addsub_kernel(u->iarr->num, ia, ib, size, oper, mode))
+		return INTARRAY_;
+	} else if (!muldiv_kernel(u->iarr->num, ia, ib, size, oper, mode, name))
+	    return INTARRAY_;
+    }
+    u->farr = alloc_farray(size);
+    u->farr->rows = arr_rows(v);
+    fa = mode == 'l' ? &x : as_doubles(a);
+    fb = mode == 'r' ? &x : as_doubles(b);
+    if (mode)
+	x = scalar_double(s);
+    float_kernel(u->farr->dbl, fa, fb, size, oper, mode);
+    return FLOATARRAY_;
+}
+
+KERNEL
+PRIVATE double float_dot(const double *restrict a, const double *restrict b,
+			 long n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    long i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+	s0 += a[i] * b[i];
+	s1 += a[i + 1] * b[i + 1];
+	s2 += a[i + 2] * b[i + 2];
+	s3 += a[i + 3] * b[i + 3];
+    }
+    for (; i < n; i++)
+	s0 += a[i] * b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+KERNEL
+PRIVATE double float_sum(const double *restrict a, long n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    long i;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+	s0 += a[i];
+	s1 += a[i + 1];
+	s2 += a[i + 2];
+	s3 += a[i + 3];
+    }
+    for (; i < n; i++)
+	s0 += a[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+/*
+    accumulate adds x into the integer in acc, that becomes a bignum
+    when it no longer fits.
+*/
+PRIVATE void accumulate(Node *acc, Node *x)
+{
+    Num r;
+
+    if (acc->op == INTEGER_ && x->op == INTEGER_ &&
+	!OVERFLOW(acc->u.num, x->u.num, add, &r))
+	acc->u.num = r;
+    else
+	acc->op = num_add(acc, x, '+', &acc->u);
+}
+
+PRIVATE Operator int_dot(Iarray *a, Iarray *b, Types *u)
+{
+    Node acc, x, y, p;
+    long i;
+
+    acc.op = INTEGER_;
+    acc.u.num = 0;
+    x.op = y.op = p.op = INTEGER_;
+    acc.next = x.next = y.next = p.next = 0;
+    for (i = 0; i < a->size; i++) {
+	x.u.num = a->num[i];
+	y.u.num = b->num[i];
+	p.op = INTEGER_;
+	if (OVERFLOW(x.u.num, y.u.num, mul, &p.u.num))
+	    p.op = num_mul(&x, &y, &p.u);
+	accumulate(&acc, &p);
+    }
+    *u = acc.u;
+    return acc.op;
+}
+
+PUBLIC Operator arr_dot(Node *a, Node *b, Types *u, char *name)
+{
+    if (!ARRAY(a->op) || !ARRAY(b->op))
+	execerror("two arrays", name);
+    if (arr_length(a) != arr_length(b))
+	execerror("arrays of equal size", name);
+    if (a->op == INTARRAY_ && b->op == INTARRAY_)
+	return int_dot(a->u.iarr, b->u.iarr, u);
+    u->dbl = float_dot(as_doubles(a), as_doubles(b), arr_length(a));
+    return FLOAT_;
+}
+
+/*
+    arr_reduce delivers the sum ('+'), the minimum ('<') or the maximum
+    ('>') of the elements. The sum of nothing is 0; there is no minimum
+    or maximum of nothing.
+*/
+PUBLIC Operator arr_reduce(Node *a, int oper, Types *u, char *name)
+{
+    Node acc, x;
+    double *f, m;
+    Num *n, k;
+    long i, size;
+
+    if (!ARRAY(a->op))
+	execerror("array", name);
+    size = arr_length(a);
+    if (oper != '+' && size == 0)
+	execerror("non-empty array", name);
+    if (a->op == FLOATARRAY_) {
+	f = a->u.farr->dbl;
+	if (oper == '+')
+	    m = float_sum(f, size);
+	else
+	    for (m = f[0], i = 1; i < size; i++)
+		if (oper == '<' ? f[i] < m : f[i] > m)
+		    m = f[i];
+	u->dbl = m;
+	return FLOAT_;
+    }
+    n = a->u.iarr->num;
+    if (oper != '+') {
+	for (k = n[0], i = 1; i < size; i++)
+	    if (oper == '<' ? n[i] < k : n[i] > k)
+		k = n[i];
+	u->num = k;
+	return INTEGER_;
+    }
+    acc.op = x.op = INTEGER_;
+    acc.u.num = 0;
+    acc.next = x.next = 0;
+    for (i = 0; i < size; i++) {
+	x.u.num = n[i];
+	accumulate(&acc, &x);
+    }
+    *u = acc.u;
+    return acc.op;
+}
+
+/*
+    arr_write writes a packed matrix as a list of its rows.
+*/
+PUBLIC void arr_write(Node *n, FILE *stm)
+{
+    long i, size, cols;
+
+    size = arr_length(n);
+    cols = arr_rows(n) ? size / arr_rows(n) : 0;
+    fprintf(stm, n->op == FLOATARRAY_ ? "farray:[" : "iarray:[");
+    for (i = 0; i < size; i++) {
+	if (i)
+	    fprintf(stm, cols && i % cols == 0 ? "] [" : " ");
+	else if (cols)
+	    fprintf(stm, "[");
+	if (n->op == FLOATARRAY_)
+	    fprintf(stm, "%g", n->u.farr->dbl[i]);
+	else
+#ifdef BIT_32
+	    fprintf(stm, "%ld", n->u.iarr->num[i]);
+#else
+	    fprintf(stm, "%lld", n->u.iarr->num[i]);
+#endif
+    }
+    fprintf(stm, cols ? "]]" : "]");
+}
+/* END of ARRAY.C */
@@ -0,0 +1,655 @@
+/* FILE: bignum.c */
+/*
+ *  module  : bignum.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+An integer is either an INTEGER_, that holds its value in the node, or a
+BIGNUM_, that points to an array of limbs, least significant first, with
+the sign in the size. Big numbers are normalized: their value does not
+fit in an INTEGER_. The functions below accept INTEGER_, CHAR_, BOOLEAN_
+and BIGNUM_ operands and deliver the kind that fits the result.
+Multiplication switches from the schoolbook method to Karatsuba beyond
+KARATSUBA limbs; division is Knuth's algorithm D.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc_atomic
+#    define free(X)
+#endif
+
+#ifdef BIT_32
+typedef unsigned long Dlimb;
+typedef long Slimb;
+typedef unsigned long Unum;
+#define DIGITS		10000UL		/* decimal chunk for printing	*/
+#define DIGITSIZE	4
+#else
+typedef unsigned long long Dlimb;
+typedef long long Slimb;
+typedef unsigned long long Unum;
+#define DIGITS		1000000000UL
+#define DIGITSIZE	9
+#endif
+#define LIMBBITS	((int)(8 * sizeof(Limb)))
+#define NUMLIMBS	(sizeof(Unum) / sizeof(Limb))
+#define KARATSUBA	32
+
+PRIVATE Limb *alloc_limbs(long size)
+{
+    Limb *r;
+
+    if ((r = malloc((size > 0 ? size : 1) * sizeof(Limb))) == 0)
+	execerror("memory", "bignum");
+    return r;
+}
+
+PRIVATE long trim(Limb *a, long n)
+{
+    while (n > 0 && !a[n - 1])
+	n--;
+    return n;
+}
+
+/*
+    magnitude delivers the magnitude of an integer as an array of limbs,
+    using tmp for integers that are held in the node.
+*/
+PRIVATE Limb *magnitude(Node *n, Limb *tmp, long *size, int *neg)
+{
+    Unum m;
+    long i;
+
+    if (n->op == BIGNUM_) {
+	*neg = n->u.bnum->size < 0;
+	*size = *neg ? -n->u.bnum->size : n->u.bnum->size;
+	return n->u.bnum->digit;
+    }
+    *neg = n->u.num < 0;
+    m = *neg ? -(Unum)n->u.num : (Unum)n->u.num;
+    for (i = 0; m; i++) {
+	tmp[i] = (Limb)m;
+	m >>= LIMBBITS;
+    }
+    *size = i;
+    return tmp;
+}
+
+/*
+    normalize delivers an INTEGER_ if the value fits, and a copy of the limbs
+    as a BIGNUM_ if it does not.
+*/
+PRIVATE Operator normalize(Limb *a, long n, int neg, Types *u)
+{
+    Bignum *b;
+    Unum m = 0;
+    long i;
+
+    n = trim(a, n);
+    if (n <= (long)NUMLIMBS) {
+	for (i = n; i-- > 0; )
+	    m = m << LIMBBITS | a[i];
+	if (m <= (Unum)MAXINT) {
+	    u->num = neg ? -(Num)m : (Num)m;
+	    return INTEGER_;
+	}
+	if (neg && m == (Unum)MAXINT + 1) {
+	    u->num = -MAXINT - 1;
+	    return INTEGER_;
+	}
+    }
+    if ((b = malloc(sizeof(Bignum) + (n - 1) * sizeof(Limb))) == 0)
+	execerror("memory", "bignum");
+    memcpy(b->digit, a, n * sizeof(Limb));
+    b->size = neg ? -n : n;
+    u->bnum = b;
+    return BIGNUM_;
+}
+
+PRIVATE int cmp_mag(Limb *a, long n, Limb *b, long m)
+{
+    if (n != m)
+	return n < m ? -1 : 1;
+    while (n-- > 0)
+	if (a[n] != b[n])
+	    return a[n] < b[n] ? -1 : 1;
+    return 0;
+}
+
+PRIVATE Limb add_mag(Limb *r, Limb *a, long n, Limb *b, long m)  /* n >= m */
+{
+    Dlimb t = 0;
+    long i;
+
+    for (i = 0; i < m; i++) {
+	t += (Dlimb)a[i] + b[i];
+	r[i] = (Limb)t;
+	t >>= LIMBBITS;
+    }
+    for (; i < n; i++) {
+	t += a[i];
+	r[i] = (Limb)t;
+	t >>= LIMBBITS;
+    }
+    return (Limb)t;
+}
+
+PRIVATE void sub_mag(Limb *r, Limb *a, long n, Limb *b, long m)	/* a >= b */
+{
+    Dlimb t, borrow = 0;
+    long i;
+
+    for (i = 0; i < n; i++) {
+	t = (Dlimb)a[i] - (i < m ? b[i] : 0) - borrow;
+	r[i] = (Limb)t;
+	borrow = (t >> LIMBBITS) != 0;
+    }
+}
+
+PRIVATE void mul_school(Limb *r, Limb *a, long n, Limb *b, long m)
+{
+    Dlimb t;
+    long i, j;
+
+    memset(r, 0, (n + m) * sizeof(Limb));
+    for (i = 0; i < m; i++) {
+	if (!b[i])
+	    continue;
+	for (t = 0, j = 0; j < n; j++) {
+	    t += (Dlimb)a[j] * b[i] + r[i + j];
+	    r[i + j] = (Limb)t;
+	    t >>= LIMBBITS;
+	}
+	r[i + n] = (Limb)t;
+    }
+}
+
+/*
+    mul_mag stores the n + m limbs of a * b in r. With a = a1 B^h + a0
+    and b = b1 B^h + b0, Karatsuba computes a1 b1, a0 b0 and
+    (a1 + a0)(b1 + b0), from which the middle term follows.
+*/
+PRIVATE void mul_mag(Limb *r, Limb *a, long n, Limb *b, long m)
+{
+    Limb *t, *s1, *s2;
+    long h, k;
+
+    if (n < m) {
+	t = a; a = b; b = t;
+	h = n; n = m; m = h;
+    }
+    if (m < KARATSUBA) {
+	mul_school(r, a, n, b, m);
+	return;
+    }
+    h = (n + 1) / 2;
+    if (m <= h) {				/* unbalanced */
+	t = alloc_limbs(n - h + m);
+	mul_mag(r, a, h, b, m);
+	memset(r + h + m, 0, (n - h) * sizeof(Limb));
+	mul_mag(t, a + h, n - h, b, m);
+	add_mag(r + h, r + h, n - h + m, t, n - h + m);
+	free(t);
+	return;
+    }
+    k = h + 1;
+    s1 = alloc_limbs(k);
+    s2 = alloc_limbs(k);
+    t = alloc_limbs(2 * k);
+    s1[h] = add_mag(s1, a, h, a + h, n - h);
+    s2[h] = add_mag(s2, b, h, b + h, m - h);
+    mul_mag(t, s1, k, s2, k);
+    mul_mag(r, a, h, b, h);
+    mul_mag(r + 2 * h, a + h, n - h, b + h, m - h);
+    sub_mag(t, t, 2 * k, r, 2 * h);
+    sub_mag(t, t, 2 * k, r + 2 * h, n + m - 2 * h);
+    add_mag(r + h, r + h, n + m - h, t, trim(t, 2 * k));
+    free(t);
+    free(s2);
+    free(s1);
+}
+
+/*
+    div_mag divides the m limbs of u by the n limbs of v, m >= n, giving
+    m - n + 1 limbs of quotient in q and n limbs of remainder in r.
+*/
+PRIVATE void div_mag(Limb *q, Limb *r, Limb *u, long m, Limb *v, long n)
+{
+    Dlimb b = (Dlimb)1 << LIMBBITS, qhat, rhat, p, rem;
+    Limb *un, *vn;
+    Slimb t, k;
+    long i, j;
+    int s;
+
+    if (n == 1) {
+	for (rem = 0, j = m - 1; j >= 0; j--) {
+	    rem = (rem << LIMBBITS) | u[j];
+	    q[j] = (Limb)(rem / v[0]);
+	    rem %= v[0];
+	}
+	r[0] = (Limb)rem;
+	return;
+    }
+    for (s = 0; !(((Dlimb)v[n - 1] << s) & (b >> 1)); s++)
+	;
+    vn = alloc_limbs(n);
+    un = alloc_limbs(m + 1);
+    for (i = n - 1; i > 0; i--)
+	vn[i] = (Limb)((Dlimb)v[i] << s | (Dlimb)v[i - 1] >> (LIMBBITS - s));
+    vn[0] = (Limb)((Dlimb)v[0] << s);
+    un[m] = (Limb)((Dlimb)u[m - 1] >> (LIMBBITS - s));
+    for (i = m - 1; i > 0; i--)
+	un[i] = (Limb)((Dlimb)u[i] << s | (Dlimb)u[i - 1] >> (LIMBBITS - s));
+    un[0] = (Limb)((Dlimb)u[0] << s);
+    for (j = m - n; j >= 0; j--) {
+	p = (Dlimb)un[j + n] << LIMBBITS | un[j + n - 1];
+	qhat = p / vn[n - 1];
+	rhat = p - qhat * vn[n - 1];
+	while (qhat >= b ||
+	       qhat * vn[n - 2] > (rhat << LIMBBITS | un[j + n - 2])) {
+	    qhat--;
+	    if ((rhat += vn[n - 1]) >= b)
+		break;
+	}
+	for (k = 0, i = 0; i < n; i++) {
+	    p = qhat * vn[i];
+	    t = (Slimb)un[i + j] - k - (Slimb)(p & (b - 1));
+	    un[i + j] = (Limb)t;
+	    k = (Slimb)(p >> LIMBBITS) - (t >> LIMBBITS);
+	}
+	t = (Slimb)un[j + n] - k;
+	un[j + n] = (Limb)t;
+	q[j] = (Limb)qhat;
+	if (t < 0) {				/* added back */
+	    q[j]--;
+	    for (k = 0, i = 0; i < n; i++) {
+		t = (Slimb)un[i + j] + vn[i] + k;
+		un[i + j] = (Limb)t;
+		k = t >> LIMBBITS;
+	    }
+	    un[j + n] = (Limb)(un[j + n] + k);
+	}
+    }
+    for (i = 0; i < n; i++)
+	r[i] = (Limb)((Dlimb)un[i] >> s | (Dlimb)un[i + 1] << (LIMBBITS - s));
+    free(un);
+    free(vn);
+}
+
+/*
+    num_overflow tells whether a OPER b does not fit in an INTEGER_, and
+    stores the result in r if it does. OPER is 'a'dd, 's'ubtract or
+    'm'ultiply. Compilers without overflow builtins use it.
+*/
+PUBLIC int num_overflow(Num a, Num b, int oper, Num *r)
+{
+    Unum ma, mb;
+    int over;
+
+    switch (oper) {
+    case 'a':
+	over = b > 0 ? a > MAXINT - b : a < -MAXINT - 1 - b;
+	if (!over)
+	    *r = a + b;
+	return over;
+    case 's':
+	over = b < 0 ? a > MAXINT + b : a < -MAXINT - 1 + b;
+	if (!over)
+	    *r = a - b;
+	return over;
+    default:
+	ma = a < 0 ? -(Unum)a : (Unum)a;
+	mb = b < 0 ? -(Unum)b : (Unum)b;
+	over = mb && ma > ((Unum)MAXINT + ((a < 0) != (b < 0))) / mb;
+	if (!over)
+	    *r = a * b;
+	return over;
+    }
+}
+
+PUBLIC Operator num_add(Node *a, Node *b, int oper, Types *u)
+{
+    Limb ta[NUMLIMBS], tb[NUMLIMBS], *x, *y, *r;
+    long n, m, i;
+    int na, nb, j;
+    Operator op;
+
+    x = magnitude(a, ta, &n, &na);
+    y = magnitude(b, tb, &m, &nb);
+    if (oper == '-')
+	nb = !nb;
+    if (cmp_mag(x, n, y, m) < 0) {		/* |x| >= |y| */
+	r = x; x = y; y = r;
+	i = n; n = m; m = i;
+	j = na; na = nb; nb = j;
+    }
+    r = alloc_limbs(n + 1);
+    if (na == nb)
+	r[n] = add_mag(r, x, n, y, m);
+    else {
+	sub_mag(r, x, n, y, m);
+	r[n] = 0;
+    }
+    op = normalize(r, n + 1, na, u);
+    free(r);
+    return op;
+}
+
+PUBLIC Operator num_mul(Node *a, Node *b, Types *u)
+{
+    Limb ta[NUMLIMBS], tb[NUMLIMBS], *x, *y, *r;
+    long n, m;
+    int na, nb;
+    Operator op;
+
+    x = magnitude(a, ta, &n, &na);
+    y = magnitude(b, tb, &m, &nb);
+    r = alloc_limbs(n + m);
+    mul_mag(r, x, n, y, m);
+    op = normalize(r, n + m, na != nb, u);
+    free(r);
+    return op;
+}
+
+/*
+    num_div truncates towards zero, as the C operators do; the remainder
+    has the sign of a. The divisor must not be zero.
+*/
+PUBLIC Operator num_div(Node *a, Node *b, Types *q, Operator *rop, Types *r)
+{
+    Limb ta[NUMLIMBS], tb[NUMLIMBS], *x, *y, *qq, *rr;
+    long n, m;
+    int na, nb;
+    Operator op;
+
+    x = magnitude(a, ta, &n, &na);
+    y = magnitude(b, tb, &m, &nb);
+    if (cmp_mag(x, n, y, m) < 0) {
+	*rop = normalize(x, n, na, r);
+	return normalize(x, 0, 0, q);
+    }
+    qq = alloc_limbs(n - m + 1);
+    rr = alloc_limbs(m);
+    div_mag(qq, rr, x, n, y, m);
+    *rop = normalize(rr, m, na, r);
+    op = normalize(qq, n - m + 1, na != nb, q);
+    free(rr);
+    free(qq);
+    return op;
+}
+
+/*
+    shift_down divides a by 2 to the power bits, bits being less than the
+    number of bits in a, and delivers the new length.
+*/
+PRIVATE long shift_down(Limb *a, long n, long bits)
+{
+    long i, k = bits / LIMBBITS;
+    int s = bits % LIMBBITS;
+
+    for (i = 0; i + k < n; i++) {
+	a[i] = (Limb)(a[i + k] >> s);
+	if (s && i + k + 1 < n)
+	    a[i] |= (Limb)((Dlimb)a[i + k + 1] << (LIMBBITS - s));
+    }
+    return trim(a, n - k);
+}
+
+PRIVATE long trailing_zeros(Limb *a)
+{
+    long i;
+
+    for (i = 0; !a[i]; i++)
+	;
+    return i * LIMBBITS + CTZ((Setword)a[i]);
+}
+
+/*
+    num_gcd is the binary algorithm: both numbers are made odd, and the
+    smaller is subtracted from the larger, until they fit in a word.
+*/
+PUBLIC Operator num_gcd(Node *a, Node *b, Types *u)
+{
+    Limb ta[NUMLIMBS], tb[NUMLIMBS], *x, *y, *t, *buf;
+    long n, m, i, k;
+    int na, nb;
+    Unum p, q, w;
+    Operator op;
+
+    x = magnitude(a, ta, &n, &na);
+    y = magnitude(b, tb, &m, &nb);
+    if (!n || !m)
+	return normalize(n ? x : y, n ? n : m, 0, u);
+    buf = alloc_limbs(n + m + NUMLIMBS);
+    memcpy(buf, x, n * sizeof(Limb));
+    memcpy(buf + n, y, m * sizeof(Limb));
+    x = buf;
+    y = buf + n;
+    k = trailing_zeros(x);
+    if ((i = trailing_zeros(y)) < k)
+	k = i;
+    n = shift_down(x, n, trailing_zeros(x));
+    m = shift_down(y, m, trailing_zeros(y));
+    while (n > (long)NUMLIMBS || m > (long)NUMLIMBS) {
+	if (cmp_mag(x, n, y, m) > 0) {
+	    t = x; x = y; y = t;
+	    i = n; n = m; m = i;
+	}
+	sub_mag(y, y, m, x, n);
+	if ((m = trim(y, m)) == 0)
+	    break;
+	m = shift_down(y, m, trailing_zeros(y));
+    }
+    if (m) {
+	for (p = 0, i = n; i-- > 0; )
+	    p = p << LIMBBITS | x[i];
+	for (q = 0, i = m; i-- > 0; )
+	    q = q << LIMBBITS | y[i];
+	while (q) {
+	    if (p > q) {
+		w = p; p = q; q = w;
+	    }
+	    if ((q -= p) != 0)
+		q >>= CTZ((Setword)q);
+	}
+	x = buf;
+	for (n = 0; p; p >>= LIMBBITS)
+	    x[n++] = (Limb)p;
+    }
+    y = alloc_limbs(n + k / LIMBBITS + 1);
+    memset(y, 0, (n + k / LIMBBITS + 1) * sizeof(Limb));
+    for (i = 0; i < n; i++) {
+	y[i + k / LIMBBITS] |= (Limb)((Dlimb)x[i] << (k % LIMBBITS));
+	if (k % LIMBBITS)
+	    y[i + k / LIMBBITS + 1] =
+		(Limb)((Dlimb)x[i] >> (LIMBBITS - k % LIMBBITS));
+    }
+    op = normalize(y, n + k / LIMBBITS + 1, 0, u);
+    free(y);
+    free(buf);
+    return op;
+}
+
+PUBLIC Operator num_neg(Node *a, Types *u)
+{
+    Limb ta[NUMLIMBS], *x;
+    long n;
+    int na;
+
+    x = magnitude(a, ta, &n, &na);
+    return normalize(x, n, !na, u);
+}
+
+PUBLIC Operator num_abs(Node *a, Types *u)
+{
+    Limb ta[NUMLIMBS], *x;
+    long n;
+    int na;
+
+    x = magnitude(a, ta, &n, &na);
+    return normalize(x, n, 0, u);
+}
+
+PUBLIC Operator num_pow(Node *a, long e, Types *u)
+{
+    Limb ta[NUMLIMBS], *x, *r, *base, *t;
+    long n, rn, bn;
+    int na, odd = e & 1;
+    Operator op;
+
+    x = magnitude(a, ta, &n, &na);
+    r = alloc_limbs(1);
+    r[0] = 1;
+    rn = 1;
+    base = x;
+    bn = n;
+    while (e > 0) {
+	if (e & 1) {
+	    t = alloc_limbs(rn + bn);
+	    mul_mag(t, r, rn, base, bn);
+	    free(r);
+	    r = t;
+	    rn = trim(r, rn + bn);
+	}
+	if ((e >>= 1) > 0) {
+	    t = alloc_limbs(2 * bn);
+	    mul_mag(t, base, bn, base, bn);
+	    if (base != x) {
+		free(base);
+	    }
+	    base = t;
+	    bn = trim(base, 2 * bn);
+	}
+    }
+    if (base != x) {
+	free(base);
+    }
+    op = normalize(r, rn, na && odd, u);
+    free(r);
+    return op;
+}
+
+PUBLIC int num_compare(Node *a, Node *b)
+{
+    Limb ta[NUMLIMBS], tb[NUMLIMBS], *x, *y;
+    long n, m;
+    int na, nb;
+
+    x = magnitude(a, ta, &n, &na);
+    y = magnitude(b, tb, &m, &nb);
+    if (na != nb)
+	return na ? -1 : 1;
+    return na ? cmp_mag(y, m, x, n) : cmp_mag(x, n, y, m);
+}
+
+PUBLIC double num_double(Node *a)
+{
+    Limb ta[NUMLIMBS], *x;
+    double d = 0;
+    long n;
+    int na;
+
+    x = magnitude(a, ta, &n, &na);
+    while (n-- > 0)
+	d = d * (double)((Dlimb)1 << LIMBBITS) + x[n];
+    return na ? -d : d;
+}
+
+/*
+    num_string divides by the largest power of ten that fits in a limb,
+    delivering that many decimal digits per pass.
+*/
+PUBLIC char *num_string(Node *a)
+{
+    Limb ta[NUMLIMBS], *x, *t;
+    unsigned long *chunk;
+    char *str, *p;
+    Dlimb rem;
+    long n, i, k;
+    int na;
+
+    x = magnitude(a, ta, &n, &na);
+    t = alloc_limbs(n);
+    memcpy(t, x, n * sizeof(Limb));
+    if ((chunk = malloc((n * LIMBBITS / (3 * DIGITSIZE) + 2) *
+			sizeof(unsigned long))) == 0)
+	execerror("memory", "bignum");
+    for (k = 0; n > 0 || k == 0; k++) {
+	for (rem = 0, i = n; i-- > 0; ) {
+	    rem = rem << LIMBBITS | t[i];
+	    t[i] = (Limb)(rem / DIGITS);
+	    rem %= DIGITS;
+	}
+	chunk[k] = (unsigned long)rem;
+	n = trim(t, n);
+    }
+    if ((str = malloc(k * DIGITSIZE + 2)) == 0)
+	execerror("memory", "bignum");
+    p = str + sprintf(str, "%s%lu", na ? "-" : "", chunk[--k]);
+    while (k-- > 0)
+	p += sprintf(p, "%0*lu", DIGITSIZE, chunk[k]);
+    free(chunk);
+    free(t);
+    return str;
+}
+
+PUBLIC void num_write(Node *a, FILE *stm)
+{
+    char *str;
+
+    str = num_string(a);
+    fputs(str, stm);
+    free(str);
+}
+
+/*
+    num_parse reads an integer that is too large for strtol, in the same
+    notation: an optional sign, then hexadecimal after 0x, octal after 0
+    and decimal otherwise.
+*/
+PUBLIC Operator num_parse(char *s, Types *u)
+{
+    Limb *r;
+    Dlimb t;
+    long rn = 0, i;
+    int neg = 0, base = 10, d;
+    Operator op;
+
+    if (*s == '-' || *s == '+')
+	neg = *s++ == '-';
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+	base = 16;
+	s += 2;
+    } else if (s[0] == '0')
+	base = 8;
+    r = alloc_limbs(strlen(s) * 4 / LIMBBITS + 1);
+    for (; *s; s++) {
+	if (*s >= '0' && *s <= '9')
+	    d = *s - '0';
+	else if (*s >= 'a' && *s <= 'f')
+	    d = *s - 'a' + 10;
+	else if (*s >= 'A' && *s <= 'F')
+	    d = *s - 'A' + 10;
+	else
+	    break;
+	if (d >= base)
+	    break;
+	for (t = d, i = 0; i < rn; i++) {
+	    t += (Dlimb)r[i] * base;
+	    r[i] = (Limb)t;
+	    t >>= LIMBBITS;
+	}
+	if (t)
+	    r[rn++] = (Limb)t;
+    }
+    op = normalize(r, rn, neg, u);
+    free(r);
+    return op;
+}
+/* END of BIGNUM.C */
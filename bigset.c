@@ -0,0 +1,324 @@
+/* FILE: bigset.c */
+/*
+ *  module  : bigset.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A set is either a SET_, that holds its members in the node itself and
+can only have members below SETSIZE, or a BIGSET_, that points to an
+array of words. Big sets are always normalized: the last word is not
+zero and there is at least one member of SETSIZE or more. All other
+sets are SET_. The functions below accept both kinds and deliver the
+kind that fits the result; they iterate with CTZ and count with
+POPCOUNT, and combine two sets one word at a time.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc_atomic
+#    define realloc GC_realloc
+#    define free(X)
+#endif
+
+#define WORDBITS	((long)(8 * sizeof(Setword)))
+#define SETMASK		(~(Setword)0 >> (WORDBITS - SETSIZE))
+#define ONE		((Setword)1)
+
+#ifndef __GNUC__
+PUBLIC int popcount(Setword w)
+{
+    int n;
+
+    for (n = 0; w; n++)
+	w &= w - 1;
+    return n;
+}
+
+PUBLIC int ctz(Setword w)
+{
+    int n;
+
+    for (n = 0; !(w & ONE); n++)
+	w >>= 1;
+    return n;
+}
+#endif
+
+PRIVATE Setword *view(Node *n, Setword *tmp, long *size)
+{
+    if (n->op == BIGSET_) {
+	*size = n->u.big->size;
+	return n->u.big->bits;
+    }
+    *tmp = (Setword)n->u.set & SETMASK;
+    *size = *tmp != 0;
+    return tmp;
+}
+
+PRIVATE Bigset *alloc_set(long size)
+{
+    Bigset *b;
+
+    if (size < 1)
+	size = 1;
+    if ((b = malloc(sizeof(Bigset) + (size - 1) * sizeof(Setword))) == 0)
+	execerror("memory", "bigset");
+    b->size = size;
+    memset(b->bits, 0, size * sizeof(Setword));
+    return b;
+}
+
+PRIVATE Bigset *copy_set(Node *n, long size)
+{
+    Setword tmp, *bits;
+    long leng;
+    Bigset *b;
+
+    bits = view(n, &tmp, &leng);
+    b = alloc_set(leng > size ? leng : size);
+    memcpy(b->bits, bits, leng * sizeof(Setword));
+    return b;
+}
+
+/*
+    set_add adds member i to a set under construction, that starts out
+    as a null pointer and grows as needed. set_make finishes it.
+*/
+PUBLIC Bigset *set_add(Bigset *b, long i)
+{
+    long k, size, old;
+
+    if (i < 0 || i >= BIGSETMAX)
+	return b;
+    k = i / WORDBITS;
+    if (!b || k >= b->size) {
+	old = b ? b->size : 0;
+	if ((size = 2 * old) <= k)
+	    size = k + 1;
+	if ((b = realloc(b, sizeof(Bigset) +
+			(size - 1) * sizeof(Setword))) == 0)
+	    execerror("memory", "bigset");
+	memset(b->bits + old, 0, (size - old) * sizeof(Setword));
+	b->size = size;
+    }
+    b->bits[k] |= ONE << (i % WORDBITS);
+    return b;
+}
+
+PUBLIC Operator set_make(Bigset *b, Types *u)
+{
+    long size = b ? b->size : 0;
+
+    while (size > 0 && !b->bits[size - 1])
+	size--;
+    if (size == 0 || (size == 1 && !(b->bits[0] >> (SETSIZE - 1) >> 1))) {
+	u->set = size ? b->bits[0] : 0;
+	if (b) {
+	    free(b);
+	}
+	return SET_;
+    }
+    b->size = size;
+    u->big = b;
+    return BIGSET_;
+}
+
+PUBLIC long set_next(Node *n, long i)
+{
+    Setword tmp, *bits, w;
+    long k, size;
+
+    if (i < 0)
+	i = 0;
+    if (n->op == SET_) {
+	if (i >= SETSIZE)
+	    return -1;
+	w = (Setword)n->u.set & SETMASK & (~(Setword)0 << i);
+	return w ? CTZ(w) : -1;
+    }
+    bits = view(n, &tmp, &size);
+    if ((k = i / WORDBITS) >= size)
+	return -1;
+    if ((w = bits[k] & (~(Setword)0 << (i % WORDBITS))) != 0)
+	return k * WORDBITS + CTZ(w);
+    while (++k < size)
+	if ((w = bits[k]) != 0)
+	    return k * WORDBITS + CTZ(w);
+    return -1;
+}
+
+PUBLIC long set_nth(Node *n, long k)
+{
+    Setword tmp, *bits, w;
+    long i, size, count;
+
+    if (k < 0)
+	return -1;
+    bits = view(n, &tmp, &size);
+    for (i = 0; i < size; i++) {
+	w = bits[i];
+	if (k < (count = POPCOUNT(w))) {
+	    while (k--)
+		w &= w - 1;
+	    return i * WORDBITS + CTZ(w);
+	}
+	k -= count;
+    }
+    return -1;
+}
+
+PUBLIC long set_size(Node *n)
+{
+    Setword tmp, *bits;
+    long i, size, count = 0;
+
+    bits = view(n, &tmp, &size);
+    for (i = 0; i < size; i++)
+	count += POPCOUNT(bits[i]);
+    return count;
+}
+
+PUBLIC int set_member(Node *n, long i)
+{
+    Setword tmp, *bits;
+    long size;
+
+    if (i < 0)
+	return 0;
+    bits = view(n, &tmp, &size);
+    if (i / WORDBITS >= size)
+	return 0;
+    return (bits[i / WORDBITS] >> (i % WORDBITS)) & ONE;
+}
+
+PUBLIC int set_subset(Node *a, Node *b)	/* all members of a are in b */
+{
+    Setword tmp1, tmp2, *bits1, *bits2;
+    long i, size1, size2;
+
+    bits1 = view(a, &tmp1, &size1);
+    bits2 = view(b, &tmp2, &size2);
+    for (i = 0; i < size1; i++)
+	if (bits1[i] & ~(i < size2 ? bits2[i] : 0))
+	    return 0;
+    return 1;
+}
+
+PUBLIC int set_compare(Node *a, Node *b)	/* as unsigned numbers */
+{
+    Setword tmp1, tmp2, *bits1, *bits2, w1, w2;
+    long i, size1, size2;
+
+    bits1 = view(a, &tmp1, &size1);
+    bits2 = view(b, &tmp2, &size2);
+    for (i = size1 > size2 ? size1 : size2; --i >= 0; ) {
+	w1 = i < size1 ? bits1[i] : 0;
+	w2 = i < size2 ? bits2[i] : 0;
+	if (w1 != w2)
+	    return w1 < w2 ? -1 : 1;
+    }
+    return 0;
+}
+
+PUBLIC Operator set_insert(Node *n, long i, Types *u)
+{
+    Bigset *b;
+
+    if (n->op == SET_ && i >= 0 && i < SETSIZE) {
+	u->set = (Setword)n->u.set | ONE << i;
+	return SET_;
+    }
+    if (i < 0 || i >= BIGSETMAX)
+	return set_make(copy_set(n, 0), u);
+    b = copy_set(n, i / WORDBITS + 1);
+    b->bits[i / WORDBITS] |= ONE << (i % WORDBITS);
+    return set_make(b, u);
+}
+
+PUBLIC Operator set_remove(Node *n, long i, Types *u)
+{
+    Bigset *b;
+
+    if (n->op == SET_) {
+	u->set = i >= 0 && i < SETSIZE ?
+		 (Setword)n->u.set & ~(ONE << i) : (Setword)n->u.set;
+	return SET_;
+    }
+    b = copy_set(n, 0);
+    if (i >= 0 && i / WORDBITS < b->size)
+	b->bits[i / WORDBITS] &= ~(ONE << (i % WORDBITS));
+    return set_make(b, u);
+}
+
+PUBLIC Operator set_range(Node *n, long lo, long hi, Types *u)
+{
+    Bigset *b;
+    long i;
+
+    b = copy_set(n, 0);
+    for (i = 0; i < b->size; i++) {
+	if ((i + 1) * WORDBITS <= lo || i * WORDBITS >= hi)
+	    b->bits[i] = 0;
+	else {
+	    if (lo > i * WORDBITS)
+		b->bits[i] &= ~(Setword)0 << (lo - i * WORDBITS);
+	    if (hi < (i + 1) * WORDBITS)
+		b->bits[i] &= ~(~(Setword)0 << (hi - i * WORDBITS));
+	}
+    }
+    return set_make(b, u);
+}
+
+PUBLIC Operator set_binop(Node *a, Node *b, int oper, Types *u)
+{
+    Setword tmp1, tmp2, *bits1, *bits2, w1, w2;
+    long i, size1, size2, size;
+    Bigset *result;
+
+    bits1 = view(a, &tmp1, &size1);
+    bits2 = view(b, &tmp2, &size2);
+    size = size1 > size2 ? size1 : size2;
+    if (oper == '&' && size > size1)
+	size = size1;
+    if (oper == '&' && size > size2)
+	size = size2;
+    result = alloc_set(size);
+    for (i = 0; i < size; i++) {
+	w1 = i < size1 ? bits1[i] : 0;
+	w2 = i < size2 ? bits2[i] : 0;
+	switch (oper) {
+	case '&':
+	    result->bits[i] = w1 & w2;
+	    break;
+	case '|':
+	    result->bits[i] = w1 | w2;
+	    break;
+	case '^':
+	    result->bits[i] = w1 ^ w2;
+	    break;
+	default:
+	    result->bits[i] = w1 & ~w2;
+	    break;
+	}
+    }
+    return set_make(result, u);
+}
+
+/*
+    The complement of a set is taken over the members below SETSIZE, as
+    before there were big sets. A big set has members beyond that, and
+    its complement would not give it back: it is an error.
+*/
+PUBLIC Operator set_not(Node *n, Types *u)
+{
+    if (n->op == BIGSET_)
+	execerror("set below setsize", "not");
+    u->set = ~(Setword)n->u.set & SETMASK;
+    return SET_;
+}
+/* END of BIGSET.C */
@@ -0,0 +1,388 @@
+/* FILE: cache.c */
+/*
+ *  module  : cache.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+An included file is kept in a side file, in the directory given by joy
+--cache, as the symbols that getsym found in it: numbers, and strings
+and names, each text kept once; the side file is named by a hash of the
+path of the file. When the file is included again at the end of a line,
+getsym takes the symbols from there instead of scanning the text, see
+scan.c. The definitions and terms are then read from them as before, in
+the same order, so that what the file prints or includes still happens.
+
+The side file is used when it was written by this interpreter for the
+same path, and the file has kept its time, size and the hash of its
+contents; otherwise it is written again, to a file of its own that is
+then renamed, so that a reader never sees half of one. Each symbol is
+checked before it is used, as the side file may have been damaged. It
+is not written when the file had an error, or when it has a number
+beyond maxint: such symbols are not kept. Without --cache there are no
+side files.
+*/
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <unistd.h>
+#else
+#include <process.h>
+#define getpid		_getpid
+#endif
+
+#define CACHEMAGIC	"JOYC2"
+#define CACHEMIN	256		/* symbols		*/
+
+typedef struct Token
+  { Symbol sym;
+    int hash;					/* of a name		*/
+    Types u; } Token;				/* string: text offset	*/
+
+typedef struct Header
+  { char magic[8], version[24];
+    long long mtime, size;			/* of the file		*/
+    unsigned long long sum;			/* of its contents	*/
+    long count, text; } Header;			/* text: path first	*/
+
+struct Cache
+  { Header head;
+    Token *toks;
+    long pos, room;
+    char *text;
+    long used, size;
+    long *seen, slots, names;			/* text offset + 1	*/
+    int failed, errors; };
+
+PRIVATE void cache_version(char *version)
+{
+    memset(version, 0, 24);
+    strncpy(version, __DATE__ " " __TIME__, 23);
+}
+
+/*
+    cache_file gives the name of the side file in the directory cachedir,
+    or 0.
+*/
+PRIVATE char *cache_file(char *name)
+{
+    char *file, *s;
+    unsigned long long h = 14695981039346656037ULL;
+
+    for (s = name; *s; s++)
+	h = (h ^ (unsigned char)*s) * 1099511628211ULL;
+    if ((file = malloc(strlen(cachedir) + 24)) != 0)
+	sprintf(file, "%s/%016llx.joyc", cachedir, h);
+    return file;
+}
+
+/*
+    cache_key fills in the header that the side file of name must have:
+    it holds the time and size of the file, and a hash of its contents,
+    as a change within the same second may keep the size.
+*/
+PRIVATE int cache_key(char *name, Header *head)
+{
+    struct stat st;
+    unsigned long long h = 14695981039346656037ULL;
+    char buf[BUFSIZ];
+    size_t i, n;
+    FILE *fp;
+
+    memset(head, 0, sizeof(Header));
+    if (stat(name, &st) || (fp = fopen(name, "rb")) == 0)
+	return 0;
+    while ((n = fread(buf, 1, BUFSIZ, fp)) > 0)
+	for (i = 0; i < n; i++)
+	    h = (h ^ (unsigned char)buf[i]) * 1099511628211ULL;
+    fclose(fp);
+    strcpy(head->magic, CACHEMAGIC);
+    cache_version(head->version);
+    head->mtime = st.st_mtime;
+    head->size = st.st_size;
+    head->sum = h;
+    return 1;
+}
+
+PRIVATE long cache_slot(Cache *c, char *s)
+{
+    unsigned long h;
+
+    for (h = 0; *s; s++)
+	h = 31 * h + (unsigned char)*s;
+    return h % c->slots;
+}
+
+/*
+    cache_seen makes room for more texts in the table of those that have
+    been kept.
+*/
+PRIVATE int cache_seen(Cache *c)
+{
+    long i, j, *old = c->seen, slots = c->slots;
+
+    c->slots = slots ? 2 * slots : CACHEMIN;
+    if ((c->seen = calloc(c->slots, sizeof(long))) == 0) {
+	c->failed = 1;
+	c->seen = old;
+	c->slots = slots;
+	return 0;
+    }
+    for (i = 0; i < slots; i++)
+	if (old[i]) {
+	    for (j = cache_slot(c, c->text + old[i] - 1); c->seen[j];
+		 j = (j + 1) % c->slots)
+		;
+	    c->seen[j] = old[i];
+	}
+    free(old);
+    return 1;
+}
+
+/*
+    cache_text keeps the text s once, and gives its offset.
+*/
+PRIVATE long cache_text(Cache *c, char *s)
+{
+    long i, at = c->used, size = strlen(s) + 1;
+
+    if (c->failed)
+	return 0;
+    if (2 * c->names >= c->slots && !cache_seen(c))
+	return 0;
+    for (i = cache_slot(c, s); c->seen[i]; i = (i + 1) % c->slots)
+	if (!strcmp(c->text + c->seen[i] - 1, s))
+	    return c->seen[i] - 1;
+    if (c->used + size > c->size) {
+	while (c->used + size > c->size)
+	    c->size = c->size ? 2 * c->size : CACHEMIN * (long)sizeof(Token);
+	if ((c->text = realloc(c->text, c->size)) == 0) {
+	    c->failed = 1;
+	    c->used = c->size = 0;
+	    return 0;
+	}
+    }
+    strcpy(c->text + at, s);
+    c->used += size;
+    c->seen[i] = at + 1;
+    c->names++;
+    return at;
+}
+
+PUBLIC void cache_free(Cache *c)
+{
+    free(c->toks);
+    free(c->text);
+    free(c->seen);
+    free(c);
+}
+
+/*
+    cache_check tells whether the symbols that were read are sound: each
+    text lies within the texts, and a name fits in ident and has a hash
+    value within the symbol table.
+*/
+PRIVATE int cache_check(Cache *c)
+{
+    Token *t;
+    long i;
+
+    for (i = 0; i < c->head.count; i++) {
+	t = &c->toks[i];
+	switch (t->sym) {
+	case ATOM:
+	    if (t->hash < 0 || t->hash >= HASHSIZE ||
+		t->u.num < 0 || t->u.num >= c->head.text ||
+		strlen(c->text + t->u.num) >= ALEN)
+		return 0;
+	    break;
+	case STRING_:
+	    if (t->u.num < 0 || t->u.num >= c->head.text)
+		return 0;
+	    break;
+	}
+    }
+    return 1;
+}
+
+/*
+    cache_open delivers the symbols of the file name, or 0 when its side
+    file cannot be used.
+*/
+PUBLIC Cache *cache_open(char *name)
+{
+    Cache *c;
+    Header head;
+    char *file;
+    FILE *fp;
+    long size;
+    int ok = 0;
+
+    if (!cache_key(name, &head) || (file = cache_file(name)) == 0)
+	return 0;
+    fp = fopen(file, "rb");
+    free(file);
+    if (!fp)
+	return 0;
+    if ((c = calloc(1, sizeof(Cache))) != 0 &&
+	fread(&c->head, sizeof(Header), 1, fp) == 1 &&
+	!memcmp(&c->head, &head, offsetof(Header, count)) &&
+	c->head.count >= 0 && c->head.text > 0 &&
+	c->head.count < LONG_MAX / (long)sizeof(Token)) {
+	size = c->head.count * sizeof(Token);
+	if ((c->toks = malloc(size + 1)) != 0 &&
+	    (c->text = malloc(c->head.text)) != 0 &&
+	    fread(c->toks, 1, size, fp) == (size_t)size &&
+	    fread(c->text, 1, c->head.text, fp) == (size_t)c->head.text &&
+	    fgetc(fp) == EOF)
+	    ok = c->text[c->head.text - 1] == '\0' &&
+		 !strcmp(c->text, name) && cache_check(c);
+    }
+    fclose(fp);
+    if (!ok && c) {
+	cache_free(c);
+	c = 0;
+    }
+    return c;
+}
+
+/*
+    cache_next sets the next symbol, and delivers 0 when there are no
+    more.
+*/
+PUBLIC int cache_next(Cache *c)
+{
+    Token *t;
+
+    if (c->pos == c->head.count)
+	return 0;
+    t = &c->toks[c->pos++];
+    switch (symb = t->sym) {
+    case ATOM:
+	strncpy(ident, c->text + t->u.num, ALEN - 1);
+	ident[ALEN - 1] = 0;
+	hashvalue = t->hash;
+	break;
+    case STRING_:
+	numb = (size_t)intern(c->text + t->u.num, 0);
+	break;
+    case FLOAT_:
+	dblf = t->u.dbl;
+	break;
+    case BOOLEAN_:
+    case CHAR_:
+    case INTEGER_:
+	numb = t->u.num;
+	break;
+    }
+    return 1;
+}
+
+/*
+    cache_new starts to keep the symbols of the file name.
+*/
+PUBLIC Cache *cache_new(char *name, int errors)
+{
+    Cache *c;
+
+    if ((c = calloc(1, sizeof(Cache))) == 0)
+	return 0;
+    if (!cache_key(name, &c->head)) {
+	free(c);
+	return 0;
+    }
+    c->errors = errors;
+    cache_text(c, name);
+    return c;
+}
+
+/*
+    cache_add keeps the symbol that getsym has just found.
+*/
+PUBLIC void cache_add(Cache *c)
+{
+    Token *t;
+
+    if (c->failed)
+	return;
+    if (c->head.count == c->room) {
+	c->room = c->room ? 2 * c->room : CACHEMIN;
+	if ((c->toks = realloc(c->toks, c->room * sizeof(Token))) == 0) {
+	    c->failed = 1;
+	    return;
+	}
+    }
+    t = &c->toks[c->head.count++];
+    memset(t, 0, sizeof(Token));
+    switch (t->sym = symb) {
+    case ATOM:
+	t->u.num = cache_text(c, ident);
+	t->hash = hashvalue;
+	break;
+    case STRING_:
+	t->u.num = cache_text(c, (char *)(size_t)numb);
+	break;
+    case FLOAT_:
+	t->u.dbl = dblf;
+	break;
+    case BOOLEAN_:
+    case CHAR_:
+    case INTEGER_:
+	t->u.num = numb;
+	break;
+    case BIGNUM_:
+    case RATIONAL_:
+	c->failed = 1;
+	break;
+    }
+}
+
+PUBLIC void cache_fail(Cache *c)
+{
+    c->failed = 1;
+}
+
+/*
+    cache_end writes the side file of the file that has been read, unless
+    it had an error. It is written to a temporary file first, that takes
+    its place when it is complete.
+*/
+PUBLIC void cache_end(Cache *c, int errors)
+{
+    char *file, *temp;
+    FILE *fp;
+    int ok = 0;
+
+    if (!c->failed && errors == c->errors &&
+	(file = cache_file(c->text)) != 0) {
+	if ((temp = malloc(strlen(file) + 24)) != 0) {
+	    sprintf(temp, "%s.%ld", file, (long)getpid());
+	    if ((fp = fopen(temp, "wb")) != 0) {
+		c->head.text = c->used;
+		ok = fwrite(&c->head, sizeof(Header), 1, fp) == 1 &&
+		     fwrite(c->toks, sizeof(Token), c->head.count, fp) ==
+			(size_t)c->head.count &&
+		     fwrite(c->text, 1, c->used, fp) == (size_t)c->used;
+		if (fclose(fp))
+		    ok = 0;
+#ifdef _WIN32
+		if (ok)
+		    remove(file);
+#endif
+		if (!ok || rename(temp, file))
+		    remove(temp);
+	    }
+	    free(temp);
+	}
+	free(file);
+    }
+    cache_free(c);
+}
+/* END of CACHE.C */
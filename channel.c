@@ -0,0 +1,253 @@
+/* FILE: channel.c */
+/*
+ *  module  : channel.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A channel carries values from one task to another, see task.c, in the
+order in which they were sent. It has room for a fixed number of values:
+send waits while it is full and recv while it is empty, trysend and
+tryrecv do not wait. After close nothing can be sent, and recv fails
+when the values that were sent before have been received.
+
+The channel is a ring of posts, after the bounded queue of D. Vyukov.
+A sender or a receiver claims a post by moving the position of its side
+on with compare and swap, and the sequence number of the post tells
+whether it holds a value: it is twice the position at which the post
+can be filled, plus one when it has been. With the factor two this also
+holds for a channel with room for one value. No lock is taken, unless
+a thread must wait: it then sleeps on the condition of the channel, and
+a thread that sends or receives wakes it. A value is kept as the cells
+that task.c makes of it, outside the node memory of any context.
+
+Without threads, on Windows, nothing can change a channel while a task
+waits for it, and waiting is an error.
+*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#ifdef GC_BDW
+#    define GC_THREADS
+#    include <gc.h>
+#    define malloc GC_malloc
+#endif
+
+typedef struct Post
+  { long seq;					/* 2 * position (+ 1)	*/
+    long size;
+    Cell *cells; } Post;
+
+struct Channel
+  { long size, send, recv;			/* positions		*/
+    int closed, waiting;
+#ifndef _WIN32
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+    Post post[1]; };
+
+#ifdef __GNUC__
+#define LOAD(x)		__atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE(x, v)	__atomic_store_n(&(x), v, __ATOMIC_RELEASE)
+#define CLAIM(x, pos)							\
+    __atomic_compare_exchange_n(&(x), &(pos), (pos) + 1, 0,		\
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define ADD(x, n)	__atomic_add_fetch(&(x), n, __ATOMIC_SEQ_CST)
+#define FENCE		__atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define LOAD(x)		(x)
+#define STORE(x, v)	((x) = (v))
+#define CLAIM(x, pos)	((x) = (pos) + 1, 1)
+#define ADD(x, n)	((x) += (n))
+#define FENCE
+#endif
+
+PUBLIC Channel *chan_new(long size)
+{
+    Channel *c;
+    long i;
+
+    if (size > (long)((LONG_MAX - sizeof(Channel)) / sizeof(Post)))
+	execerror("smaller capacity", "chan");
+    if ((c = malloc(sizeof(Channel) + (size - 1) * sizeof(Post))) == 0)
+	execerror("memory", "chan");
+    c->size = size;
+    c->send = c->recv = 0;
+    c->closed = c->waiting = 0;
+    for (i = 0; i < size; i++) {
+	c->post[i].seq = 2 * i;
+	c->post[i].cells = 0;
+    }
+#ifndef _WIN32
+    pthread_mutex_init(&c->lock, 0);
+    pthread_cond_init(&c->cond, 0);
+#endif
+    return c;
+}
+
+/*
+    chan_put adds the cells to the channel, or delivers 0 when it is full.
+*/
+PRIVATE int chan_put(Channel *c, Cell *cells, long size)
+{
+    Post *p;
+    long pos, dif;
+
+    for (pos = LOAD(c->send);;) {
+	p = &c->post[pos % c->size];
+	if ((dif = LOAD(p->seq) - 2 * pos) == 0) {
+	    if (CLAIM(c->send, pos))
+		break;
+	} else if (dif < 0)
+	    return 0;
+	else
+	    pos = LOAD(c->send);
+    }
+    p->cells = cells;
+    p->size = size;
+    STORE(p->seq, 2 * pos + 1);
+    return 1;
+}
+
+/*
+    chan_take removes the first cells from the channel, or delivers 0 when
+    it is empty.
+*/
+PRIVATE int chan_take(Channel *c, Cell **cells, long *size)
+{
+    Post *p;
+    long pos, dif;
+
+    for (pos = LOAD(c->recv);;) {
+	p = &c->post[pos % c->size];
+	if ((dif = LOAD(p->seq) - (2 * pos + 1)) == 0) {
+	    if (CLAIM(c->recv, pos))
+		break;
+	} else if (dif < 0)
+	    return 0;
+	else
+	    pos = LOAD(c->recv);
+    }
+    *cells = p->cells;
+    *size = p->size;
+    STORE(p->seq, 2 * (pos + c->size));
+    return 1;
+}
+
+/*
+    chan_wake wakes the threads that wait for the channel. A thread that
+    waits first counts itself and then tries again, so either it sees
+    what has been done or it is seen here.
+*/
+PRIVATE void chan_wake(Channel *c)
+{
+#ifndef _WIN32
+    FENCE;
+    if (LOAD(c->waiting)) {
+	pthread_mutex_lock(&c->lock);
+	pthread_cond_broadcast(&c->cond);
+	pthread_mutex_unlock(&c->lock);
+    }
+#endif
+}
+
+/*
+    chan_send sends a copy of the value n, and delivers 1. If the channel
+    is full or closed it delivers 0, or with wait it waits while it is
+    full.
+*/
+PUBLIC int chan_send(Channel *c, Node *n, int wait, char *name)
+{
+    Cell *cells;
+    long size;
+    int ok;
+
+    if (LOAD(c->closed)) {
+	if (wait)
+	    execerror("open channel", name);
+	return 0;
+    }
+    cells = task_cells(n, &size, name);
+    if ((ok = chan_put(c, cells, size)) == 0 && wait) {
+#ifndef _WIN32
+	task_wait(1);
+	pthread_mutex_lock(&c->lock);
+	ADD(c->waiting, 1);
+	FENCE;
+	while ((ok = chan_put(c, cells, size)) == 0 && !LOAD(c->closed))
+	    pthread_cond_wait(&c->cond, &c->lock);
+	ADD(c->waiting, -1);
+	pthread_mutex_unlock(&c->lock);
+	task_wait(0);
+#endif
+	if (!ok) {
+	    task_free(cells);
+	    execerror(LOAD(c->closed) ? "open channel" : "room in channel",
+		      name);
+	}
+    }
+    if (!ok) {
+	task_free(cells);
+	return 0;
+    }
+    chan_wake(c);
+    return 1;
+}
+
+/*
+    chan_recv pushes the first value of the channel and delivers 1. If
+    the channel is empty it delivers 0, or with wait it waits for a value
+    until the channel is closed.
+*/
+PUBLIC int chan_recv(Channel *c, int wait, char *name)
+{
+    Cell *cells;
+    long size;
+    int ok;
+
+    if ((ok = chan_take(c, &cells, &size)) == 0 && wait) {
+#ifndef _WIN32
+	task_wait(1);
+	pthread_mutex_lock(&c->lock);
+	ADD(c->waiting, 1);
+	FENCE;
+	while ((ok = chan_take(c, &cells, &size)) == 0 && !LOAD(c->closed))
+	    pthread_cond_wait(&c->cond, &c->lock);
+	if (!ok)				/* sent before the close */
+	    ok = chan_take(c, &cells, &size);
+	ADD(c->waiting, -1);
+	pthread_mutex_unlock(&c->lock);
+	task_wait(0);
+#endif
+	if (!ok)
+	    execerror(LOAD(c->closed) ? "open channel" : "value in channel",
+		      name);
+    }
+    if (!ok)
+	return 0;
+    chan_wake(c);
+    task_load(cells, size);
+    task_free(cells);
+    return 1;
+}
+
+PUBLIC void chan_close(Channel *c)
+{
+    STORE(c->closed, 1);
+    chan_wake(c);
+}
+
+PUBLIC void chan_write(Channel *c, FILE *stm)
+{
+    fprintf(stm, "chan:%ld", c->size);
+}
+/* END of CHANNEL.C */
@@ -0,0 +1,71 @@
+/* FILE: context.c */
+/*
+ *  module  : context.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A context holds the state of one interpreter, see JoyContext in
+globals.h. joy_context_new makes a context that reads from stdin, and
+joy_context_free disposes of it. A thread runs a context by making it
+joy_context; each thread can run its own, and the definitions that one
+context has read can be used by all of them.
+
+A context has its own stack and, without BDW, its own node memory. The
+definitions are in the memory of the context that read them, below its
+mem_low, and the garbage collector of another context leaves them alone.
+With BDW the collector must see the values in a context, so that it is
+allocated as uncollectable memory.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "globals.h"
+#ifdef GC_BDW
+#include <gc.h>
+#endif
+
+PUBLIC JoyContext *joy_context_new(void)
+{
+    JoyContext *c, *old = joy_context;
+
+    symtab_atfork();
+#ifdef GC_BDW
+    if ((c = GC_malloc_uncollectable(sizeof(JoyContext))) == 0)
+	return 0;
+    memset(c, 0, sizeof(JoyContext));
+#else
+    if ((c = calloc(1, sizeof(JoyContext))) == 0)
+	return 0;
+    c->mem_low = c->memory;
+#endif
+    c->ch = ' ';
+    c->par_depth = -1;
+    joy_context = c;
+    srcfile = stdin;
+    startclock = clock();
+    echoflag = INIECHOFLAG;
+    tracegc = INITRACEGC;
+    autoput = INIAUTOPUT;
+    inilinebuffer(0);
+    inimem1();
+    inimem2();
+    joy_context = old;
+    return c;
+}
+
+PUBLIC void joy_context_free(JoyContext *c)
+{
+    if (joy_context == c)
+	joy_context = 0;
+#ifdef GC_BDW
+    GC_free(c);
+#else
+    free(c->memos);
+    free(c->conses);
+    free(c);
+#endif
+}
+/* END of CONTEXT.C */
@@ -0,0 +1,250 @@
+/* FILE: deque.c */
+/*
+ *  module  : deque.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A deque is a pair of lists: the front, in order from the front, and the
+back, in order from the back. Pushing at either end conses onto one of
+them. When one list is empty and the other has more than one element,
+the other one is split in half, and its far half is reversed onto the
+empty side; so the first and the last element are always at hand and
+both ends take amortized constant time. The lists are never modified,
+so that older deques remain valid. The empty deque is a null pointer.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+typedef struct Dnode {
+    long epoch;					/* of the last forward	*/
+    Node elem;
+    struct Dnode *next;
+} Dnode;
+
+PRIVATE Dnode *deq_cons(Node *x, Dnode *next)
+{
+    Dnode *d;
+
+    if ((d = malloc(sizeof(Dnode))) == 0)
+	execerror("memory", "deque");
+    d->epoch = 0;
+    d->elem.op = x->op;
+    d->elem.u = x->u;
+    d->elem.next = 0;
+    d->next = next;
+    return d;
+}
+
+/*
+    deq_new delivers a deque with the lists given, restoring the balance
+    when one side is empty.
+*/
+PRIVATE Deque *deq_new(Dnode *front, long nfront, Dnode *back, long nback)
+{
+    Deque *q;
+    Dnode *keep, **fill, *d;
+    long i, n, half;
+    int swap;
+
+    if (!nfront && !nback)
+	return 0;
+    if ((swap = nfront == 0 && nback > 1) != 0 || (nback == 0 && nfront > 1)) {
+	d = swap ? back : front;
+	n = swap ? nback : nfront;
+	half = (n + 1) / 2;			/* stays on its side */
+	keep = 0;
+	for (fill = &keep, i = 0; i < half; i++, d = d->next) {
+	    *fill = deq_cons(&d->elem, 0);
+	    fill = &(*fill)->next;
+	}
+	for (front = 0; d; d = d->next)		/* the rest, reversed */
+	    front = deq_cons(&d->elem, front);
+	if (swap) {
+	    back = keep;
+	    nfront = n - half;
+	    nback = half;
+	} else {
+	    back = front;
+	    front = keep;
+	    nfront = half;
+	    nback = n - half;
+	}
+    }
+    if ((q = malloc(sizeof(Deque))) == 0)
+	execerror("memory", "deque");
+    q->epoch = 0;
+    q->front = front;
+    q->nfront = nfront;
+    q->back = back;
+    q->nback = nback;
+    return q;
+}
+
+PUBLIC long deq_size(Deque *q)
+{
+    return q ? q->nfront + q->nback : 0;
+}
+
+/*
+    deq_push adds x at the front when end is 'f', at the back otherwise.
+*/
+PUBLIC Deque *deq_push(Deque *q, Node *x, int end)
+{
+    if (!q)
+	return deq_new(deq_cons(x, 0), 1, 0, 0);
+    if (end == 'f')
+	return deq_new(deq_cons(x, q->front), q->nfront + 1, q->back, q->nback);
+    return deq_new(q->front, q->nfront, deq_cons(x, q->back), q->nback + 1);
+}
+
+/*
+    deq_peek delivers the element at the end given of a non-empty deque.
+*/
+PUBLIC Node *deq_peek(Deque *q, int end)
+{
+    if (end == 'f')
+	return q->front ? &q->front->elem : &q->back->elem;
+    return q->back ? &q->back->elem : &q->front->elem;
+}
+
+PUBLIC Deque *deq_pop(Deque *q, int end)
+{
+    if (end == 'f')
+	return q->front ? deq_new(q->front->next, q->nfront - 1,
+				  q->back, q->nback)
+			: 0;
+    return q->back ? deq_new(q->front, q->nfront, q->back->next, q->nback - 1)
+		   : 0;
+}
+
+PUBLIC Deque *deq_make(Node *n)
+{
+    Dnode *back = 0;
+    long count = 0;
+
+    for (; n; n = n->next, count++)
+	back = deq_cons(n, back);
+    return deq_new(0, 0, back, count);
+}
+
+/*
+    deq_cells delivers the elements in an array, from the front to the
+    back, or 0 for the empty deque. The array must be freed.
+*/
+PRIVATE Node **deq_cells(Deque *q)
+{
+    Node **cell;
+    Dnode *d;
+    long i;
+
+    if (!q)
+	return 0;
+    if ((cell = malloc((q->nfront + q->nback) * sizeof(Node *))) == 0)
+	execerror("memory", "deque");
+    for (i = 0, d = q->front; d; d = d->next)
+	cell[i++] = &d->elem;
+    for (i = q->nfront + q->nback, d = q->back; d; d = d->next)
+	cell[--i] = &d->elem;
+    return cell;
+}
+
+/*
+    deq_list builds the list of the elements, from the front to the back.
+    The elements stay where they are, while the list is allocated.
+*/
+PUBLIC Node *deq_list(Deque *q)
+{
+    Node *n = 0, **cell;
+    long i;
+
+    if ((cell = deq_cells(q)) == 0)
+	return 0;
+    for (i = deq_size(q) - 1; i >= 0; i--)
+	n = newnode(cell[i]->op, cell[i]->u, n);
+    free(cell);
+    return n;
+}
+
+PUBLIC int deq_equal(Deque *a, Deque *b)
+{
+    Node **x, **y;
+    long i;
+    int ok = 1;
+
+    if (a == b)
+	return 1;
+    if (deq_size(a) != deq_size(b))
+	return 0;
+    x = deq_cells(a);
+    y = deq_cells(b);
+    for (i = 0; ok && i < deq_size(a); i++)
+	ok = equal_aux(x[i], y[i]);
+    free(x);
+    free(y);
+    return ok;
+}
+
+PUBLIC unsigned long deq_hash(Deque *q)
+{
+    Node **cell;
+    unsigned long h = 13;
+    long i;
+
+    if ((cell = deq_cells(q)) == 0)
+	return h;
+    for (i = 0; i < deq_size(q); i++)
+	h = h * 31 + dict_hash(cell[i]);
+    free(cell);
+    return h;
+}
+
+PUBLIC void deq_write(Deque *q, FILE *stm)
+{
+    Node **cell;
+    long i;
+
+    fprintf(stm, "deque:[");
+    if ((cell = deq_cells(q)) != 0) {
+	for (i = 0; i < deq_size(q); i++) {
+	    if (i)
+		fprintf(stm, " ");
+	    writefactor(cell[i], stm);
+	}
+	free(cell);
+    }
+    fprintf(stm, "]");
+}
+
+#ifndef GC_BDW
+/*
+    deq_forward updates the elements after they have been copied by the
+    garbage collector. Lists share their tails, so a list is followed
+    until a cell that has been visited in the same collection.
+*/
+PUBLIC void deq_forward(Deque *q, long epoch)
+{
+    Dnode *d;
+
+    if (!q || q->epoch == epoch)
+	return;
+    q->epoch = epoch;
+    for (d = q->front; d && d->epoch != epoch; d = d->next) {
+	d->epoch = epoch;
+	forward(d->elem.op, &d->elem.u);
+    }
+    for (d = q->back; d && d->epoch != epoch; d = d->next) {
+	d->epoch = epoch;
+	forward(d->elem.op, &d->elem.u);
+    }
+}
+#endif
+/* END of DEQUE.C */
@@ -0,0 +1,412 @@
+/* FILE: dict.c */
+/*
+ *  module  : dict.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A dictionary is a hash array mapped trie. Each level consumes HASHSTEP
+bits of the hash of a key; a trie node holds a bitmap of the slots in
+use, followed by the slots themselves, each being either a key/value
+pair or a subtrie. When all bits are consumed, colliding keys are kept
+in a plain array. Keys are equal when equal_aux says so and dict_hash
+is consistent with that. Tries are never modified: an update copies the
+path from the root to the slot and shares everything else, so that the
+old dictionary remains valid. The empty dictionary is a null pointer.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#endif
+
+#define HASHSTEP	5
+#define HASHBITS	30
+#define SLOTBIT(h, s)	(1UL << (((h) >> (s)) & ((1 << HASHSTEP) - 1)))
+#define SLOTPOS(d, b)	((int)POPCOUNT((Setword)((d)->bitmap & ((b) - 1))))
+
+PRIVATE unsigned long mix(unsigned long h)
+{
+    h ^= h >> 16;
+    h *= 0x45d9f3bUL;
+    h ^= h >> 16;
+    return h;
+}
+
+PRIVATE unsigned long hash_trie(Dict *d)	/* independent of order */
+{
+    unsigned long h = 0;
+    int i;
+
+    for (i = 0; d && i < d->size; i++)
+	if (d->slot[i].sub)
+	    h += hash_trie(d->slot[i].sub);
+	else
+	    h += mix(d->slot[i].hash * 31 + dict_hash(&d->slot[i].val));
+    return h;
+}
+
+/*
+    hash_number hashes a number by its value as a double, the form in
+    which numbers of different types are compared.
+*/
+PRIVATE unsigned long hash_number(double d)
+{
+    unsigned long h;
+    long i;
+
+    if (d > LONG_MIN && d < LONG_MAX && d == (long)d)
+	return mix((unsigned long)(long)d);
+    for (h = 0, i = 0; i < (long)sizeof(double); i++)
+	h = h * 31 + ((unsigned char *)&d)[i];
+    return mix(h);
+}
+
+/*
+    dict_hash delivers the same hash for values that equal_aux finds
+    equal: numbers by their value, strings, symbols and operators by
+    their name, sets by their members and aggregates by their contents.
+*/
+PUBLIC unsigned long dict_hash(Node *n)
+{
+    unsigned long h;
+    Node *key, *val;
+    long i;
+
+    switch (n->op) {
+    case BOOLEAN_:
+    case CHAR_:
+    case INTEGER_:
+	return hash_number((double)n->u.num);
+    case BIGNUM_:
+	return hash_number(num_double(n));
+    case RATIONAL_:
+	return hash_number(rat_double(n));
+    case FLOAT_:
+	return hash_number(n->u.dbl);
+    case SET_:
+    case BIGSET_:
+	for (h = 17, i = set_next(n, 0); i >= 0; i = set_next(n, i + 1))
+	    h = h * 31 + i;
+	return mix(h);
+    case LIST_:
+	for (h = 7, n = n->u.lis; n; n = n->next)
+	    h = h * 31 + dict_hash(n);
+	return mix(h);
+    case DICT_:
+	return mix(hash_trie(n->u.dict));
+    case VECTOR_:
+	for (h = 11, i = 0; i < vec_size(n->u.vec); i++)
+	    h = h * 31 + dict_hash(vec_at(n->u.vec, i));
+	return mix(h);
+    case DEQUE_:
+	return mix(deq_hash(n->u.deq));
+    case HEAP_:
+	return mix((unsigned long)(size_t)n->u.heap);
+    case STREAM_:
+	return mix((unsigned long)(size_t)n->u.stream);
+    case RANGE_:
+	return mix(rng_hash(n->u.rng));
+    case CHANNEL_:
+	return mix((unsigned long)(size_t)n->u.chan);
+    case ORDSET_:
+    case ORDMAP_:
+	for (h = n->op, i = 0; (key = ord_nth(n->u.ord, i, &val)) != 0; i++) {
+	    h = h * 31 + dict_hash(key);
+	    if (n->op == ORDMAP_)
+		h = h * 31 + dict_hash(val);
+	}
+	return mix(h);
+    case FILE_:
+	return mix((unsigned long)(size_t)n->u.fil);
+    case ANON_FUNCT_:
+	return mix((unsigned long)(size_t)n->u.proc);
+    case STRING_:
+	return str_hash(n->u.str);
+    case USR_:
+	return n->u.ent->hash;
+    default:
+	return symtab[n->op].hash;		/* the entry of the operator */
+    }
+}
+
+PRIVATE Dict *alloc_dict(int size)
+{
+    Dict *d;
+
+    if ((d = malloc(sizeof(Dict) + (size - 1) * sizeof(Slot))) == 0)
+	execerror("memory", "dict");
+    memset(d, 0, sizeof(Dict) + (size - 1) * sizeof(Slot));
+    d->size = size;
+    return d;
+}
+
+/*
+    clone copies a trie node, leaving a gap of one slot at position pos
+    when grow is set, or removing the slot at position pos when it is not.
+*/
+PRIVATE Dict *clone(Dict *d, int pos, int grow)
+{
+    Dict *n;
+    int size;
+
+    size = d->size + (grow > 0) - (grow < 0);
+    n = alloc_dict(size);
+    n->count = d->count;
+    n->bitmap = d->bitmap;
+    if (grow > 0) {
+	memcpy(n->slot, d->slot, pos * sizeof(Slot));
+	memcpy(n->slot + pos + 1, d->slot + pos, (d->size - pos) * sizeof(Slot));
+    } else if (grow < 0) {
+	memcpy(n->slot, d->slot, pos * sizeof(Slot));
+	memcpy(n->slot + pos, d->slot + pos + 1,
+	       (d->size - pos - 1) * sizeof(Slot));
+    } else
+	memcpy(n->slot, d->slot, d->size * sizeof(Slot));
+    return n;
+}
+
+PRIVATE void set_slot(Slot *s, unsigned long hash, Node *key, Node *val)
+{
+    s->hash = hash;
+    s->key.op = key->op;
+    s->key.u = key->u;
+    s->key.next = 0;
+    s->val.op = val->op;
+    s->val.u = val->u;
+    s->val.next = 0;
+    s->sub = 0;
+}
+
+PRIVATE Dict *insert(Dict *d, int shift, unsigned long hash,
+		     Node *key, Node *val, int *added)
+{
+    Dict *n, *sub;
+    unsigned long bit;
+    int i;
+
+    if (!d) {
+	d = alloc_dict(1);
+	d->count = 1;
+	if (shift < HASHBITS)
+	    d->bitmap = SLOTBIT(hash, shift);
+	set_slot(&d->slot[0], hash, key, val);
+	*added = 1;
+	return d;
+    }
+    if (shift >= HASHBITS) {			/* collisions */
+	for (i = 0; i < d->size; i++)
+	    if (equal_aux(&d->slot[i].key, key)) {
+		n = clone(d, i, 0);
+		set_slot(&n->slot[i], hash, key, val);
+		return n;
+	    }
+	n = clone(d, d->size, 1);
+	set_slot(&n->slot[d->size], hash, key, val);
+	n->count++;
+	*added = 1;
+	return n;
+    }
+    bit = SLOTBIT(hash, shift);
+    i = SLOTPOS(d, bit);
+    if (!(d->bitmap & bit)) {
+	n = clone(d, i, 1);
+	n->bitmap |= bit;
+	set_slot(&n->slot[i], hash, key, val);
+	n->count++;
+	*added = 1;
+	return n;
+    }
+    if (d->slot[i].sub)
+	sub = insert(d->slot[i].sub, shift + HASHSTEP, hash, key, val, added);
+    else if (d->slot[i].hash == hash && equal_aux(&d->slot[i].key, key)) {
+	n = clone(d, i, 0);
+	set_slot(&n->slot[i], hash, key, val);
+	return n;
+    } else {
+	sub = insert(0, shift + HASHSTEP, d->slot[i].hash,
+		     &d->slot[i].key, &d->slot[i].val, added);
+	sub = insert(sub, shift + HASHSTEP, hash, key, val, added);
+    }
+    n = clone(d, i, 0);
+    n->slot[i].sub = sub;
+    n->count += *added;
+    return n;
+}
+
+PRIVATE Dict *delete(Dict *d, int shift, unsigned long hash,
+		     Node *key, int *removed)
+{
+    Dict *n, *sub;
+    unsigned long bit;
+    int i;
+
+    if (shift >= HASHBITS) {			/* collisions */
+	for (i = 0; i < d->size; i++)
+	    if (equal_aux(&d->slot[i].key, key))
+		break;
+	if (i == d->size)
+	    return d;
+	*removed = 1;
+	if (d->size == 1)
+	    return 0;
+	n = clone(d, i, -1);
+	n->count--;
+	return n;
+    }
+    bit = SLOTBIT(hash, shift);
+    if (!(d->bitmap & bit))
+	return d;
+    i = SLOTPOS(d, bit);
+    if (!d->slot[i].sub) {
+	if (d->slot[i].hash != hash || !equal_aux(&d->slot[i].key, key))
+	    return d;
+	*removed = 1;
+	if (d->size == 1)
+	    return 0;
+	n = clone(d, i, -1);
+	n->bitmap &= ~bit;
+	n->count--;
+	return n;
+    }
+    sub = delete(d->slot[i].sub, shift + HASHSTEP, hash, key, removed);
+    if (!*removed)
+	return d;
+    if (!sub && d->size == 1)
+	return 0;
+    if (!sub) {
+	n = clone(d, i, -1);
+	n->bitmap &= ~bit;
+    } else {
+	n = clone(d, i, 0);
+	if (sub->count == 1 && !sub->slot[0].sub)
+	    n->slot[i] = sub->slot[0];		/* pull the pair up */
+	else
+	    n->slot[i].sub = sub;
+    }
+    n->count--;
+    return n;
+}
+
+PUBLIC Node *dict_get(Dict *d, Node *key)
+{
+    unsigned long hash, bit;
+    int i, shift;
+
+    hash = dict_hash(key);
+    for (shift = 0; d; shift += HASHSTEP) {
+	if (shift >= HASHBITS) {
+	    for (i = 0; i < d->size; i++)
+		if (equal_aux(&d->slot[i].key, key))
+		    return &d->slot[i].val;
+	    return 0;
+	}
+	bit = SLOTBIT(hash, shift);
+	if (!(d->bitmap & bit))
+	    return 0;
+	i = SLOTPOS(d, bit);
+	if (!d->slot[i].sub)
+	    return d->slot[i].hash == hash &&
+		   equal_aux(&d->slot[i].key, key) ? &d->slot[i].val : 0;
+	d = d->slot[i].sub;
+    }
+    return 0;
+}
+
+PUBLIC Dict *dict_put(Dict *d, Node *key, Node *val)
+{
+    int added = 0;
+
+    return insert(d, 0, dict_hash(key), key, val, &added);
+}
+
+PUBLIC Dict *dict_del(Dict *d, Node *key)
+{
+    int removed = 0;
+
+    return d ? delete(d, 0, dict_hash(key), key, &removed) : 0;
+}
+
+/*
+    dict_nth locates the i-th pair in the order of the trie, skipping
+    subtries by their count. The pair stays where it is, because tries
+    are not moved by the garbage collector.
+*/
+PUBLIC Node *dict_nth(Dict *d, long i, Node **val)
+{
+    int j;
+
+    while (d && i >= 0 && i < d->count) {
+	for (j = 0; j < d->size; j++)
+	    if (d->slot[j].sub) {
+		if (i < d->slot[j].sub->count)
+		    break;
+		i -= d->slot[j].sub->count;
+	    } else if (i-- == 0) {
+		*val = &d->slot[j].val;
+		return &d->slot[j].key;
+	    }
+	if (j == d->size)
+	    return 0;
+	d = d->slot[j].sub;
+    }
+    return 0;
+}
+
+/*
+    dict_pair builds the list [key val]; key and val must not be moved
+    by the garbage collector, which is the case for pairs in a trie.
+*/
+PUBLIC Node *dict_pair(Node *key, Node *val)
+{
+    Node *n;
+
+    n = newnode(val->op, val->u, 0);
+    return newnode(key->op, key->u, n);
+}
+
+PUBLIC int dict_equal(Dict *a, Dict *b)
+{
+    Node *key, *val = 0, *other;
+    long i;
+
+    if (a == b)
+	return 1;
+    if (!a || !b || a->count != b->count)
+	return 0;
+    for (i = 0; i < a->count; i++) {
+	key = dict_nth(a, i, &val);
+	if ((other = dict_get(b, key)) == 0 || !equal_aux(val, other))
+	    return 0;
+    }
+    return 1;
+}
+
+#ifndef GC_BDW
+/*
+    dict_forward updates the values in a trie after they have been
+    copied by the garbage collector. Tries are shared, so each trie
+    node is visited only once per collection.
+*/
+PUBLIC void dict_forward(Dict *d, long epoch)
+{
+    int i;
+
+    if (!d || d->epoch == epoch)
+	return;
+    d->epoch = epoch;
+    for (i = 0; i < d->size; i++)
+	if (d->slot[i].sub)
+	    dict_forward(d->slot[i].sub, epoch);
+	else {
+	    forward(d->slot[i].key.op, &d->slot[i].key.u);
+	    forward(d->slot[i].val.op, &d->slot[i].val.u);
+	}
+}
+#endif
+/* END of DICT.C */
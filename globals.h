@@ -7,7 +7,11 @@
 #ifndef GLOBALS_H
 #define GLOBALS_H
 
+/*
+    Integers are 64 bits. Define BIT_32 for 32 bit integers and sets,
+    for compilers that do not know long long.
 #define BIT_32
+*/
 
 #ifdef _MSC_VER
 #pragma warning( disable : 4267 )
@@ -165,6 +169,29 @@ CHECK_END_SYMBOL
 #else
 #define SETSIZE		64
 #define MAXINT		9223372036854775807LL
+#endif
+#define BIGSETMAX	1048576	/* members of big sets		*/
+#define MEMOARGS	8	/* arguments of memoized programs */
+#ifdef __GNUC__
+#ifdef BIT_32
+#define POPCOUNT(x)	__builtin_popcountl(x)
+#define CTZ(x)		__builtin_ctzl(x)
+#else
+#define POPCOUNT(x)	__builtin_popcountll(x)
+#define CTZ(x)		__builtin_ctzll(x)
+#endif
+#define OVERFLOW(a,b,op,r)	__builtin_##op##_overflow(a,b,r)
+#else
+#define POPCOUNT(x)	popcount(x)
+#define CTZ(x)		ctz(x)
+#define OVERFLOW(a,b,op,r)	num_overflow(a,b,#op[0],r)
+#endif
+/* vector loops are also compiled for AVX2, chosen at load time */
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 6 &&	\
+    defined(__x86_64__) && defined(__linux__)
+#define KERNEL		__attribute__((target_clones("avx2", "default")))
+#else
+#define KERNEL
 #endif
 				/* symbols from getsym		*/
 #define ILLEGAL_	0
@@ -179,9 +206,23 @@ CHECK_END_SYMBOL
 #define LIST_		9
 #define FLOAT_		10
 #define FILE_		11
-#define FALSE_		12
-#define TRUE_		13
-#define MAXINT_		14
+#define BIGSET_		12
+#define DICT_		13
+#define BIGNUM_		14
+#define RATIONAL_	15
+#define FLOATARRAY_	16
+#define INTARRAY_	17
+#define VECTOR_		18
+#define DEQUE_		19
+#define HEAP_		20
+#define ORDSET_		21
+#define ORDMAP_		22
+#define STREAM_		23
+#define RANGE_		24
+#define CHANNEL_	25
+#define FALSE_		26
+#define TRUE_		27
+#define MAXINT_		28
 #define LBRACK		900
 #define LBRACE		901
 #define LPAREN		902
@@ -218,6 +259,16 @@ typedef int Symbol;
 
 typedef short Operator;
 
+#ifdef BIT_32
+typedef long Num;
+typedef unsigned long Setword;
+typedef unsigned short Limb;
+#else
+typedef long long Num;
+typedef unsigned long long Setword;
+typedef unsigned int Limb;
+#endif
+
 typedef union
 #ifdef BIT_32
       { long num;
@@ -231,6 +282,19 @@ typedef union
 	FILE *fil;
 	struct Node *lis;
 	struct Entry *ent;
+	struct Bigset *big;
+	struct Dict *dict;
+	struct Bignum *bnum;
+	struct Rational *rat;
+	struct Farray *farr;
+	struct Iarray *iarr;
+	struct Vector *vec;
+	struct Deque *deq;
+	struct Heap *heap;
+	struct Otree *ord;
+	struct Stream *stream;
+	struct Range *rng;
+	struct Channel *chan;
 	void (*proc)(); } Types;
 
 typedef struct Node
@@ -239,7 +303,9 @@ typedef struct Node
     struct Node *next; } Node;
 
 typedef struct Entry
-  { char *name;
+  { char *name;					/* interned		*/
+    unsigned long hash;
+    int memo;					/* 1 + args, if memoized */
 #if defined(NO_HELP_LOCAL_SYMBOLS) || defined(USE_UNKNOWN_SYMBOLS) || defined(TRACK_USED_SYMBOLS)
     unsigned char is_module;
 #else
@@ -260,33 +326,188 @@ typedef struct Entry
 	void  (*proc) (); } u;
     struct Entry *next; } Entry;
 
+typedef struct Bigset				/* sets beyond SETSIZE	*/
+  { long size;
+    Setword bits[1]; } Bigset;
+
+typedef struct Bignum				/* integers beyond maxint */
+  { long size;					/* negative if negative */
+    Limb digit[1]; } Bignum;
+
+typedef struct Rational				/* fractions in lowest terms */
+  { struct Node num, den; } Rational;
+
+typedef struct Farray				/* packed floats	*/
+  { long size, rows;				/* rows of a matrix	*/
+    double dbl[1]; } Farray;
+
+typedef struct Iarray				/* packed integers	*/
+  { long size;
+    Num num[1]; } Iarray;
+
+typedef struct Slot				/* entry or subtrie	*/
+  { unsigned long hash;
+    Node key, val;
+    struct Dict *sub; } Slot;
+
+typedef struct Dict				/* hash array mapped trie */
+  { long epoch, count;
+    unsigned long bitmap;
+    int size;
+    Slot slot[1]; } Dict;
+
+typedef struct Vector				/* persistent vector	*/
+  { long count, epoch;
+    int shift;					/* of the root		*/
+    struct Vnode *root, *tail; } Vector;
+
+typedef struct Deque				/* double ended queue	*/
+  { long epoch, nfront, nback;
+    struct Dnode *front, *back; } Deque;
+
+typedef struct Heap				/* priority queue	*/
+  { long count, epoch;
+    struct Node order;				/* quotation, or []	*/
+    struct Hnode *root; } Heap;
+
+typedef struct Otree				/* weight balanced tree */
+  { long epoch, size;
+    struct Node key, val;			/* no val in a set	*/
+    struct Otree *left, *right; } Otree;
+
+typedef struct Stream				/* lazy list, see stream.c */
+  { long epoch;
+    int kind;					/* how the rest is made	*/
+    struct Node head, state, prog, test;
+    struct Stream *src, *src2; } Stream;
+
+typedef struct Range				/* lo, lo + by, .. to hi */
+  { long lo, hi, by;
+    Operator type; } Range;			/* INTEGER_ or CHAR_	*/
+
+typedef struct Channel Channel;			/* see channel.c	*/
+
+typedef struct Cache Cache;			/* see cache.c		*/
+
+typedef struct Cell				/* a value, see task.c	*/
+  { Types u;					/* number of a list	*/
+    Operator op; } Cell;
+
+/*
+    All the state of one interpreter is in a JoyContext, and joy_context
+    is the one that the current thread runs. The names below stand for
+    its fields, so that the primitives reach it without passing it on.
+    Several contexts can run at the same time, one per thread. They share
+    the symbol table, with the definitions, and the interned names. Any
+    context adds to these when it reads a program, or runs intern: main.c
+    and intern.c take a lock for that. A definition, though, is changed
+    without one, so that reading definitions must be done by one context
+    at a time. The remaining fields are private to a module and named by
+    that module.
+*/
+#include <setjmp.h>
+#include "joy.h"
+
+#ifdef _MSC_VER
+#    define THREAD	__declspec(thread)
+#else
+#    define THREAD	__thread
+#endif
+
+#define MEMOPURE	64	/* programs found pure		*/
+#define PARMAX		64	/* workers			*/
+
+struct JoyContext
+  { FILE *srcfile;
+    int g_argc;
+    char **g_argv;
+    int echoflag, autoput, undeferror, tracegc;
+    int startclock, gc_clock;			/* main		*/
+    jmp_buf begin;
+    int embedded, running, status;		/* libjoy	*/
+    char errmsg[INPLINEMAX];
+    char errmess[INPLINEMAX / 2], errop[INPLINEMAX / 2];	/* execerror */
+    Symbol symb;				/* getsym	*/
+#ifdef BIT_32
+    long numb;
+#else
+    long long numb;
+#endif
+    Types bignumb;			/* BIGNUM_ or RATIONAL_ from getsym */
+    double dblf;
+    char ident[ALEN];
+    int hashvalue;
+    Types bucket;				/* used by NEWNODE defines */
+    int display_enter, display_lookup;
+    struct Entry *display[DISPLAYMAX], *location;
+    struct { FILE *fp; char *name; int linenum;	/* scan	*/
+	     struct Cache *cache; int started, replay; } infile[INPSTACKMAX];
+    struct Cache *tokrec, *tokend;		/* keeps the symbol	*/
+    int ilevel, linenumber, linelength, currentcolumn, errorcount, ch;
+    char linbuf[INPLINEMAX + 1], *srctext;	/* srcfile 0: joy_eval */
+    Node *stk;					/* dynamic memory	*/
+#ifndef SINGLE
+    Node *prog, *conts, *dump, *dump1, *dump2, *dump3, *dump4, *dump5;
+    long gc_epoch;				/* collections so far */
+#endif
+#ifndef GC_BDW
+    Node memory[MEMORYMAX], *memoryindex, *mem_low, *mem_mid;	/* utils */
+    int direction, nodesinspected, nodescopied, start_gc_clock;
+#endif
+    struct Memo *memos;				/* memo		*/
+    long memo_count, memo_hits, memo_misses, memo_evictions;
+    struct { unsigned long id; long epoch; Node prog; }
+	memo_pure[MEMOPURE];			/* see memo.c	*/
+    Node **conses;				/* hashcons	*/
+    long cons_count, cons_epoch;
+    Heap *heap_current;				/* interp	*/
+    char *sort_name;
+    Node *sort_program, **sort_cells;
+    long sort_count, sort_epoch;
+    Node *par_vals, *par_walk;			/* parallel	*/
+    int par_depth;
+    long par_pid[PARMAX];
+    FILE *par_fp[PARMAX], *par_out; };
+
 #ifdef ALLOC
 #    define CLASS
 #else
 #    define CLASS extern
 #endif
 
-CLASS FILE *srcfile;
-CLASS int g_argc;
-CLASS char **g_argv;
-CLASS int echoflag;
-CLASS int autoput;
-CLASS int undeferror;
-CLASS int tracegc;
-CLASS int startclock,gc_clock;			/* main		*/
-/* CLASS int ch; */				/* scanner	*/
-CLASS Symbol symb;
-#ifdef BIT_32
-CLASS long numb;
-#else
-CLASS long long numb;
+CLASS THREAD JoyContext *joy_context;
+
+#define srcfile		(joy_context->srcfile)
+#define g_argc		(joy_context->g_argc)
+#define g_argv		(joy_context->g_argv)
+#define echoflag	(joy_context->echoflag)
+#define autoput		(joy_context->autoput)
+#define undeferror	(joy_context->undeferror)
+#define tracegc		(joy_context->tracegc)
+#define startclock	(joy_context->startclock)
+#define gc_clock	(joy_context->gc_clock)
+#define symb		(joy_context->symb)
+#define numb		(joy_context->numb)
+#define bignumb		(joy_context->bignumb)
+#define dblf		(joy_context->dblf)
+#define ident		(joy_context->ident)
+#define hashvalue	(joy_context->hashvalue)
+#define bucket		(joy_context->bucket)
+#define display_enter	(joy_context->display_enter)
+#define display_lookup	(joy_context->display_lookup)
+#define display		(joy_context->display)
+#define location	(joy_context->location)
+#define stk		(joy_context->stk)
+#ifndef SINGLE
+#define conts		(joy_context->conts)
+#define dump		(joy_context->dump)
+#define dump1		(joy_context->dump1)
+#define dump2		(joy_context->dump2)
+#define dump3		(joy_context->dump3)
+#define dump4		(joy_context->dump4)
+#define dump5		(joy_context->dump5)
+#define gc_epoch	(joy_context->gc_epoch)
 #endif
-CLASS double dblf;
-CLASS char ident[ALEN];
-CLASS int hashvalue;
-CLASS Types bucket;				/* used by NEWNODE defines */
-CLASS int display_enter;
-CLASS int display_lookup;
 
 CLASS Entry					/* symbol table	*/
     symtab[SYMTABMAX],
@@ -295,25 +516,13 @@ CLASS Entry					/* symbol table	*/
     *localentry,
 #endif
     *symtabindex,
-    *display[DISPLAYMAX],
-    *firstlibra,				/* inioptable	*/
-    *location;					/* getsym	*/
+    *firstlibra;				/* inioptable	*/
+
+CLASS char *cachedir;				/* joy --cache */
 
 #define LOC2INT(e) (((size_t)e - (size_t)symtab) / sizeof(Entry))
 #define INT2LOC(x) ((Entry*) ((x + (size_t)symtab)) * sizeof(Entry))
 
-CLASS Node				/* dynamic memory	*/
-/*
-    memory[MEMORYMAX],
-    *memoryindex,
-*/
-#ifdef SINGLE
-    *stk;
-#else
-    *prog, *stk, *conts,
-    *dump, *dump1, *dump2, *dump3, *dump4, *dump5;
-#endif
-
 #define MEM2INT(n) (((size_t)n - (size_t)memory) / sizeof(Node))
 #define INT2MEM(x) ((Node*) ((x + (size_t)&memory) * sizeof(Node)))
 
@@ -340,14 +549,17 @@ PUBLIC void exeterm(Node *n);
 PUBLIC void inisymboltable(void)		/* initialise		*/;
 PUBLIC char *opername(int o);
 PUBLIC void lookup(void);
+PUBLIC void symtab_atfork(void);
 PUBLIC void abortexecution_(void);
 PUBLIC void execerror(char *message, char *op);
 PUBLIC void quit_(void);
+PUBLIC void readeval(void);
 PUBLIC void inilinebuffer(char *filnam);
 /* PUBLIC void putline(void); */
 /* PUBLIC int endofbuffer(void); */
 PUBLIC void error(char *message);
 PUBLIC int doinclude(char *filnam);
+PUBLIC void endinclude(int done);
 PUBLIC void getsym(void);
 PUBLIC void inimem1(void);
 PUBLIC void inimem2(void);
@@ -365,6 +577,175 @@ PUBLIC void redirect(FILE *);
 #endif
 
 PUBLIC void HashValue(char *str);
+#ifndef __GNUC__
+PUBLIC int popcount(Setword w);
+PUBLIC int ctz(Setword w);
+#endif
+PUBLIC Bigset *set_add(Bigset *b, long i);
+PUBLIC Operator set_make(Bigset *b, Types *u);
+PUBLIC long set_next(Node *n, long i);
+PUBLIC long set_nth(Node *n, long k);
+PUBLIC long set_size(Node *n);
+PUBLIC int set_member(Node *n, long i);
+PUBLIC int set_subset(Node *a, Node *b);
+PUBLIC int set_compare(Node *a, Node *b);
+PUBLIC Operator set_insert(Node *n, long i, Types *u);
+PUBLIC Operator set_remove(Node *n, long i, Types *u);
+PUBLIC Operator set_range(Node *n, long lo, long hi, Types *u);
+PUBLIC Operator set_binop(Node *a, Node *b, int oper, Types *u);
+PUBLIC Operator set_not(Node *n, Types *u);
+PUBLIC long equal_aux(Node *n1, Node *n2);
+PUBLIC unsigned long dict_hash(Node *n);
+PUBLIC Node *dict_get(Dict *d, Node *key);
+PUBLIC Dict *dict_put(Dict *d, Node *key, Node *val);
+PUBLIC Dict *dict_del(Dict *d, Node *key);
+PUBLIC Node *dict_nth(Dict *d, long i, Node **val);
+PUBLIC Node *dict_pair(Node *key, Node *val);
+PUBLIC int dict_equal(Dict *a, Dict *b);
+PUBLIC int num_overflow(Num a, Num b, int oper, Num *r);
+PUBLIC Operator num_add(Node *a, Node *b, int oper, Types *u);
+PUBLIC Operator num_mul(Node *a, Node *b, Types *u);
+PUBLIC Operator num_div(Node *a, Node *b, Types *q, Operator *rop, Types *r);
+PUBLIC Operator num_gcd(Node *a, Node *b, Types *u);
+PUBLIC Operator num_neg(Node *a, Types *u);
+PUBLIC Operator num_abs(Node *a, Types *u);
+PUBLIC Operator num_pow(Node *a, long e, Types *u);
+PUBLIC int num_compare(Node *a, Node *b);
+PUBLIC double num_double(Node *a);
+PUBLIC char *num_string(Node *a);
+PUBLIC void num_write(Node *a, FILE *stm);
+PUBLIC Operator num_parse(char *s, Types *u);
+PUBLIC Operator rat_make(Node *num, Node *den, Types *u);
+PUBLIC Operator rat_arith(Node *a, Node *b, int oper, Types *u);
+PUBLIC Operator rat_neg(Node *a, Types *u);
+PUBLIC int rat_sign(Node *a);
+PUBLIC Operator rat_round(Node *a, int mode, Types *u);
+PUBLIC int rat_compare(Node *a, Node *b);
+PUBLIC double rat_double(Node *a);
+PUBLIC Operator rat_parse(char *num, char *den, Types *u);
+PUBLIC char *rat_string(Node *a);
+PUBLIC void rat_write(Node *a, FILE *stm);
+PUBLIC Operator arr_pack(Node *n, Operator op, Types *u, char *name);
+PUBLIC Node *arr_unpack(Node *n);
+PUBLIC long arr_size(Node *n);
+PUBLIC void arr_at(Node *n, long i, Node *result);
+PUBLIC int arr_equal(Node *a, Node *b);
+PUBLIC Operator arr_arith(Node *a, Node *b, int oper, Types *u, char *name);
+PUBLIC Operator arr_dot(Node *a, Node *b, Types *u, char *name);
+PUBLIC Operator arr_reduce(Node *a, int oper, Types *u, char *name);
+PUBLIC void arr_write(Node *n, FILE *stm);
+PUBLIC Farray *arr_new(long rows, long cols);
+PUBLIC Node *mat_cells(long rows, long cols);
+PUBLIC Operator mat_mul(Node *a, Node *b, Types *u, char *name);
+PUBLIC Operator mat_add(Node *a, Node *b, Types *u, char *name);
+PUBLIC Operator mat_scale(Node *a, Node *s, Types *u, char *name);
+PUBLIC Operator mat_transpose(Node *a, Types *u, char *name);
+PUBLIC Operator mat_pack(Node *a, Types *u, char *name);
+PUBLIC Node *mat_unpack(Node *a, char *name);
+PUBLIC unsigned long str_hash(char *s);
+PUBLIC char *intern(char *s, unsigned long *hash);
+PUBLIC char *intern_static(char *s, unsigned long *hash);
+PUBLIC void intern_prepare(void);
+PUBLIC void intern_release(void);
+PUBLIC Node *hash_cons(Node *n);
+PUBLIC long vec_size(Vector *v);
+PUBLIC Node *vec_at(Vector *v, long i);
+PUBLIC Vector *vec_push(Vector *v, Node *x);
+PUBLIC Vector *vec_assign(Vector *v, long i, Node *x);
+PUBLIC Vector *vec_make(Node *n);
+PUBLIC Node *vec_list(Vector *v);
+PUBLIC int vec_equal(Vector *a, Vector *b);
+PUBLIC long deq_size(Deque *q);
+PUBLIC Deque *deq_push(Deque *q, Node *x, int end);
+PUBLIC Node *deq_peek(Deque *q, int end);
+PUBLIC Deque *deq_pop(Deque *q, int end);
+PUBLIC Deque *deq_make(Node *n);
+PUBLIC Node *deq_list(Deque *q);
+PUBLIC int deq_equal(Deque *a, Deque *b);
+PUBLIC unsigned long deq_hash(Deque *q);
+PUBLIC void deq_write(Deque *q, FILE *stm);
+PUBLIC Heap *heap_new(Node *order);
+PUBLIC Heap *heap_single(Heap *h, Node *x);
+PUBLIC Heap *heap_boxes(Heap *h, Node *list);
+PUBLIC Heap *heap_build(Heap *h, int (*less)(Node *, Node *));
+PUBLIC Heap *heap_merge(Heap *a, Heap *b, int (*less)(Node *, Node *));
+PUBLIC Node *heap_top(Heap *h);
+PUBLIC Heap *heap_pop(Heap *h, int (*less)(Node *, Node *));
+PUBLIC double Compare(Node *first, Node *second, int *error);
+PUBLIC Otree *ord_insert(Otree *t, Node *key, Node *val, char *name);
+PUBLIC Otree *ord_delete(Otree *t, Node *key, char *name);
+PUBLIC Otree *ord_find(Otree *t, Node *key, char *name);
+PUBLIC Node *ord_nth(Otree *t, long i, Node **val);
+PUBLIC Otree *ord_make(Node *n, int pairs, char *name);
+PUBLIC Node *ord_list(Otree *t);
+PUBLIC Otree *ord_combine(Otree *a, Otree *b, int oper, char *name);
+PUBLIC int ord_equal(Otree *a, Otree *b, int pairs);
+PUBLIC Stream *str_new(int kind, Node *head, Node *prog, Node *test,
+		       Stream *src, Stream *src2);
+PUBLIC Stream *str_list(Node *list);
+PUBLIC void str_write(Stream *s, FILE *stm);
+PUBLIC Range *rng_make(Operator type, long lo, long hi, long by);
+PUBLIC long rng_size(Range *r);
+PUBLIC long rng_nth(Range *r, long i);
+PUBLIC int rng_member(Range *r, long x);
+PUBLIC int rng_equal(Range *a, Range *b);
+PUBLIC unsigned long rng_hash(Range *r);
+PUBLIC void rng_write(Range *r, FILE *stm);
+PUBLIC int par_workers(void);
+PUBLIC void par_exit(void);
+PUBLIC void par_reap(void);
+PUBLIC int par_run(int filter);
+PUBLIC long par_maxdepth(void);
+PUBLIC void par_setdepth(long depth);
+PUBLIC int par_fork(void);
+PUBLIC void par_done(Node *n);
+PUBLIC int par_join(int job);
+PUBLIC Cell *task_cells(Node *n, long *size, char *name);
+PUBLIC void task_load(Cell *cell, long size);
+PUBLIC void task_free(Cell *cells);
+PUBLIC void task_spawn(void);
+PUBLIC void task_join(long id);
+PUBLIC void task_wait(int on);
+PUBLIC void task_stop(void);
+PUBLIC Channel *chan_new(long size);
+PUBLIC int chan_send(Channel *c, Node *n, int wait, char *name);
+PUBLIC int chan_recv(Channel *c, int wait, char *name);
+PUBLIC void chan_close(Channel *c);
+PUBLIC void chan_write(Channel *c, FILE *stm);
+PUBLIC JoyContext *joy_context_new(void);
+PUBLIC void joy_context_free(JoyContext *c);
+PUBLIC void native_exec(long n);
+PUBLIC int img_save(char *name);
+PUBLIC int img_load(char *name);
+PUBLIC void serve(char *name, int seconds, long megabytes);
+PUBLIC Cache *cache_open(char *name);
+PUBLIC int cache_next(Cache *c);
+PUBLIC Cache *cache_new(char *name, int errors);
+PUBLIC void cache_add(Cache *c);
+PUBLIC void cache_fail(Cache *c);
+PUBLIC void cache_end(Cache *c, int errors);
+PUBLIC void cache_free(Cache *c);
+PUBLIC void make_list(long count);
+PUBLIC unsigned long memo_key(unsigned long id, int nargs, Node *args);
+PUBLIC Node *memo_find(unsigned long id, Node *prog, unsigned long hash,
+		       int nargs, Node *args);
+PUBLIC void memo_store(unsigned long id, Node *prog, unsigned long hash,
+		       int nargs, Node *args, Node *result);
+PUBLIC int memo_known(unsigned long id, Node *prog);
+PUBLIC void memo_learn(unsigned long id, Node *prog);
+PUBLIC void memo_clear(void);
+PUBLIC void memo_stats(long *hits, long *misses, long *count, long *evictions);
+PUBLIC Node *sort_list(Node *list, long n, int (*less)(Node *, Node *));
+PUBLIC void sort_index(long *index, long *temp, long n, int (*less)(long, long));
+#ifndef GC_BDW
+PUBLIC void forward(Operator op, Types *u);
+PUBLIC void dict_forward(Dict *d, long epoch);
+PUBLIC void vec_forward(Vector *v, long epoch);
+PUBLIC void deq_forward(Deque *q, long epoch);
+PUBLIC void heap_forward(Heap *h, long epoch);
+PUBLIC void ord_forward(Otree *t, long epoch);
+PUBLIC void str_forward(Stream *s, long epoch);
+#endif
 
 #define USR_NEWNODE(u,r)	(bucket.ent = u, newnode(USR_, bucket, r))
 #define ANON_FUNCT_NEWNODE(u,r)	(bucket.proc= u, newnode(ANON_FUNCT_,bucket,r))
@@ -376,4 +757,13 @@ PUBLIC void HashValue(char *str);
 #define LIST_NEWNODE(u,r)	(bucket.lis = u, newnode(LIST_, bucket, r))
 #define FLOAT_NEWNODE(u,r)	(bucket.dbl = u, newnode(FLOAT_, bucket, r))
 #define FILE_NEWNODE(u,r)	(bucket.fil = u, newnode(FILE_, bucket, r))
+#define DICT_NEWNODE(u,r)	(bucket.dict = u, newnode(DICT_, bucket, r))
+#define VECTOR_NEWNODE(u,r)	(bucket.vec = u, newnode(VECTOR_, bucket, r))
+#define DEQUE_NEWNODE(u,r)	(bucket.deq = u, newnode(DEQUE_, bucket, r))
+#define HEAP_NEWNODE(u,r)	(bucket.heap = u, newnode(HEAP_, bucket, r))
+#define ORDSET_NEWNODE(u,r)	(bucket.ord = u, newnode(ORDSET_, bucket, r))
+#define ORDMAP_NEWNODE(u,r)	(bucket.ord = u, newnode(ORDMAP_, bucket, r))
+#define STREAM_NEWNODE(u,r)	(bucket.stream = u, newnode(STREAM_, bucket, r))
+#define RANGE_NEWNODE(u,r)	(bucket.rng = u, newnode(RANGE_, bucket, r))
+#define CHANNEL_NEWNODE(u,r)	(bucket.chan = u, newnode(CHANNEL_, bucket, r))
 #endif
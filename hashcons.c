@@ -0,0 +1,117 @@
+/* FILE: hashcons.c */
+/*
+ *  module  : hashcons.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+hash_cons makes equal lists share their cells. A list is processed from
+its last cell to its first, and members that are lists are processed
+first, so that a cell only needs to be compared with its candidates on
+the surface: the same type, the same value and the same next cell. The
+first cell with that content becomes the representative and later ones
+are replaced by it. Nothing is allocated: the cells of the list given
+are reused and relinked to representatives, which changes no value.
+Equal lists that have both been shared are then the same cells, and
+equal_list_aux finds them equal at once.
+
+The table refers to cells by address. It is emptied when the garbage
+collector has moved the cells, and when it becomes half full.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+#define CONSMAX		65536		/* slots, a power of 2	*/
+
+#define conses		(joy_context->conses)
+#define cons_count	(joy_context->cons_count)
+#define cons_epoch	(joy_context->cons_epoch)
+
+PRIVATE unsigned long cell_hash(Node *n)
+{
+    unsigned long h = n->op;
+    size_t i;
+
+    for (i = 0; i < sizeof(Types); i++)
+	h = h * 31 + ((unsigned char *)&n->u)[i];
+    h = h * 31 + (unsigned long)(size_t)n->next;
+    h ^= h >> 16;
+    h *= 0x45d9f3bUL;
+    h ^= h >> 16;
+    return h;
+}
+
+PRIVATE void clear_conses(void)
+{
+    if (!conses && (conses = malloc(CONSMAX * sizeof(Node *))) == 0)
+	execerror("memory", "share");
+    memset(conses, 0, CONSMAX * sizeof(Node *));
+    cons_count = 0;
+#ifndef GC_BDW
+    cons_epoch = gc_epoch;
+#endif
+}
+
+/*
+    representative delivers the first cell entered that has the same
+    content as n, or enters n itself.
+*/
+PRIVATE Node *representative(Node *n)
+{
+    Node *c;
+    long i;
+
+    if (2 * cons_count >= CONSMAX)
+	clear_conses();
+    for (i = cell_hash(n) & (CONSMAX - 1); (c = conses[i]) != 0;
+	 i = (i + 1) & (CONSMAX - 1))
+	if (c->op == n->op && c->next == n->next &&
+	    !memcmp(&c->u, &n->u, sizeof(Types)))
+	    return c;
+    conses[i] = n;
+    cons_count++;
+    return n;
+}
+
+PRIVATE Node *share_list(Node *n)
+{
+    Node **cell, *p;
+    long i, count;
+
+    for (count = 0, p = n; p; p = p->next)
+	count++;
+    if (!count)
+	return 0;
+    if ((cell = malloc(count * sizeof(Node *))) == 0)
+	execerror("memory", "share");
+    for (i = 0, p = n; p; p = p->next)
+	cell[i++] = p;
+    for (p = 0, i = count - 1; i >= 0; i--) {
+	if (cell[i]->op == LIST_)
+	    cell[i]->u.lis = share_list(cell[i]->u.lis);
+	cell[i]->next = p;
+	p = representative(cell[i]);
+    }
+    free(cell);
+    return p;
+}
+
+PUBLIC Node *hash_cons(Node *n)
+{
+#ifdef GC_BDW
+    if (!conses)
+#else
+    if (!conses || cons_epoch != gc_epoch)
+#endif
+	clear_conses();
+    return share_list(n);
+}
+/* END of HASHCONS.C */
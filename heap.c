@@ -0,0 +1,226 @@
+/* FILE: heap.c */
+/*
+ *  module  : heap.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A heap is a leftist tree: every node comes before its children, and the
+path down the right is never longer than the one down the left, so that
+it has at most log n nodes. Two heaps are merged along their right
+paths, and pushing and popping are merges. Only the nodes on the paths
+are copied, the rest is shared, so that older heaps remain valid.
+
+The order is given by a comparison, less, that is passed in. It can run
+a quotation, and with it the garbage collector, so that the elements
+move. Each element therefore sits in a box of its own, which the tree
+refers to and that is shared by all heaps that contain it: once the
+garbage collector has updated a box through any heap that is still on
+the stack, the new heaps that are built from it see the update too.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+typedef struct Hbox {
+    long epoch;					/* of the last forward	*/
+    Node elem;
+} Hbox;
+
+typedef struct Hnode {
+    long epoch, rank;
+    struct Hbox *box;
+    struct Hnode *left, *right;
+} Hnode;
+
+PRIVATE Heap *heap_header(Heap *from, long count, Hnode *root)
+{
+    Heap *h;
+
+    if ((h = malloc(sizeof(Heap))) == 0)
+	execerror("memory", "heap");
+    h->count = count;
+    h->epoch = 0;
+    h->order = from->order;
+    h->root = root;
+    return h;
+}
+
+PRIVATE Hnode *heap_node(Hbox *box, Hnode *left, Hnode *right)
+{
+    Hnode *n;
+
+    if ((n = malloc(sizeof(Hnode))) == 0)
+	execerror("memory", "heap");
+    n->epoch = 0;
+    n->box = box;
+    if (left && (!right || left->rank >= right->rank)) {
+	n->left = left;
+	n->right = right;
+    } else {
+	n->left = right;
+	n->right = left;
+    }
+    n->rank = n->right ? n->right->rank + 1 : 1;
+    return n;
+}
+
+/*
+    heap_new delivers an empty heap, that orders with the quotation given.
+*/
+PUBLIC Heap *heap_new(Node *order)
+{
+    Heap h;
+
+    h.order.op = LIST_;
+    h.order.u.lis = order;
+    h.order.next = 0;
+    return heap_header(&h, 0, 0);
+}
+
+PRIVATE Hbox *heap_box(Node *x)
+{
+    Hbox *box;
+
+    if ((box = malloc(sizeof(Hbox))) == 0)
+	execerror("memory", "heap");
+    box->epoch = 0;
+    box->elem.op = x->op;
+    box->elem.u = x->u;
+    box->elem.next = 0;
+    return box;
+}
+
+/*
+    heap_single delivers a heap of one element, ordered as h.
+*/
+PUBLIC Heap *heap_single(Heap *h, Node *x)
+{
+    return heap_header(h, 1, heap_node(heap_box(x), 0, 0));
+}
+
+/*
+    heap_boxes delivers the elements of a list in a heap ordered as h,
+    that has not been ordered yet: they are on its right path. It is only
+    there for the garbage collector, while heap_build orders them.
+*/
+PUBLIC Heap *heap_boxes(Heap *h, Node *list)
+{
+    Hnode *root = 0, **fill = &root;
+    long count = 0;
+
+    for (; list; list = list->next, count++) {
+	*fill = heap_node(heap_box(list), 0, 0);
+	fill = &(*fill)->right;
+    }
+    return heap_header(h, count, root);
+}
+
+/*
+    The element of a is compared with that of b before the children are
+    looked at, because less can update them.
+*/
+PRIVATE Hnode *heap_meld(Hnode *a, Hnode *b, int (*less)(Node *, Node *))
+{
+    Hnode *c;
+
+    if (!a)
+	return b;
+    if (!b)
+	return a;
+    if (less(&b->box->elem, &a->box->elem)) {
+	c = a;
+	a = b;
+	b = c;
+    }
+    return heap_node(a->box, a->left, heap_meld(a->right, b, less));
+}
+
+/*
+    heap_merge delivers the elements of a and b, in the order of a.
+*/
+PUBLIC Heap *heap_merge(Heap *a, Heap *b, int (*less)(Node *, Node *))
+{
+    Hnode *root;
+
+    root = heap_meld(a->root, b->root, less);
+    return heap_header(a, a->count + b->count, root);
+}
+
+/*
+    heap_build orders the elements put in by heap_boxes, by merging them
+    in pairs, round after round, which takes linear time.
+*/
+PUBLIC Heap *heap_build(Heap *h, int (*less)(Node *, Node *))
+{
+    Hnode **tree, *n;
+    long i, count;
+
+    if (!h->count)
+	return h;
+    if ((tree = malloc(h->count * sizeof(Hnode *))) == 0)
+	execerror("memory", "heap");
+    for (count = 0, n = h->root; n; n = n->right)
+	tree[count++] = heap_node(n->box, 0, 0);
+    while (count > 1) {
+	for (i = 0; 2 * i + 1 < count; i++)
+	    tree[i] = heap_meld(tree[2 * i], tree[2 * i + 1], less);
+	if (count & 1)
+	    tree[i++] = tree[count - 1];
+	count = i;
+    }
+    n = tree[0];
+    free(tree);
+    return heap_header(h, h->count, n);
+}
+
+/*
+    heap_top delivers the first element of a non-empty heap.
+*/
+PUBLIC Node *heap_top(Heap *h)
+{
+    return &h->root->box->elem;
+}
+
+PUBLIC Heap *heap_pop(Heap *h, int (*less)(Node *, Node *))
+{
+    Hnode *root;
+
+    root = heap_meld(h->root->left, h->root->right, less);
+    return heap_header(h, h->count - 1, root);
+}
+
+#ifndef GC_BDW
+PRIVATE void forward_hnode(Hnode *n, long epoch)
+{
+    for (; n && n->epoch != epoch; n = n->right) {
+	n->epoch = epoch;
+	if (n->box->epoch != epoch) {
+	    n->box->epoch = epoch;
+	    forward(n->box->elem.op, &n->box->elem.u);
+	}
+	forward_hnode(n->left, epoch);
+    }
+}
+
+/*
+    heap_forward updates the order and the elements of a heap after they
+    have been copied by the garbage collector.
+*/
+PUBLIC void heap_forward(Heap *h, long epoch)
+{
+    if (!h || h->epoch == epoch)
+	return;
+    h->epoch = epoch;
+    forward(h->order.op, &h->order.u);
+    forward_hnode(h->root, epoch);
+}
+#endif
+/* END of HEAP.C */
@@ -0,0 +1,623 @@
+/* FILE: image.c */
+/*
+ *  module  : image.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+An image holds the definitions of a run, so that a later run can start
+with them without reading the libraries again: joy --save-image file
+writes one when the input ends, and joy --image file reads it instead of
+usrlib.joy. It is only valid for the program that wrote it.
+
+The image has a header, the entries of the symbol table, the nodes of
+the bodies and the data these refer to: names, strings, bigsets, bignums
+and rationals. In the file a pointer is the offset from the start of the
+image and an entry is its index in symtab; a primitive is its operator.
+Reading an image maps the file into memory and turns the offsets back
+into pointers, in place, so that the nodes are used where they are. They
+are then outside node memory, as definitions are, and never freed.
+*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#define IMGMAGIC	"JOYIMG1"
+#define IMGMIN		1024		/* slots in the table	*/
+
+typedef struct Image
+  { char magic[8];
+    unsigned long check;			/* of the primitives	*/
+    long entries, nodes, data;
+    int flags[4];				/* autoput, .. tracegc	*/
+    int node;					/* size of a Node	*/
+    long hash[HASHSIZE]; } Image;
+
+typedef struct Item				/* entry in the image	*/
+  { long name, next, body;			/* body: entry if module */
+    unsigned char module, local, unknown, used; } Item;
+
+typedef struct Place
+  { void *key;
+    long val; } Place;
+
+static Node **img_nodes;			/* img_save		*/
+static long img_count, img_max;
+static char *img_data;
+static long img_used, img_room;
+static Place *img_slots;
+static long img_filled, img_size;
+
+#define ROUND(n)	((long)(((n) + sizeof(Node) - 1) / sizeof(Node)) *	\
+			 (long)sizeof(Node))
+
+/*
+    img_check combines the names of the primitives: an image refers to
+    them by their number.
+*/
+PRIVATE unsigned long img_check(void)
+{
+    unsigned long h = 0;
+    Entry *e;
+
+    for (e = symtab; e < firstlibra; e++)
+	h = h * 31 + e->hash;
+    return h + (firstlibra - symtab);
+}
+
+PRIVATE Place *img_probe(void *key)
+{
+    long i;
+
+    for (i = ((size_t)key >> 4) & (img_size - 1); img_slots[i].key;
+	 i = (i + 1) & (img_size - 1))
+	if (img_slots[i].key == key)
+	    break;
+    return &img_slots[i];
+}
+
+PRIVATE int img_enter(void *key, long val)
+{
+    Place *old = img_slots;
+    long i, size = img_size;
+
+    if (2 * (img_filled + 1) > img_size) {
+	img_size = size ? 2 * size : IMGMIN;
+	if ((img_slots = calloc(img_size, sizeof(Place))) == 0)
+	    return 0;
+	for (i = 0; i < size; i++)
+	    if (old[i].key)
+		*img_probe(old[i].key) = old[i];
+	free(old);
+    }
+    img_probe(key)->key = key;
+    img_probe(key)->val = val;
+    img_filled++;
+    return 1;
+}
+
+/*
+    img_node gives the number of the node n plus one, or 0 for NULL, and
+    -1 when there is no memory.
+*/
+PRIVATE long img_node(Node *n)
+{
+    Place *s;
+
+    if (!n)
+	return 0;
+    if (img_slots && (s = img_probe(n))->key)
+	return s->val + 1;
+    if (img_count == img_max) {
+	img_max = img_max ? 2 * img_max : IMGMIN;
+	if ((img_nodes = realloc(img_nodes, img_max * sizeof(Node *))) == 0)
+	    return -1;
+    }
+    if (!img_enter(n, img_count))
+	return -1;
+    img_nodes[img_count] = n;
+    return ++img_count;
+}
+
+/*
+    img_add copies size bytes at p to the data, and gives their offset
+    in the data plus one. With share, data that was added before is not
+    added again.
+*/
+PRIVATE long img_add(void *p, long size, int share)
+{
+    Place *s;
+    long at = img_used;
+
+    if (share && img_slots && (s = img_probe(p))->key)
+	return s->val + 1;
+    if (img_used + ROUND(size) > img_room) {
+	while (img_used + ROUND(size) > img_room)
+	    img_room = img_room ? 2 * img_room : IMGMIN * (long)sizeof(Node);
+	if ((img_data = realloc(img_data, img_room)) == 0)
+	    return 0;
+    }
+    memcpy(img_data + at, p, size);
+    memset(img_data + at + size, 0, ROUND(size) - size);
+    img_used += ROUND(size);
+    if (share && !img_enter(p, at))
+	return 0;
+    return at + 1;
+}
+
+PRIVATE long img_bignum(Bignum *b)
+{
+    long size = b->size < 0 ? -b->size : b->size;
+
+    return img_add(b, (char *)(b->digit + size) - (char *)b, 1);
+}
+
+/*
+    img_value writes the value of n into m, with the offsets of nodes in
+    the image, that start at at, and of data in the data plus one. It
+    gives 0 when n cannot be saved.
+*/
+PRIVATE int img_value(Node *n, Node *m, long at)
+{
+    Rational rat;
+    long off = 0;
+
+    m->op = n->op;
+    m->u.num = 0;
+    switch (n->op) {
+    case BOOLEAN_:
+    case CHAR_:
+    case INTEGER_:
+    case SET_:
+    case FLOAT_:
+	m->u = n->u;
+	return 1;
+    case LIST_:
+	if ((off = img_node(n->u.lis)) > 0)
+	    m->u.num = at + (off - 1) * sizeof(Node);
+	return off >= 0;
+    case USR_:
+	m->u.num = LOC2INT(n->u.ent);
+	return 1;
+    case STRING_:
+	off = img_add(n->u.str, strlen(n->u.str) + 1, 1);
+	break;
+    case BIGSET_:
+	off = img_add(n->u.big, sizeof(Bigset) +
+		      (n->u.big->size - 1) * sizeof(Setword), 1);
+	break;
+    case BIGNUM_:
+	off = img_bignum(n->u.bnum);
+	break;
+    case RATIONAL_:
+	memset(&rat, 0, sizeof(rat));		/* no padding bytes	*/
+	rat.num.op = n->u.rat->num.op;
+	rat.num.u = n->u.rat->num.u;
+	rat.den.op = n->u.rat->den.op;
+	rat.den.u = n->u.rat->den.u;
+	if (rat.num.op == BIGNUM_ &&
+	    (rat.num.u.num = img_bignum(n->u.rat->num.u.bnum)) == 0)
+	    return 0;
+	if (rat.den.op == BIGNUM_ &&
+	    (rat.den.u.num = img_bignum(n->u.rat->den.u.bnum)) == 0)
+	    return 0;
+	off = img_add(&rat, sizeof(Rational), 0);	/* relocated once */
+	break;
+    default:					/* a primitive	*/
+	return n->op >= FALSE_ && n->op < firstlibra - symtab;
+    }
+    if (!off)
+	return 0;
+    m->u.num = off;
+    return 1;
+}
+
+PRIVATE void img_clear(void)
+{
+    free(img_nodes);
+    free(img_data);
+    free(img_slots);
+    img_nodes = 0;
+    img_data = 0;
+    img_slots = 0;
+    img_count = img_max = img_used = img_room = img_filled = img_size = 0;
+}
+
+/*
+    img_offsets turns the data offsets in the nodes, and in the rationals
+    in the data, into offsets in the image.
+*/
+PRIVATE void img_offsets(Node *nodes, long data)
+{
+    Rational *rat;
+    long i;
+
+    for (i = 0; i < img_count; i++)
+	switch (nodes[i].op) {
+	case RATIONAL_:
+	    rat = (Rational *)(img_data + nodes[i].u.num - 1);
+	    if (rat->num.op == BIGNUM_)
+		rat->num.u.num += data - 1;
+	    if (rat->den.op == BIGNUM_)
+		rat->den.u.num += data - 1;
+	    /* fall through */
+	case STRING_:
+	case BIGSET_:
+	case BIGNUM_:
+	    nodes[i].u.num += data - 1;
+	    break;
+	}
+}
+
+/*
+    img_save writes the definitions to the file name, and delivers 0 when
+    that fails.
+*/
+PUBLIC int img_save(char *name)
+{
+    Image head;
+    Item *items = 0;
+    Node *nodes = 0;
+    Entry *e;
+    FILE *fp;
+    long i, at, data, pad, off, entries = symtabindex - symtab;
+    int ok = 0;
+
+    memset(&head, 0, sizeof(head));
+    strcpy(head.magic, IMGMAGIC);
+    head.check = img_check();
+    head.entries = entries;
+    head.flags[0] = autoput;
+    head.flags[1] = undeferror;
+    head.flags[2] = echoflag;
+    head.flags[3] = tracegc;
+    head.node = sizeof(Node);
+    for (i = 0; i < HASHSIZE; i++)
+	head.hash[i] = LOC2INT(hashentry[i]);	/* never NULL	*/
+    if ((items = calloc(entries, sizeof(Item))) == 0)
+	goto done;
+    for (e = symtab; e < symtabindex; e++) {
+	i = e - symtab;
+	items[i].next = e->next ? (long)LOC2INT(e->next) + 1 : 0;
+	if (e < firstlibra)
+	    continue;
+	if ((items[i].name = img_add(e->name, strlen(e->name) + 1, 1)) == 0)
+	    goto done;
+	if ((items[i].module = e->is_module) != 0)
+	    items[i].body = e->u.module_fields ?
+			    (long)LOC2INT(e->u.module_fields) + 1 : 0;
+	else if ((items[i].body = img_node(e->u.body)) < 0)
+	    goto done;
+#ifdef NO_HELP_LOCAL_SYMBOLS
+	items[i].local = e->is_local;
+#endif
+#ifdef USE_UNKNOWN_SYMBOLS
+	items[i].unknown = e->is_unknown;
+#endif
+#ifdef TRACK_USED_SYMBOLS
+	items[i].used = e->is_used;
+#endif
+    }
+    for (i = 0; i < img_count; i++)		/* img_count grows */
+	if (img_node(img_nodes[i]->next) < 0 || (img_nodes[i]->op == LIST_ &&
+	    img_node(img_nodes[i]->u.lis) < 0))
+	    goto done;
+    if ((nodes = calloc(img_count + 1, sizeof(Node))) == 0)
+	goto done;
+    pad = ROUND(entries * sizeof(Item)) - entries * sizeof(Item);
+    at = sizeof(Image) + entries * sizeof(Item) + pad;
+    for (i = 0; i < img_count; i++) {
+	if (!img_value(img_nodes[i], &nodes[i], at))
+	    goto done;
+	off = img_node(img_nodes[i]->next);
+	nodes[i].next = off ? (Node *)(size_t)(at + (off - 1) * sizeof(Node))
+			    : 0;
+    }
+    data = at + img_count * sizeof(Node);
+    img_offsets(nodes, data);
+    for (i = firstlibra - symtab; i < entries; i++) {
+	items[i].name += data - 1;
+	if (!items[i].module && items[i].body)
+	    items[i].body = at + (items[i].body - 1) * sizeof(Node);
+    }
+    head.nodes = img_count;
+    head.data = img_used;
+    if ((fp = fopen(name, "wb")) == 0)
+	goto done;
+    ok = fwrite(&head, sizeof(Image), 1, fp) == 1 &&
+	 fwrite(items, sizeof(Item), entries, fp) == (size_t)entries &&
+	 fwrite(nodes + img_count, 1, pad, fp) == (size_t)pad &&
+	 fwrite(nodes, sizeof(Node), img_count, fp) == (size_t)img_count &&
+	 fwrite(img_data, 1, img_used, fp) == (size_t)img_used;
+    ok = fclose(fp) == 0 && ok;
+done:
+    free(items);
+    free(nodes);
+    img_clear();
+    return ok;
+}
+
+/*
+    img_map delivers the contents of the file name, and its size.
+*/
+PRIVATE char *img_map(char *name, long *size)
+{
+    char *base;
+#ifndef _WIN32
+    struct stat st;
+    int fd;
+
+    if ((fd = open(name, O_RDONLY)) < 0)
+	return 0;
+    if (fstat(fd, &st) || (*size = st.st_size) < (long)sizeof(Image)) {
+	close(fd);
+	return 0;
+    }
+    base = mmap(0, *size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    return base == MAP_FAILED ? 0 : base;
+#else
+    FILE *fp;
+
+    if ((fp = fopen(name, "rb")) == 0)
+	return 0;
+    fseek(fp, 0, SEEK_END);
+    *size = ftell(fp);
+    rewind(fp);
+    if (*size < (long)sizeof(Image) || (base = malloc(*size)) == 0 ||
+	fread(base, 1, *size, fp) != (size_t)*size)
+	base = 0;
+    fclose(fp);
+    return base;
+#endif
+}
+
+/*
+    img_unmap gives back what img_map delivered.
+*/
+PRIVATE void img_unmap(char *base, long size)
+{
+#ifndef _WIN32
+    munmap(base, size);
+#else
+    (void)size;
+    free(base);
+#endif
+}
+
+static long img_first, img_start, img_end;	/* img_load: nodes, data */
+
+/*
+    img_inside tells whether off is the offset of a node in the image, or
+    0 for NULL.
+*/
+PRIVATE int img_inside(long off)
+{
+    return !off || (off >= img_first && off < img_start &&
+		    (off - img_first) % (long)sizeof(Node) == 0);
+}
+
+/*
+    img_span tells whether the data at off has room for size bytes.
+*/
+PRIVATE int img_span(long off, long size)
+{
+    return off >= img_start && off < img_end &&
+	   (off - img_start) % (long)sizeof(Node) == 0 &&
+	   size >= 0 && size <= img_end - off;
+}
+
+PRIVATE int img_string(char *base, long off)
+{
+    return img_span(off, 1) && memchr(base + off, 0, img_end - off);
+}
+
+PRIVATE int img_number(char *base, long off)
+{
+    long size;
+
+    if (!img_span(off, sizeof(Bignum)))
+	return 0;
+    size = ((Bignum *)(base + off))->size;
+    return size > -LONG_MAX && (size < 0 ? -size : size) <=
+	   (img_end - off - (long)offsetof(Bignum, digit)) / (long)sizeof(Limb);
+}
+
+/*
+    img_valid tells whether each offset, index and size in the image lies
+    within it, before any of them is used.
+*/
+PRIVATE int img_valid(char *base, long size)
+{
+    Image *head = (Image *)base;
+    Item *items = (Item *)(base + sizeof(Image));
+    Rational *rat;
+    Bigset *big;
+    Node *n;
+    long i, entries = head->entries;
+
+    if (memcmp(head->magic, IMGMAGIC, sizeof(IMGMAGIC)) ||
+	head->check != img_check() || head->node != (int)sizeof(Node) ||
+	entries < firstlibra - symtab || entries > SYMTABMAX ||
+	head->nodes < 0 || head->data < 0)
+	return 0;
+    img_first = sizeof(Image) + ROUND(entries * sizeof(Item));
+    if (img_first > size ||
+	head->nodes > (size - img_first) / (long)sizeof(Node))
+	return 0;
+    img_start = img_first + head->nodes * sizeof(Node);
+    if ((img_end = size) - img_start != head->data)
+	return 0;
+    for (i = 0; i < HASHSIZE; i++)
+	if (head->hash[i] < 0 || head->hash[i] >= entries)
+	    return 0;
+    for (i = 0; i < entries; i++) {
+	if (items[i].next < 0 || items[i].next > entries)
+	    return 0;
+	if (i < firstlibra - symtab)
+	    continue;
+	if (!img_string(base, items[i].name))
+	    return 0;
+	if (items[i].module ? items[i].body < 0 || items[i].body > entries
+			    : !img_inside(items[i].body))
+	    return 0;
+    }
+    for (n = (Node *)(base + img_first); (char *)n < base + img_start; n++) {
+	if (!img_inside((long)(size_t)n->next))
+	    return 0;
+	switch (n->op) {
+	case BOOLEAN_:
+	case CHAR_:
+	case INTEGER_:
+	case SET_:
+	case FLOAT_:
+	    break;
+	case LIST_:
+	    if (!img_inside(n->u.num))
+		return 0;
+	    break;
+	case USR_:
+	    if (n->u.num < 0 || n->u.num >= entries)
+		return 0;
+	    break;
+	case STRING_:
+	    if (!img_string(base, n->u.num))
+		return 0;
+	    break;
+	case BIGSET_:
+	    if (!img_span(n->u.num, sizeof(Bigset)))
+		return 0;
+	    big = (Bigset *)(base + n->u.num);
+	    if (big->size < 1 || big->size - 1 >
+		(img_end - n->u.num - (long)sizeof(Bigset)) / (long)sizeof(Setword))
+		return 0;
+	    break;
+	case BIGNUM_:
+	    if (!img_number(base, n->u.num))
+		return 0;
+	    break;
+	case RATIONAL_:
+	    if (!img_span(n->u.num, sizeof(Rational)))
+		return 0;
+	    rat = (Rational *)(base + n->u.num);
+	    if ((rat->num.op != INTEGER_ && (rat->num.op != BIGNUM_ ||
+		 !img_number(base, rat->num.u.num))) ||
+		(rat->den.op != INTEGER_ && (rat->den.op != BIGNUM_ ||
+		 !img_number(base, rat->den.u.num))))
+		return 0;
+	    break;
+	default:				/* a primitive	*/
+	    if (n->op < FALSE_ || n->op >= firstlibra - symtab)
+		return 0;
+	    break;
+	}
+    }
+    return 1;
+}
+
+#define RELOC(p)	if (p) p = (void *)(base + (size_t)(p))
+
+/*
+    img_load reads the definitions in the image name, and delivers 0 when
+    that fails. It is done before anything else is read. The image is
+    checked first, as it may have been damaged.
+*/
+PUBLIC int img_load(char *name)
+{
+    Image *head;
+    Item *items;
+    Node *nodes, *n;
+    Entry *e;
+    char *base;
+    long i, size;
+
+    if ((base = img_map(name, &size)) == 0)
+	return 0;
+    if (!img_valid(base, size)) {
+	img_unmap(base, size);
+	return 0;
+    }
+    head = (Image *)base;
+    items = (Item *)(base + sizeof(Image));
+    nodes = (Node *)(base + img_first);
+    for (n = nodes; n < nodes + head->nodes; n++) {
+	RELOC(n->next);
+	switch (n->op) {
+	case BOOLEAN_:
+	case CHAR_:
+	case INTEGER_:
+	case SET_:
+	case FLOAT_:
+	    break;
+	case LIST_:
+	    RELOC(n->u.lis);
+	    break;
+	case USR_:
+	    n->u.ent = symtab + n->u.num;
+	    break;
+	case STRING_:
+	    n->u.str = intern_static(base + n->u.num, 0);
+	    break;
+	case BIGSET_:
+	    RELOC(n->u.big);
+	    break;
+	case BIGNUM_:
+	    RELOC(n->u.bnum);
+	    break;
+	case RATIONAL_:
+	    RELOC(n->u.rat);			/* not shared	*/
+	    if (n->u.rat->num.op == BIGNUM_)
+		RELOC(n->u.rat->num.u.bnum);
+	    if (n->u.rat->den.op == BIGNUM_)
+		RELOC(n->u.rat->den.u.bnum);
+	    break;
+	default:
+	    n->u.proc = symtab[n->op].u.proc;
+	    break;
+	}
+    }
+    for (i = 0; i < head->entries; i++) {
+	e = &symtab[i];
+	e->next = items[i].next ? &symtab[items[i].next - 1] : 0;
+	if (e < firstlibra)
+	    continue;
+	e->name = intern_static(base + items[i].name, &e->hash);
+	e->memo = 0;
+	if ((e->is_module = items[i].module) != 0)
+	    e->u.module_fields = items[i].body ?
+				 &symtab[items[i].body - 1] : 0;
+	else
+	    e->u.body = items[i].body ? (Node *)(base + items[i].body) : 0;
+#ifdef NO_HELP_LOCAL_SYMBOLS
+	e->is_local = items[i].local;
+#endif
+#ifdef USE_UNKNOWN_SYMBOLS
+	e->is_unknown = items[i].unknown;
+#endif
+#ifdef TRACK_USED_SYMBOLS
+	e->is_used = items[i].used;
+#endif
+    }
+    for (i = 0; i < HASHSIZE; i++)
+	hashentry[i] = &symtab[head->hash[i]];
+    symtabindex = symtab + head->entries;
+    autoput = head->flags[0];
+    undeferror = head->flags[1];
+    echoflag = head->flags[2];
+    tracegc = head->flags[3];
+    return 1;
+}
+/* END of IMAGE.C */
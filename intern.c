@@ -0,0 +1,154 @@
+/* FILE: intern.c */
+/*
+ *  module  : intern.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+The intern table holds one copy of each distinct name and of each string
+that appears in the source text, together with its hash. All names in
+the symbol table come from here, so that two names are equal exactly
+when their pointers are; string literals are shared in the same way.
+Strings made at run time are not interned, so a comparison of strings
+tests the pointers first and then the characters. The table is an open
+addressed hash table that doubles when it is half full; its strings are
+never freed.
+
+The table is shared by all contexts, and any of them may add to it: the
+scanner interns each string literal and the intern primitive each new
+name. A lock keeps the additions of one thread from those of another.
+*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+#define INTERNMIN	1024		/* initial size, a power of 2	*/
+
+typedef struct Atom {
+    char *str;
+    unsigned long hash;
+} Atom;
+
+static Atom *atoms;
+static long atom_count, atom_size;
+
+#ifndef _WIN32
+static pthread_mutex_t atom_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK		pthread_mutex_lock(&atom_lock)
+#define UNLOCK		pthread_mutex_unlock(&atom_lock)
+#else
+#define LOCK
+#define UNLOCK
+#endif
+
+PUBLIC unsigned long str_hash(char *s)
+{
+    unsigned long h = 5381;
+
+    while (s && *s)
+	h = h * 33 + (unsigned char)*s++;
+    return h;
+}
+
+PRIVATE Atom *probe(char *s, unsigned long hash)
+{
+    long i;
+
+    for (i = hash & (atom_size - 1); atoms[i].str;
+	 i = (i + 1) & (atom_size - 1))
+	if (atoms[i].hash == hash && !strcmp(atoms[i].str, s))
+	    break;
+    return &atoms[i];
+}
+
+PRIVATE void grow_atoms(void)
+{
+    Atom *old = atoms;
+    long i, size = atom_size;
+
+    atom_size = size ? 2 * size : INTERNMIN;
+    if ((atoms = malloc(atom_size * sizeof(Atom))) == 0) {
+	atoms = old;
+	atom_size = size;
+	UNLOCK;
+	execerror("memory", "intern");
+    }
+    memset(atoms, 0, atom_size * sizeof(Atom));
+    for (i = 0; i < size; i++)
+	if (old[i].str)
+	    *probe(old[i].str, old[i].hash) = old[i];
+    free(old);
+}
+
+/*
+    atom delivers the canonical copy of s and its hash. The string s
+    becomes the canonical copy when copy is not set: it must then not be
+    freed, as is the case with the names in optable. The lock is held
+    from the search until the string is in the table.
+*/
+PRIVATE char *atom(char *s, unsigned long *hash, int copy)
+{
+    Atom *a;
+    char *str;
+    unsigned long h;
+
+    h = str_hash(s);
+    LOCK;
+    if (2 * (atom_count + 1) > atom_size)
+	grow_atoms();
+    if ((a = probe(s, h))->str == 0) {
+	if (copy) {
+	    if ((a->str = malloc(strlen(s) + 1)) == 0) {
+		UNLOCK;
+		execerror("memory", "intern");
+	    }
+	    strcpy(a->str, s);
+	} else
+	    a->str = s;
+	a->hash = h;
+	atom_count++;
+    }
+    str = a->str;
+    UNLOCK;
+    if (hash)
+	*hash = h;
+    return str;
+}
+
+PUBLIC char *intern(char *s, unsigned long *hash)
+{
+    return atom(s, hash, 1);
+}
+
+PUBLIC char *intern_static(char *s, unsigned long *hash)
+{
+    return atom(s, hash, 0);
+}
+
+/*
+    intern_prepare and intern_release take and give back the lock around
+    a fork, see symtab_atfork in main.c.
+*/
+PUBLIC void intern_prepare(void)
+{
+    LOCK;
+}
+
+PUBLIC void intern_release(void)
+{
+    UNLOCK;
+}
+/* END of INTERN.C */
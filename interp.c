@@ -37,6 +37,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <limits.h>
 #include "globals.h"
 #ifdef CORRECT_INTERN_LOOKUP
 #include <ctype.h>
@@ -55,6 +56,29 @@ PRIVATE void manual_list_(void);
 #if 0
 PRIVATE void manual_list_aux_(void);
 #endif
+PRIVATE void memo_exec(unsigned long id, int nargs, int quoted);
+PRIVATE int memo_is_pure(Node *prog, Node *args, int nargs);
+
+/* big sets are sets in all respects but their representation */
+#define BASETYPE(OP)						\
+    ((OP) == BIGSET_ ? SET_ : (OP) == BIGNUM_ ? INTEGER_ : (OP))
+#define BIGNUMS2						\
+    ((stk->op == BIGNUM_ || stk->next->op == BIGNUM_) &&	\
+     BASETYPE(stk->op) == INTEGER_ && BASETYPE(stk->next->op) == INTEGER_)
+#define EXACT(OP)						\
+    (BASETYPE(OP) == INTEGER_ || (OP) == RATIONAL_)
+#define BOXED(OP)						\
+    ((OP) == BIGNUM_ || (OP) == RATIONAL_ || (OP) == BIGSET_ ||	\
+     ARRAY(OP) || (OP) == VECTOR_ || (OP) == DEQUE_ ||		\
+     (OP) == DICT_ || (OP) == ORDSET_ || (OP) == ORDMAP_ ||	\
+     (OP) == RANGE_)				/* compared by value */
+#define RATIONALS2						\
+    ((stk->op == RATIONAL_ || stk->next->op == RATIONAL_) &&	\
+     EXACT(stk->op) && EXACT(stk->next->op))
+#define ARRAY(OP)						\
+    ((OP) == FLOATARRAY_ || (OP) == INTARRAY_)
+#define ARRAYS2							\
+    (ARRAY(stk->op) || ARRAY(stk->next->op))
 
 #ifdef RUNTIME_CHECKS
 #define ONEPARAM(NAME)						\
@@ -94,7 +118,7 @@ PRIVATE void manual_list_aux_(void);
     if (stk->next->next->next->op != LIST_)			\
 	execerror("quotation as fourth parameter",NAME)
 #define SAME2TYPES(NAME)					\
-    if (stk->op != stk->next->op)				\
+    if (BASETYPE(stk->op) != BASETYPE(stk->next->op))		\
 	execerror("two parameters of the same type",NAME)
 #define STRING(NAME)						\
     if (stk->op != STRING_)					\
@@ -121,6 +145,12 @@ PRIVATE void manual_list_aux_(void);
 #define NUMERIC2(NAME)						\
     if (stk->next->op != INTEGER_ && stk->next->op != CHAR_)	\
 	execerror("numeric second parameter",NAME)
+#define EXACTTYPE(NAME)						\
+    if (!EXACT(stk->op))					\
+	execerror("integer or rational",NAME)
+#define EXACT2(NAME)						\
+    if (!EXACT(stk->op) || !EXACT(stk->next->op))		\
+	execerror("two integers or rationals",NAME)
 #else
 #define ONEPARAM(NAME)
 #define TWOPARAMS(NAME)
@@ -140,28 +170,35 @@ PRIVATE void manual_list_aux_(void);
 #define INTEGERS2(NAME)
 #define NUMERICTYPE(NAME)
 #define NUMERIC2(NAME)
+#define EXACTTYPE(NAME)
+#define EXACT2(NAME)
 #endif
 #define FLOATABLE						\
-    (stk->op == INTEGER_ || stk->op == FLOAT_)
+    (EXACT(stk->op) || stk->op == FLOAT_)
 #define FLOATABLE2						\
     ((stk->op == FLOAT_ && stk->next->op == FLOAT_) ||		\
-	(stk->op == FLOAT_ && stk->next->op == INTEGER_) ||	\
-	(stk->op == INTEGER_ && stk->next->op == FLOAT_))
+	(stk->op == FLOAT_ && EXACT(stk->next->op)) ||		\
+	(EXACT(stk->op) && stk->next->op == FLOAT_))
 #ifdef RUNTIME_CHECKS
 #define FLOAT(NAME)						\
     if (!FLOATABLE)						\
 	execerror("float or integer", NAME);
 #define FLOAT2(NAME)						\
-    if (!(FLOATABLE2 || (stk->op == INTEGER_ && stk->next->op == INTEGER_))) \
+    if (!(FLOATABLE2 || (EXACT(stk->op) && EXACT(stk->next->op)))) \
 	execerror("two floats or integers", NAME)
 #else
 #define FLOAT(NAME)
 #define FLOAT2(NAME)
 #endif
 #define FLOATVAL						\
-    (stk->op == FLOAT_ ? stk->u.dbl : (double) stk->u.num)
+    (stk->op == FLOAT_ ? stk->u.dbl :				\
+     stk->op == BIGNUM_ ? num_double(stk) :			\
+     stk->op == RATIONAL_ ? rat_double(stk) : (double) stk->u.num)
 #define FLOATVAL2						\
-    (stk->next->op == FLOAT_ ? stk->next->u.dbl : (double) stk->next->u.num)
+    (stk->next->op == FLOAT_ ? stk->next->u.dbl :		\
+     stk->next->op == BIGNUM_ ? num_double(stk->next) :		\
+     stk->next->op == RATIONAL_ ? rat_double(stk->next) :	\
+     (double) stk->next->u.num)
 #define FLOAT_U(OPER)						\
     if (FLOATABLE) { UNARY(FLOAT_NEWNODE, OPER(FLOATVAL)); return; }
 #define FLOAT_P(OPER)						\
@@ -189,11 +226,56 @@ PRIVATE void manual_list_aux_(void);
 	execerror("internal list",NAME)
 #define CHECKSETMEMBER(NODE,NAME)				\
     if ((NODE->op != INTEGER_ && NODE->op != CHAR_) ||		\
-	NODE->u.num >= SETSIZE)					\
+	NODE->u.num < 0 || NODE->u.num >= BIGSETMAX)		\
 	execerror("small numeric",NAME)
 #define CHECKEMPTYSET(SET,NAME)					\
     if (SET == 0)						\
 	execerror("non-empty set",NAME)
+#define DICTIONARY(NODE,NAME)					\
+    if (NODE->op != DICT_)					\
+	execerror("dictionary",NAME)
+#define CHECKPAIR(NODE,NAME)					\
+    if (NODE->op != LIST_ || NODE->u.lis == NULL ||		\
+	NODE->u.lis->next == NULL)				\
+	execerror("pair [key value]",NAME)
+#define VECTOR(NODE,NAME)					\
+    if (NODE->op != VECTOR_)					\
+	execerror("vector",NAME)
+#define VECINDEX(NODE,LIMIT,NAME)				\
+    if (NODE->op != INTEGER_ || NODE->u.num < 0)		\
+	execerror("non-negative integer",NAME);			\
+    if (NODE->u.num >= LIMIT)					\
+	execerror("smaller index",NAME)
+#define DEQUE(NODE,NAME)					\
+    if (NODE->op != DEQUE_)					\
+	execerror("deque",NAME)
+#define CHECKEMPTYDEQUE(DEQ,NAME)				\
+    if (DEQ == NULL)						\
+	execerror("non-empty deque",NAME)
+#define HEAP(NODE,NAME)						\
+    if (NODE->op != HEAP_)					\
+	execerror("heap",NAME)
+#define CHECKEMPTYHEAP(HEAP,NAME)				\
+    if (HEAP->count == 0)					\
+	execerror("non-empty heap",NAME)
+#define ORDSET(NODE,NAME)					\
+    if (NODE->op != ORDSET_)					\
+	execerror("ordered set",NAME)
+#define ORDMAP(NODE,NAME)					\
+    if (NODE->op != ORDMAP_)					\
+	execerror("ordered map",NAME)
+#define ORDERED(NODE,NAME)					\
+    if (NODE->op != ORDSET_ && NODE->op != ORDMAP_)		\
+	execerror("ordered set or map",NAME)
+#define CHANNEL(NODE,NAME)					\
+    if (NODE->op != CHANNEL_)					\
+	execerror("channel",NAME)
+#define CHECKEMPTYSTREAM(STREAM,NAME)				\
+    if (STREAM == NULL)						\
+	execerror("non-empty stream",NAME)
+#define CHECKEMPTYRANGE(RANGE,NAME)				\
+    if (rng_size(RANGE) == 0)					\
+	execerror("non-empty range",NAME)
 #define CHECKEMPTYSTRING(STRING,NAME)				\
     if (*STRING == '\0')					\
 	execerror("non-empty string",NAME)
@@ -215,6 +297,20 @@ PRIVATE void manual_list_aux_(void);
 #define CHECKLIST(OPR,NAME)
 #define CHECKSETMEMBER(NODE,NAME)
 #define CHECKEMPTYSET(SET,NAME)
+#define DICTIONARY(NODE,NAME)
+#define CHECKPAIR(NODE,NAME)
+#define VECTOR(NODE,NAME)
+#define VECINDEX(NODE,LIMIT,NAME)
+#define DEQUE(NODE,NAME)
+#define CHECKEMPTYDEQUE(DEQ,NAME)
+#define HEAP(NODE,NAME)
+#define CHECKEMPTYHEAP(HEAP,NAME)
+#define ORDSET(NODE,NAME)
+#define ORDMAP(NODE,NAME)
+#define ORDERED(NODE,NAME)
+#define CHANNEL(NODE,NAME)
+#define CHECKEMPTYSTREAM(STREAM,NAME)
+#define CHECKEMPTYRANGE(RANGE,NAME)
 #define CHECKEMPTYSTRING(STRING,NAME)
 #define CHECKEMPTYLIST(LIST,NAME)
 #define INDEXTOOLARGE(NAME)
@@ -253,6 +349,8 @@ PRIVATE void manual_list_aux_(void);
 #define GTERNARY(TYPE,VALUE)					\
     stk = newnode(TYPE,(VALUE),stk->next->next->next)
 
+#define STRCMP(A,B)	((A) == (B) ? 0 : strcmp((A),(B)))	/* interned */
+
 #define GETSTRING(NODE)						\
   ( NODE->op == STRING_  ?  NODE->u.str :			\
    (NODE->op == USR_  ?  NODE->u.ent->name :			\
@@ -266,7 +364,7 @@ PRIVATE void PROCEDURE(void)					\
 #if 0
 PUSH(true_,BOOLEAN_NEWNODE,1L)				/* constants	*/
 PUSH(false_,BOOLEAN_NEWNODE,0L)
-PUSH(maxint_,INTEGER_NEWNODE,(long)MAXINT)
+PUSH(maxint_,INTEGER_NEWNODE,(Num)MAXINT)
 #endif
 PUSH(setsize_,INTEGER_NEWNODE,(long)SETSIZE)
 PUSH(symtabmax_,INTEGER_NEWNODE,(long)SYMTABMAX)
@@ -290,6 +388,7 @@ PUSH(memoryindex_,INTEGER_NEWNODE,MEM2INT(memoryindex))
 PUSH(echo_,INTEGER_NEWNODE,(long)echoflag)
 PUSH(autoput_,INTEGER_NEWNODE,(long)autoput)
 PUSH(undeferror_,INTEGER_NEWNODE,(long)undeferror)
+PUSH(pardepth_,INTEGER_NEWNODE,par_maxdepth())
 PUSH(clock_,INTEGER_NEWNODE,(long)(clock() - startclock))
 PUSH(time_,INTEGER_NEWNODE,(long)time(NULL))
 PUSH(argc_,INTEGER_NEWNODE,(long)g_argc)
@@ -519,11 +618,17 @@ DIPPED(rotated_,"rotated",FOURPARAMS,rotate_)
 
 #define ANDORXOR(PROCEDURE,NAME,OPER1,OPER2)			\
 PRIVATE void PROCEDURE(void)					\
-{   TWOPARAMS(NAME);						\
+{   Operator op;						\
+    Types u;							\
+    TWOPARAMS(NAME);						\
     SAME2TYPES(NAME);						\
     switch (stk->next->op)					\
-      { case SET_:						\
-	    BINARY(SET_NEWNODE,(long)(stk->next->u.set OPER1 stk->u.set)); \
+      { case SET_: case BIGSET_:				\
+	    if (stk->op == SET_ && stk->next->op == SET_)	\
+		BINARY(SET_NEWNODE,(long)(stk->next->u.set OPER1 stk->u.set)); \
+	    else						\
+	      { op = set_binop(stk->next, stk, #OPER1[0], &u);	\
+		GBINARY(op, u); }				\
 	    return;						\
 	case BOOLEAN_: case CHAR_: case INTEGER_: case LIST_:	\
 	    BINARY(BOOLEAN_NEWNODE,(long)(stk->next->u.num OPER2 stk->u.num)); \
@@ -547,12 +652,24 @@ ORDCHR(chr_,"chr",CHAR_NEWNODE)
 
 PRIVATE void abs_(void)
 {
+    Operator op;
+    Types u;
+
     ONEPARAM("abs");
 /* start new */
     FLOAT("abs");
-    if (stk->op == INTEGER_) {
-	if (stk->u.num < 0)
-	    UNARY(INTEGER_NEWNODE, - stk->u.num);
+    if (stk->op == RATIONAL_) {
+	if (rat_sign(stk) < 0) {
+	    op = rat_neg(stk, &u);
+	    GUNARY(op, u);
+	}
+	return;
+    }
+    if (BASETYPE(stk->op) == INTEGER_) {
+	if (stk->op == BIGNUM_ || stk->u.num < 0) {
+	    op = num_abs(stk, &u);
+	    GUNARY(op, u);
+	}
 	return;
     }
 /* end new */
@@ -577,6 +694,10 @@ PRIVATE void sign_(void)
     ONEPARAM("sign");
 /* start new */
     FLOAT("sign");
+    if (stk->op == BIGNUM_ || stk->op == RATIONAL_) {
+	UNARY(INTEGER_NEWNODE, rat_sign(stk));
+	return;
+    }
     if (stk->op == INTEGER_) {
 	if (stk->u.num != 0 && stk->u.num != 1)
 	    UNARY(INTEGER_NEWNODE, stk->u.num > 0 ? 1 : -1);
@@ -593,12 +714,22 @@ PRIVATE void sign_(void)
 
 PRIVATE void neg_(void)
 {
+    Operator op;
+    Types u;
+
     ONEPARAM("neg");
 /* start new */
     FLOAT("neg");
-    if (stk->op == INTEGER_) {
-	if (stk->u.num)
-	    UNARY(INTEGER_NEWNODE, -stk->u.num);
+    if (stk->op == RATIONAL_) {
+	op = rat_neg(stk, &u);
+	GUNARY(op, u);
+	return;
+    }
+    if (BASETYPE(stk->op) == INTEGER_) {
+	if (stk->op == BIGNUM_ || stk->u.num) {
+	    op = num_neg(stk, &u);
+	    GUNARY(op, u);
+	}
 	return;
     }
 /* end new */
@@ -623,29 +754,80 @@ MULDIV(divide_,"/",/,CHECKZERO("/"))
 
 PRIVATE void mul_(void)
 {
+    Operator op;
+    Types u;
+
     TWOPARAMS("*");
+    if (ARRAYS2) {
+	op = arr_arith(stk->next, stk, '*', &u, "*");
+	GBINARY(op, u);
+	return;
+    }
     FLOAT_I(*);
+    if (RATIONALS2) {
+	op = rat_arith(stk->next, stk, '*', &u);
+	GBINARY(op, u);
+	return;
+    }
+    if (BIGNUMS2 ||
+	(stk->op == INTEGER_ && stk->next->op == INTEGER_ &&
+	 OVERFLOW(stk->next->u.num, stk->u.num, mul, &u.num))) {
+	op = num_mul(stk->next, stk, &u);
+	GBINARY(op, u);
+	return;
+    }
     INTEGERS2("*");
-    BINARY(INTEGER_NEWNODE,stk->next->u.num * stk->u.num);
+    BINARY(INTEGER_NEWNODE,u.num);
 }
 
+#define DIVOVERFLOW						\
+    (stk->op == INTEGER_ && stk->u.num == -1 &&			\
+     stk->next->op == INTEGER_ && stk->next->u.num == -MAXINT - 1)
+
 PRIVATE void divide_(void)
 {
+    Operator op, rop;
+    Types u, r;
+
 #ifdef RUNTIME_CHECKS
     TWOPARAMS("/");
     if ((stk->op == FLOAT_   && stk->u.dbl == 0.0) ||
 	(stk->op == INTEGER_ && stk->u.num == 0))
 	execerror("non-zero divisor","/");
 #endif
+    if (ARRAYS2) {
+	op = arr_arith(stk->next, stk, '/', &u, "/");
+	GBINARY(op, u);
+	return;
+    }
     FLOAT_I(/);
+    if (RATIONALS2) {
+	op = rat_arith(stk->next, stk, '/', &u);
+	GBINARY(op, u);
+	return;
+    }
+    if (BIGNUMS2 || DIVOVERFLOW) {
+	op = num_div(stk->next, stk, &u, &rop, &r);
+	GBINARY(op, u);
+	return;
+    }
     INTEGERS2("/");
     BINARY(INTEGER_NEWNODE,stk->next->u.num / stk->u.num);
 }
 
 PRIVATE void rem_(void)
 {
+    Operator op;
+    Types u, r;
+
     TWOPARAMS("rem");
     FLOAT_P(fmod);
+    if (BIGNUMS2 || DIVOVERFLOW) {
+	CHECKZERO("rem");
+	num_div(stk->next, stk, &u, &op, &r);
+	GBINARY(op, r);
+	return;
+    }
     INTEGERS2("rem");
     CHECKZERO("rem");
     BINARY(INTEGER_NEWNODE,stk->next->u.num % stk->u.num);
@@ -658,7 +840,17 @@ PRIVATE void div_(void)
 #else
     lldiv_t result;
 #endif
+    Operator op, rop;
+    Types u, r;
+
     TWOPARAMS("div");
+    if (BIGNUMS2 || DIVOVERFLOW) {
+	CHECKZERO("div");
+	op = num_div(stk->next, stk, &u, &rop, &r);
+	GBINARY(op, u);
+	GNULLARY(rop, r);
+	return;
+    }
     INTEGERS2("div");
     CHECKZERO("div");
 #ifdef BIT_32
@@ -713,7 +905,7 @@ PRIVATE void strtod_(void)
 PRIVATE void format_(void)
 {
     int width, prec;
-    char spec, format[7], *result;
+    char spec, format[8], *result, *text;
 #ifdef USE_SNPRINTF
     int leng;
 #endif
@@ -731,8 +923,23 @@ PRIVATE void format_(void)
     if (!strchr("dioxX", spec))
 	execerror("one of: d i o x X", "format");
 #endif
+    if (stk->op == BIGNUM_ || stk->op == RATIONAL_) {
+	if (spec != 'd' && spec != 'i')
+	    execerror("one of: d i", "format");
+	text = rat_string(stk);
+	result = malloc(strlen(text) + abs(width) + 1);
+	sprintf(result, "%*s", width, text);
+	free(text);
+	UNARY(STRING_NEWNODE, result);
+	return;
+    }
+#ifdef BIT_32
     strcpy(format, "%*.*ld");
     format[5] = spec;
+#else
+    strcpy(format, "%*.*lld");
+    format[6] = spec;
+#endif
 #ifdef USE_SNPRINTF
     leng = snprintf(0, 0, format, width, prec, stk->u.num) + 1;
     result = malloc(leng + 1);
@@ -906,11 +1113,9 @@ PRIVATE void PROCEDURE(void)					\
 UFLOAT(acos_,"acos",acos)
 UFLOAT(asin_,"asin",asin)
 UFLOAT(atan_,"atan",atan)
-UFLOAT(ceil_,"ceil",ceil)
 UFLOAT(cos_,"cos",cos)
 UFLOAT(cosh_,"cosh",cosh)
 UFLOAT(exp_,"exp",exp)
-UFLOAT(floor_,"floor",floor)
 UFLOAT(log_,"log",log)
 UFLOAT(log10_,"log10",log10)
 UFLOAT(sin_,"sin",sin)
@@ -919,6 +1124,21 @@ UFLOAT(sqrt_,"sqrt",sqrt)
 UFLOAT(tan_,"tan",tan)
 UFLOAT(tanh_,"tanh",tanh)
 
+#define ROUND(PROCEDURE,NAME,FUNC,MODE)				\
+PRIVATE void PROCEDURE(void)					\
+{   Operator op;						\
+    Types u;							\
+    ONEPARAM(NAME);						\
+    if (stk->op == RATIONAL_)					\
+      { op = rat_round(stk, MODE, &u);				\
+	GUNARY(op, u);						\
+	return; }						\
+    FLOAT(NAME);						\
+    UNARY(FLOAT_NEWNODE, FUNC(FLOATVAL));			\
+}
+ROUND(ceil_,"ceil",ceil,'c')
+ROUND(floor_,"floor",floor,'f')
+
 #define BFLOAT(PROCEDURE,NAME,FUNC)				\
 PRIVATE void PROCEDURE(void)					\
 {   TWOPARAMS(NAME);						\
@@ -926,7 +1146,22 @@ PRIVATE void PROCEDURE(void)					\
     BINARY(FLOAT_NEWNODE, FUNC(FLOATVAL2, FLOATVAL));		\
 }
 BFLOAT(atan2_,"atan2",atan2)
-BFLOAT(pow_,"pow",pow)
+
+PRIVATE void pow_(void)
+{
+    Operator op;
+    Types u;
+
+    TWOPARAMS("pow");
+    if (stk->op == INTEGER_ && stk->u.num >= 0 &&
+	BASETYPE(stk->next->op) == INTEGER_) {
+	op = num_pow(stk->next, stk->u.num, &u);
+	GBINARY(op, u);
+	return;
+    }
+    FLOAT2("pow");
+    BINARY(FLOAT_NEWNODE, pow(FLOATVAL2, FLOATVAL));
+}
 
 PRIVATE void frexp_(void)
 {
@@ -962,34 +1197,98 @@ PRIVATE void ldexp_(void)
 
 PRIVATE void trunc_(void)
 {
+    Operator op;
+    Types u;
+
     ONEPARAM("trunc");
+    if (EXACT(stk->op)) {
+	op = rat_round(stk, 't', &u);
+	GUNARY(op, u);
+	return;
+    }
     FLOAT("trunc");
-    UNARY(INTEGER_NEWNODE, (long)FLOATVAL);
+    UNARY(INTEGER_NEWNODE, (Num)FLOATVAL);
+}
+
+PRIVATE void ratio_(void)
+{
+    Operator op;
+    Types u;
+
+    TWOPARAMS("ratio");
+    EXACT2("ratio");
+    if (rat_sign(stk) == 0)
+	execerror("non-zero divisor", "ratio");
+    op = rat_arith(stk->next, stk, '/', &u);
+    GBINARY(op, u);
+}
+
+PRIVATE void numerator_(void)
+{
+    ONEPARAM("numerator");
+    EXACTTYPE("numerator");
+    if (stk->op == RATIONAL_)
+	GUNARY(stk->u.rat->num.op, stk->u.rat->num.u);
+}
+
+PRIVATE void denominator_(void)
+{
+    ONEPARAM("denominator");
+    EXACTTYPE("denominator");
+    if (stk->op == RATIONAL_)
+	GUNARY(stk->u.rat->den.op, stk->u.rat->den.u);
+    else
+	UNARY(INTEGER_NEWNODE, 1L);
 }
 
 /* - - -   NUMERIC   - - - */
 
-#define PREDSUCC(PROCEDURE,NAME,OPER)				\
+#define PREDSUCC(PROCEDURE,NAME,OPER,OVER)			\
 PRIVATE void PROCEDURE(void)					\
-{   ONEPARAM(NAME);						\
+{   Operator op;						\
+    Types u;							\
+    ONEPARAM(NAME);						\
+    if (stk->op == BIGNUM_ || stk->op == RATIONAL_ ||		\
+	(stk->op == INTEGER_ &&					\
+	 OVERFLOW(stk->u.num, (Num)1, OVER, &u.num)))		\
+      { stk = INTEGER_NEWNODE(1L, stk);				\
+	op = rat_arith(stk->next, stk, #OPER[0], &u);		\
+	GBINARY(op, u);						\
+	return; }						\
     NUMERICTYPE(NAME);						\
     if (stk->op == CHAR_)					\
 	UNARY(CHAR_NEWNODE, stk->u.num OPER 1);			\
     else UNARY(INTEGER_NEWNODE, stk->u.num OPER 1); }
-PREDSUCC(pred_,"pred",-)
-PREDSUCC(succ_,"succ",+)
+PREDSUCC(pred_,"pred",-,sub)
+PREDSUCC(succ_,"succ",+,add)
 
-#define PLUSMINUS(PROCEDURE,NAME,OPER)				\
+#define PLUSMINUS(PROCEDURE,NAME,OPER,OVER)			\
 PRIVATE void PROCEDURE(void)					\
-{   TWOPARAMS(NAME);						\
+{   Operator op;						\
+    Types u;							\
+    TWOPARAMS(NAME);						\
+    if (ARRAYS2)						\
+      { op = arr_arith(stk->next, stk, #OPER[0], &u, NAME);	\
+	GBINARY(op, u);						\
+	return; }						\
     FLOAT_I(OPER);						\
+    if (RATIONALS2)						\
+      { op = rat_arith(stk->next, stk, #OPER[0], &u);		\
+	GBINARY(op, u);						\
+	return; }						\
+    if (BIGNUMS2 ||						\
+	(stk->op == INTEGER_ && stk->next->op == INTEGER_ &&	\
+	 OVERFLOW(stk->next->u.num, stk->u.num, OVER, &u.num)))	\
+      { op = num_add(stk->next, stk, #OPER[0], &u);		\
+	GBINARY(op, u);						\
+	return; }						\
     INTEGER(NAME);						\
     NUMERIC2(NAME);						\
     if (stk->next->op == CHAR_)					\
 	BINARY(CHAR_NEWNODE, stk->next->u.num OPER stk->u.num);	\
     else BINARY(INTEGER_NEWNODE, stk->next->u.num OPER stk->u.num); }
-PLUSMINUS(plus_,"+",+)
-PLUSMINUS(minus_,"-",-)
+PLUSMINUS(plus_,"+",+,add)
+PLUSMINUS(minus_,"-",-,sub)
 
 #define MAXMIN(PROCEDURE,NAME,OPER)				\
 PRIVATE void PROCEDURE(void)					\
@@ -999,6 +1298,12 @@ PRIVATE void PROCEDURE(void)					\
 	    FLOATVAL OPER FLOATVAL2 ?				\
 	    FLOATVAL2 : FLOATVAL);				\
 	return; }						\
+    if (BIGNUMS2 || RATIONALS2)					\
+      { if (rat_compare(stk, stk->next) OPER 0)		\
+	    stk = stk->next;					\
+	else							\
+	    GBINARY(stk->op, stk->u);				\
+	return; }						\
     SAME2TYPES(NAME);						\
     NUMERICTYPE(NAME);						\
     if (stk->op == CHAR_)					\
@@ -1012,23 +1317,55 @@ MAXMIN(max_,"max",<)
 MAXMIN(min_,"min",>)
 
 #if defined(CORRECT_INHAS_COMPARE) || defined(CORRECT_TYPE_COMPARE) || defined(CORRECT_CASE_COMPARE)
-PRIVATE double Compare(Node *first, Node *second, int *error)
+#define INTEGRAL(OP)						\
+    ((OP) == BOOLEAN_ || (OP) == CHAR_ || (OP) == INTEGER_ || (OP) == BIGNUM_)
+
+PUBLIC double Compare(Node *first, Node *second, int *error)
 {
     *error = 0;
+    if (INTEGRAL(first->op) && INTEGRAL(second->op)) {
+	if (first->op == BIGNUM_ || second->op == BIGNUM_)
+	    return num_compare(first, second);
+	return (first->u.num > second->u.num) - (first->u.num < second->u.num);
+    }
+    if (EXACT(first->op) && EXACT(second->op))
+	return rat_compare(first, second);
+    if (first->op == BIGNUM_ && second->op == FLOAT_)
+	return num_double(first) - second->u.dbl;
+    if (first->op == FLOAT_ && second->op == BIGNUM_)
+	return first->u.dbl - num_double(second);
+    if (first->op == RATIONAL_ && second->op == FLOAT_)
+	return rat_double(first) - second->u.dbl;
+    if (first->op == FLOAT_ && second->op == RATIONAL_)
+	return first->u.dbl - rat_double(second);
     switch (first->op) {
     case USR_	      :
 	switch (second->op) {
-	case USR_     : return strcmp(first->u.ent->name, second->u.ent->name);
+	case USR_     : return STRCMP(first->u.ent->name, second->u.ent->name);
 	case ANON_FUNCT_ :
 	case BOOLEAN_ :
 	case CHAR_    :
 	case INTEGER_ :
-	case SET_     : break;
-	case STRING_  : return strcmp(first->u.ent->name, second->u.str);
+	case BIGNUM_  :
+	case RATIONAL_ :
+	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    : break;
+	case STRING_  : return STRCMP(first->u.ent->name, second->u.str);
 	case LIST_    :
 	case FLOAT_   :
 	case FILE_    : break;
-	default       : return strcmp(first->u.ent->name, opername(second->op));
+	default       : return STRCMP(first->u.ent->name, opername(second->op));
 	}
 	break;
     case ANON_FUNCT_  :
@@ -1039,7 +1376,21 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case BOOLEAN_ :
 	case CHAR_    :
 	case INTEGER_ :
+	case BIGNUM_  :
+	case RATIONAL_ :
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    :
 	case FLOAT_   :
@@ -1056,6 +1407,18 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case CHAR_    :
 	case INTEGER_ : return first->u.num - second->u.num;
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    : break;
 	case FLOAT_   : return first->u.num - second->u.dbl;
@@ -1072,6 +1435,18 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case CHAR_    :
 	case INTEGER_ : return first->u.num - second->u.num;
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    : break;
 	case FLOAT_   : return first->u.num - second->u.dbl;
@@ -1088,6 +1463,18 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case CHAR_    :
 	case INTEGER_ : return first->u.num - second->u.num;
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    : break;
 	case FLOAT_   : return first->u.num - second->u.dbl;
@@ -1096,13 +1483,28 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	}
 	break;
     case SET_	 :
+    case BIGSET_	 :
 	switch (second->op) {
 	case USR_     :
 	case ANON_FUNCT_ :
 	case BOOLEAN_ :
 	case CHAR_    :
-	case INTEGER_ : break;
-	case SET_     : return first->u.set - second->u.set;
+	case INTEGER_ :
+	case BIGNUM_  :
+	case RATIONAL_ : break;
+	case SET_     :
+	case BIGSET_  : return set_compare(first, second);
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    :
 	case FLOAT_   :
@@ -1112,17 +1514,31 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	break;
     case STRING_      :
 	switch (second->op) {
-	case USR_     : return strcmp(first->u.str, second->u.ent->name);
+	case USR_     : return STRCMP(first->u.str, second->u.ent->name);
 	case ANON_FUNCT_ :
 	case BOOLEAN_ :
 	case CHAR_    :
 	case INTEGER_ :
-	case SET_     : break;
-	case STRING_  : return strcmp(first->u.str, second->u.str);
+	case BIGNUM_  :
+	case RATIONAL_ :
+	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    : break;
+	case STRING_  : return STRCMP(first->u.str, second->u.str);
 	case LIST_    :
 	case FLOAT_   :
 	case FILE_    : break;
-	default       : return strcmp(first->u.str, opername(second->op));
+	default       : return STRCMP(first->u.str, opername(second->op));
 	}
 	break;
     case LIST_	      :
@@ -1132,7 +1548,21 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case BOOLEAN_ :
 	case CHAR_    :
 	case INTEGER_ :
+	case BIGNUM_  :
+	case RATIONAL_ :
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    :
 	case FLOAT_   :
@@ -1149,6 +1579,18 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case CHAR_    :
 	case INTEGER_ : return first->u.dbl - second->u.num;
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    : break;
 	case FLOAT_   : return first->u.dbl - second->u.dbl;
@@ -1156,6 +1598,47 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	default       : break;
 	}
 	break;
+    case BIGNUM_      :
+    case RATIONAL_    :
+	break;
+    case DICT_	      :
+	if (second->op == DICT_)
+	    return !dict_equal(first->u.dict, second->u.dict);
+	break;
+    case FLOATARRAY_  :
+    case INTARRAY_    :
+	if (ARRAY(second->op))
+	    return !arr_equal(first, second);
+	break;
+    case VECTOR_      :
+	if (second->op == VECTOR_)
+	    return !vec_equal(first->u.vec, second->u.vec);
+	break;
+    case DEQUE_       :
+	if (second->op == DEQUE_)
+	    return !deq_equal(first->u.deq, second->u.deq);
+	break;
+    case HEAP_        :
+	if (second->op == HEAP_)
+	    return first->u.heap != second->u.heap;
+	break;
+    case ORDSET_      :
+    case ORDMAP_      :
+	if (second->op == first->op)
+	    return !ord_equal(first->u.ord, second->u.ord, first->op == ORDMAP_);
+	break;
+    case STREAM_      :
+	if (second->op == STREAM_)
+	    return first->u.stream != second->u.stream;
+	break;
+    case RANGE_       :
+	if (second->op == RANGE_)
+	    return !rng_equal(first->u.rng, second->u.rng);
+	break;
+    case CHANNEL_     :
+	if (second->op == CHANNEL_)
+	    return first->u.chan != second->u.chan;
+	break;
     case FILE_	      :
 	switch (second->op) {
 	case USR_     :
@@ -1163,7 +1646,21 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	case BOOLEAN_ :
 	case CHAR_    :
 	case INTEGER_ :
+	case BIGNUM_  :
+	case RATIONAL_ :
 	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    :
 	case STRING_  :
 	case LIST_    :
 	case FLOAT_   : break;
@@ -1173,17 +1670,31 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 	break;
     default	      :
 	switch (second->op) {
-	case USR_     : return strcmp(opername(first->op), second->u.ent->name);
+	case USR_     : return STRCMP(opername(first->op), second->u.ent->name);
 	case ANON_FUNCT_ :
 	case BOOLEAN_ :
 	case CHAR_    :
 	case INTEGER_ :
-	case SET_     : break;
-	case STRING_  : return strcmp(opername(first->op), second->u.str);
+	case BIGNUM_  :
+	case RATIONAL_ :
+	case SET_     :
+	case BIGSET_  :
+	case FLOATARRAY_ :
+	case INTARRAY_ :
+	case VECTOR_  :
+	case DEQUE_   :
+	case HEAP_    :
+	case ORDSET_  :
+	case ORDMAP_  :
+	case STREAM_  :
+	case RANGE_   :
+	case CHANNEL_ :
+	case DICT_    : break;
+	case STRING_  : return STRCMP(opername(first->op), second->u.str);
 	case LIST_    :
 	case FLOAT_   :
 	case FILE_    : break;
-	default       : return strcmp(opername(first->op), opername(second->op));
+	default       : return STRCMP(opername(first->op), opername(second->op));
 	}
 	break;
     }
@@ -1193,15 +1704,18 @@ PRIVATE double Compare(Node *first, Node *second, int *error)
 #endif
 
 #ifdef CORRECT_TYPE_COMPARE
-#define COMPREL(PROCEDURE,NAME,CONSTRUCTOR,OPR,SETCMP)		\
+#define COMPREL(PROCEDURE,NAME,CONSTRUCTOR,OPR,SETCMP,NUMCMP)	\
 PRIVATE void PROCEDURE(void)					\
   { double cmp;							\
     int comp = 0, error, i, j;					\
     TWOPARAMS(NAME);						\
-    if (stk->op == SET_) {					\
+    if (BASETYPE(stk->op) == SET_ && BASETYPE(stk->next->op) == SET_) { \
+	i = (!set_subset(stk->next, stk)) | (!set_subset(stk, stk->next)) << 1; \
+	comp = SETCMP;						\
+    } else if (stk->op == SET_) {				\
 	i = stk->next->u.num;					\
 	j = stk->u.num;						\
-	comp = SETCMP;						\
+	comp = NUMCMP;						\
     } else {							\
 	cmp = Compare(stk->next, stk, &error);			\
 	if (error)						\
@@ -1248,7 +1762,7 @@ PRIVATE void PROCEDURE(void)					\
 	default:						\
 	    if (stk->next->op == LIST_)				\
 	      BADDATA(NAME);					\
-	    comp = strcmp(GETSTRING(stk->next), GETSTRING(stk))	\
+	    comp = STRCMP(GETSTRING(stk->next), GETSTRING(stk))	\
 		   OPR 0;					\
 	    break; }						\
     stk = CONSTRUCTOR(comp, stk->next->next); }
@@ -1256,13 +1770,14 @@ PRIVATE void PROCEDURE(void)					\
 #endif
 
 #ifdef CORRECT_TYPE_COMPARE
-COMPREL(eql_,"=",BOOLEAN_NEWNODE,==,i==j)
-COMPREL(neql_,"!=",BOOLEAN_NEWNODE,!=,i!=j)
-COMPREL(less_,"<",BOOLEAN_NEWNODE,<,i!=j&&!(i&~j))
-COMPREL(leql_,"<=",BOOLEAN_NEWNODE,<=,!(i&~j))
-COMPREL(greater_,">",BOOLEAN_NEWNODE,>,i!=j&&!(j&~i))
-COMPREL(geql_,">=",BOOLEAN_NEWNODE,>=,!(j&~i))
-COMPREL(compare_,"compare",INTEGER_NEWNODE,+,i-j<0?-1:i-j>0)
+COMPREL(eql_,"=",BOOLEAN_NEWNODE,==,i==0,i==j)
+COMPREL(neql_,"!=",BOOLEAN_NEWNODE,!=,i!=0,i!=j)
+COMPREL(less_,"<",BOOLEAN_NEWNODE,<,i==2,i!=j&&!(i&~j))
+COMPREL(leql_,"<=",BOOLEAN_NEWNODE,<=,!(i&1),!(i&~j))
+COMPREL(greater_,">",BOOLEAN_NEWNODE,>,i==1,i!=j&&!(j&~i))
+COMPREL(geql_,">=",BOOLEAN_NEWNODE,>=,!(i&2),!(j&~i))
+COMPREL(compare_,"compare",INTEGER_NEWNODE,+,i?set_compare(stk->next,stk):0,
+	i-j<0?-1:i-j>0)
 #else
 COMPREL(eql_,"=",BOOLEAN_NEWNODE,==)
 COMPREL(neql_,"!=",BOOLEAN_NEWNODE,!=)
@@ -1277,7 +1792,7 @@ COMPREL(compare_,"compare",INTEGER_NEWNODE,+)
 PRIVATE void sametype_(void)
 {
     TWOPARAMS("sametype");
-    BINARY(BOOLEAN_NEWNODE, stk->op == stk->next->op);
+    BINARY(BOOLEAN_NEWNODE, BASETYPE(stk->op) == BASETYPE(stk->next->op));
 }
 #endif
 
@@ -1507,6 +2022,227 @@ PRIVATE void fseek_(void)
     NULLARY(BOOLEAN_NEWNODE, (long)!!fseek(stk->u.fil, pos, whence));
 }
 
+/* - - -   LAZY STREAMS   - - - */
+
+/*
+    stream_unary runs prog, with x on top of the stack when it is given,
+    and pushes the value it delivers on the stack as it was before. Both
+    are kept in streams, that the garbage collector does not move.
+*/
+#ifdef SINGLE
+PRIVATE void stream_unary(Node *prog, Node *x)
+{
+    Node *save = stk;
+
+    if (x)
+	stk = newnode(x->op, x->u, stk);
+    exeterm(prog->u.lis);
+    if (stk == NULL)
+	execerror("value to push", "stream");
+    stk = newnode(stk->op, stk->u, save);
+}
+#else
+PRIVATE void stream_unary(Node *prog, Node *x)
+{
+    SAVESTACK;
+    if (x)
+	stk = newnode(x->op, x->u, stk);
+    exeterm(prog->u.lis);
+    if (stk == NULL)
+	execerror("value to push", "stream");
+    stk = newnode(stk->op, stk->u, SAVED1);
+    POP(dump);
+}
+#endif
+
+/*
+    stream_step replaces the non-empty stream on top of the stack by its
+    rest when advance is set; otherwise the stream is a new one, of which
+    the head is still to be found, and it is replaced by what it stands
+    for. The streams that are made on the way stay on the stack.
+*/
+PRIVATE void stream_step(int advance)
+{
+    Stream *s = stk->u.stream, *t = NULL;
+    Node *pair;
+
+    switch (s->kind)
+      { case 'l':
+	    t = advance ? str_list(s->state.u.lis->next) : s;
+	    break;
+	case 'u':
+	    if (advance)
+		stream_unary(&s->prog, &s->head);
+	    else
+		stk = newnode(s->head.op, s->head.u, stk);
+	    if (s->test.op == LIST_)
+	      { stream_unary(&s->test, NULL);
+		if (!stk->u.num)
+		  { stk = stk->next->next;
+		    break; }
+		POP(stk); }
+	    t = str_new('u', stk, &s->prog, &s->test, NULL, NULL);
+	    POP(stk);
+	    break;
+	case 'm':
+	    stk = STREAM_NEWNODE(s->src, stk);
+	    if (advance)
+		stream_step(1);
+	    if (stk->u.stream)
+	      { stream_unary(&s->prog, &stk->u.stream->head);
+		t = str_new('m', stk, &s->prog, NULL, stk->next->u.stream, NULL);
+		POP(stk); }
+	    POP(stk);
+	    break;
+	case 'f':
+	    stk = STREAM_NEWNODE(s->src, stk);
+	    if (advance)
+		stream_step(1);
+	    while (stk->u.stream)
+	      { stream_unary(&s->test, &stk->u.stream->head);
+		if (stk->u.num)
+		  { POP(stk);
+		    t = str_new('f', &stk->u.stream->head, NULL, &s->test,
+				stk->u.stream, NULL);
+		    break; }
+		POP(stk);
+		stream_step(1); }
+	    POP(stk);
+	    break;
+	case 'z':
+	    stk = STREAM_NEWNODE(s->src, stk);
+	    if (advance)
+		stream_step(1);
+	    stk = STREAM_NEWNODE(s->src2, stk);
+	    if (advance)
+		stream_step(1);
+	    if (stk->u.stream && stk->next->u.stream)
+	      { pair = newnode(stk->u.stream->head.op,
+			       stk->u.stream->head.u, NULL);
+		pair = newnode(stk->next->u.stream->head.op,
+			       stk->next->u.stream->head.u, pair);
+		stk = LIST_NEWNODE(pair, stk);
+		t = str_new('z', stk, NULL, NULL, stk->next->next->u.stream,
+			    stk->next->u.stream);
+		POP(stk); }
+	    stk = stk->next->next;
+	    break;
+	case 'c':
+	    stream_unary(&s->prog, NULL);
+	    if (stk->op == LIST_)
+		t = str_list(stk->u.lis);
+	    else if (stk->op == STREAM_)
+		t = stk->u.stream;
+	    else
+		execerror("stream or list", "lcons");
+	    POP(stk);
+	    break; }
+    UNARY(STREAM_NEWNODE, t);
+}
+
+/*
+    stream_rest delivers the rest of the non-empty stream s. It must be
+    kept where the garbage collector can find it, before anything else.
+*/
+PRIVATE Stream *stream_rest(Stream *s)
+{
+    stk = STREAM_NEWNODE(s, stk);
+    stream_step(1);
+    s = stk->u.stream;
+    POP(stk);
+    return s;
+}
+
+/*
+    stream_make replaces a stream and a quotation by the stream that maps
+    the quotation over it, when kind is 'm', or that filters it with the
+    quotation, when kind is 'f'.
+*/
+PRIVATE void stream_make(int kind)
+{
+    Stream *t;
+
+    if (kind == 'm')
+	t = str_new('m', NULL, stk, NULL, stk->next->u.stream, NULL);
+    else
+	t = str_new('f', NULL, NULL, stk, stk->next->u.stream, NULL);
+    BINARY(STREAM_NEWNODE, t);
+    stream_step(0);
+}
+
+PRIVATE Stream *stream_of(Node *n, char *name)
+{
+    if (n->op == LIST_)
+	return str_list(n->u.lis);
+    if (n->op != STREAM_)
+	execerror("stream or list", name);
+    return n->u.stream;
+}
+
+PRIVATE void lazy_(void)
+{
+    ONEPARAM("lazy");
+    UNARY(STREAM_NEWNODE, stream_of(stk, "lazy"));
+}
+
+PRIVATE void lcons_(void)
+{
+    Stream *t;
+
+    TWOPARAMS("lcons");
+    ONEQUOTE("lcons");
+    t = str_new('c', stk->next, stk, NULL, NULL, NULL);
+    BINARY(STREAM_NEWNODE, t);
+}
+
+PRIVATE void lzip_(void)
+{
+    Stream *t;
+
+    TWOPARAMS("lzip");
+    t = str_new('z', NULL, NULL, NULL, stream_of(stk->next, "lzip"),
+		stream_of(stk, "lzip"));
+    BINARY(STREAM_NEWNODE, t);
+    stream_step(0);
+}
+
+PRIVATE void iterate_(void)
+{
+    Stream *t;
+
+    TWOPARAMS("iterate");
+    ONEQUOTE("iterate");
+    t = str_new('u', stk->next, stk, NULL, NULL, NULL);
+    BINARY(STREAM_NEWNODE, t);
+}
+
+PRIVATE void unfold_(void)
+{
+    Stream *t;
+
+    THREEPARAMS("unfold");
+    TWOQUOTES("unfold");
+    t = str_new('u', stk->next->next, stk, stk->next, NULL, NULL);
+    stk = STREAM_NEWNODE(t, stk->next->next->next);
+    stream_step(0);
+}
+
+PRIVATE void rmake_(void)
+{
+    Range *r;
+
+    THREEPARAMS("rmake");
+    INTEGER("rmake");
+    if (!stk->u.num)
+	execerror("non-zero step", "rmake");
+    if ((stk->next->op != INTEGER_ || stk->next->next->op != INTEGER_) &&
+	(stk->next->op != CHAR_ || stk->next->next->op != CHAR_))
+	execerror("two integers or two characters", "rmake");
+    r = rng_make(stk->next->op, stk->next->next->u.num, stk->next->u.num,
+		 stk->u.num);
+    stk = RANGE_NEWNODE(r, stk->next->next->next);
+}
+
 /* - - -   AGGREGATES   - - - */
 
 PRIVATE void first_(void)
@@ -1521,26 +2257,38 @@ PRIVATE void first_(void)
 	    CHECKEMPTYSTRING(stk->u.str,"first");
 	    UNARY(CHAR_NEWNODE,(long)*(stk->u.str));
 	    return;
-	case SET_:
-	  { long i = 0;
+	case SET_: case BIGSET_:
 	    CHECKEMPTYSET(stk->u.set,"first");
-	    while (!(stk->u.set & (1 << i))) i++;
-	    UNARY(INTEGER_NEWNODE,i);
-	    return; }
+	    UNARY(INTEGER_NEWNODE,set_next(stk,0));
+	    return;
+	case STREAM_:
+	    CHECKEMPTYSTREAM(stk->u.stream,"first");
+	    GUNARY(stk->u.stream->head.op,stk->u.stream->head.u);
+	    return;
+	case RANGE_:
+	    CHECKEMPTYRANGE(stk->u.rng,"first");
+	    bucket.num = stk->u.rng->lo;
+	    GUNARY(stk->u.rng->type,bucket);
+	    return;
 	default:
 	    BADAGGREGATE("first"); }
 }
 
 PRIVATE void rest_(void)
 {
+    Operator op;
+    Types u;
+
     ONEPARAM("rest");
     switch (stk->op)
       { case SET_:
-	  { int i = 0;
 	    CHECKEMPTYSET(stk->u.set,"rest");
-	    while (!(stk->u.set & (1 << i))) i++;
-	    UNARY(SET_NEWNODE,stk->u.set & ~(1 << i));
-	    break; }
+	    UNARY(SET_NEWNODE,stk->u.set & (stk->u.set - 1));
+	    break;
+	case BIGSET_:
+	    op = set_remove(stk, set_next(stk, 0), &u);
+	    GUNARY(op, u);
+	    break;
 	case STRING_:
 	  { char *s = stk->u.str;
 	    CHECKEMPTYSTRING(s,"rest");
@@ -1550,6 +2298,17 @@ PRIVATE void rest_(void)
 	    CHECKEMPTYLIST(stk->u.lis,"rest");
 	    UNARY(LIST_NEWNODE,stk->u.lis->next);
 	    return;
+	case STREAM_:
+	    CHECKEMPTYSTREAM(stk->u.stream,"rest");
+	    stream_step(1);
+	    return;
+	case RANGE_:
+	  { Range *r = stk->u.rng;
+	    CHECKEMPTYRANGE(r,"rest");
+	    r = rng_size(r) > 1 ? rng_make(r->type,rng_nth(r,1),r->hi,r->by)
+				: rng_make(r->type,1,0,1);	/* empty */
+	    UNARY(RANGE_NEWNODE,r);
+	    return; }
 	default:
 	    BADAGGREGATE("rest"); }
 }
@@ -1559,14 +2318,18 @@ PRIVATE void uncons_(void)
 #ifdef SINGLE
     Node *save;
 #endif
+    Operator op;
+    Types u;
+
     ONEPARAM("uncons");
     switch (stk->op)
-      { case SET_:
-	  { long i = 0; long set = stk->u.set;
-	    CHECKEMPTYSET(set,"uncons");
-	    while (!(set & (1 << i))) i++;
+      { case SET_: case BIGSET_:
+	  { long i;
+	    CHECKEMPTYSET(stk->u.set,"uncons");
+	    i = set_next(stk, 0);
+	    op = set_remove(stk, i, &u);
 	    UNARY(INTEGER_NEWNODE,i);
-	    NULLARY(SET_NEWNODE,set & ~(1 << i));
+	    GNULLARY(op, u);
 	    break; }
 	case STRING_:
 	  { char *s = stk->u.str;
@@ -1588,6 +2351,13 @@ PRIVATE void uncons_(void)
 	    POP(dump);
 #endif
 	    return;
+	case STREAM_:
+	    CHECKEMPTYSTREAM(stk->u.stream,"uncons");
+	    GNULLARY(stk->u.stream->head.op,stk->u.stream->head.u);
+	    stk = STREAM_NEWNODE(stk->next->u.stream,stk);
+	    stream_step(1);
+	    stk->next->next = stk->next->next->next;
+	    return;
 	default:
 	    BADAGGREGATE("uncons"); }
 }
@@ -1597,13 +2367,17 @@ PRIVATE void unswons_(void)
 #ifdef SINGLE
     Node *save;
 #endif
+    Operator op;
+    Types u;
+
     ONEPARAM("unswons");
     switch (stk->op)
-      { case SET_:
-	  { long i = 0; long set = stk->u.set;
-	    CHECKEMPTYSET(set,"unswons");
-	    while (!(set & (1 << i))) i++;
-	    UNARY(SET_NEWNODE,set & ~(1 << i));
+      { case SET_: case BIGSET_:
+	  { long i;
+	    CHECKEMPTYSET(stk->u.set,"unswons");
+	    i = set_next(stk, 0);
+	    op = set_remove(stk, i, &u);
+	    GUNARY(op, u);
 	    NULLARY(INTEGER_NEWNODE,i);
 	    break; }
 	case STRING_:
@@ -1626,22 +2400,29 @@ PRIVATE void unswons_(void)
 	    POP(dump);
 #endif
 	    return;
+	case STREAM_:
+	    CHECKEMPTYSTREAM(stk->u.stream,"unswons");
+	    stk = STREAM_NEWNODE(stk->u.stream,stk);
+	    stream_step(1);
+	    GNULLARY(stk->next->u.stream->head.op,stk->next->u.stream->head.u);
+	    stk->next->next = stk->next->next->next;
+	    return;
 	default:
 	    BADAGGREGATE("unswons"); }
 }
 
-PRIVATE long equal_aux(Node *n1,Node *n2); /* forward */
+PUBLIC long equal_aux(Node *n1,Node *n2); /* forward */
 
 PRIVATE int equal_list_aux(Node *n1,Node *n2)
 {
-    if (n1 == NULL && n2 == NULL) return 1;
+    if (n1 == n2) return 1;			/* shared */
     if (n1 == NULL || n2 == NULL) return 0;
     if (equal_aux(n1,n2))
 	return equal_list_aux(n1->next,n2->next);
     else return 0;
 }
 
-PRIVATE long equal_aux(Node *n1,Node *n2)
+PUBLIC long equal_aux(Node *n1,Node *n2)
 {
 #ifdef CORRECT_TYPE_COMPARE
     int error;
@@ -1659,14 +2440,35 @@ PRIVATE long equal_aux(Node *n1,Node *n2)
 		n2->op != INTEGER_)
 		return 0;
 	    return n1->u.num == n2->u.num;
-	case SET_ :
-	    if (n2->op != SET_) return 0;
-	    return n1->u.num == n2->u.num;
+	case BIGNUM_ : case RATIONAL_ :
+	    return n2->op == n1->op && !rat_compare(n1,n2);
+	case SET_ : case BIGSET_ :
+	    if (BASETYPE(n2->op) != SET_) return 0;
+	    return !set_compare(n1,n2);
 	case LIST_ :
 	    if (n2->op != LIST_) return 0;
 	    return equal_list_aux(n1->u.lis,n2->u.lis);
+	case DICT_ :
+	    if (n2->op != DICT_) return 0;
+	    return dict_equal(n1->u.dict,n2->u.dict);
+	case FLOATARRAY_ : case INTARRAY_ :
+	    return arr_equal(n1,n2);
+	case VECTOR_ :
+	    return n2->op == VECTOR_ && vec_equal(n1->u.vec,n2->u.vec);
+	case DEQUE_ :
+	    return n2->op == DEQUE_ && deq_equal(n1->u.deq,n2->u.deq);
+	case HEAP_ :
+	    return n2->op == HEAP_ && n1->u.heap == n2->u.heap;
+	case ORDSET_ : case ORDMAP_ :
+	    return n2->op == n1->op && ord_equal(n1->u.ord,n2->u.ord,n1->op == ORDMAP_);
+	case STREAM_ :
+	    return n2->op == STREAM_ && n1->u.stream == n2->u.stream;
+	case RANGE_ :
+	    return n2->op == RANGE_ && rng_equal(n1->u.rng,n2->u.rng);
+	case CHANNEL_ :
+	    return n2->op == CHANNEL_ && n1->u.chan == n2->u.chan;
 	default:
-	    return strcmp(GETSTRING(n1),GETSTRING(n2)) == 0; }
+	    return STRCMP(GETSTRING(n1),GETSTRING(n2)) == 0; }
 #endif
 }
 
@@ -1682,8 +2484,18 @@ PRIVATE void PROCEDURE(void)					\
 {   int found = 0, error;					\
     TWOPARAMS(NAME);						\
     switch (AGGR->op)						\
-      { case SET_:						\
-	    found = ((AGGR->u.set) & (1 << ELEM->u.num)) > 0;	\
+      { case SET_: case BIGSET_:				\
+	    found = set_member(AGGR, ELEM->u.num);		\
+	    break;						\
+	case DICT_:						\
+	    found = dict_get(AGGR->u.dict, ELEM) != NULL;	\
+	    break;						\
+	case ORDSET_: case ORDMAP_:				\
+	    found = ord_find(AGGR->u.ord, ELEM, NAME) != NULL;	\
+	    break;						\
+	case RANGE_:						\
+	    found = (ELEM->op == INTEGER_ || ELEM->op == CHAR_) && \
+		    rng_member(AGGR->u.rng, ELEM->u.num);	\
 	    break;						\
 	case STRING_:						\
 	  { char *s;						\
@@ -1708,8 +2520,18 @@ PRIVATE void PROCEDURE(void)					\
 {   int found = 0;						\
     TWOPARAMS(NAME);						\
     switch (AGGR->op)						\
-      { case SET_:						\
-	    found = ((AGGR->u.set) & (1 << ELEM->u.num)) > 0;	\
+      { case SET_: case BIGSET_:				\
+	    found = set_member(AGGR, ELEM->u.num);		\
+	    break;						\
+	case DICT_:						\
+	    found = dict_get(AGGR->u.dict, ELEM) != NULL;	\
+	    break;						\
+	case ORDSET_: case ORDMAP_:				\
+	    found = ord_find(AGGR->u.ord, ELEM, NAME) != NULL;	\
+	    break;						\
+	case RANGE_:						\
+	    found = (ELEM->op == INTEGER_ || ELEM->op == CHAR_) && \
+		    rng_member(AGGR->u.rng, ELEM->u.num);	\
 	    break;						\
 	case STRING_:						\
 	  { char *s;						\
@@ -1720,7 +2542,8 @@ PRIVATE void PROCEDURE(void)					\
 	    break; }						\
 	case LIST_:						\
 	  { Node *n = AGGR->u.lis;				\
-	    while (n != NULL && n->u.num != ELEM->u.num)	\
+	    while (n != NULL && (BOXED(n->op) || BOXED(ELEM->op) ? \
+		   !equal_aux(n, ELEM) : n->u.num != ELEM->u.num)) \
 		n = n->next;					\
 	    found = n != NULL;					\
 	    break; }						\
@@ -1732,81 +2555,619 @@ PRIVATE void PROCEDURE(void)					\
 INHAS(in_,"in",stk,stk->next)
 INHAS(has_,"has",stk->next,stk)
 
-#ifdef RUNTIME_CHECKS
-#define OF_AT(PROCEDURE,NAME,AGGR,INDEX)			\
-PRIVATE void PROCEDURE(void)					\
-{   TWOPARAMS(NAME);						\
-    if (INDEX->op != INTEGER_ || INDEX->u.num < 0)		\
-	execerror("non-negative integer", NAME);		\
-    switch (AGGR->op)						\
-      { case SET_:						\
-	  { long i; int indx = INDEX->u.num;			\
-	    CHECKEMPTYSET(AGGR->u.set,NAME);			\
-	    for (i = 0; i < SETSIZE; i++)			\
-	      { if (AGGR->u.set & (1 << i))			\
-		  { if (indx == 0)				\
-			{BINARY(INTEGER_NEWNODE,i); return;}	\
-		    indx--; } }					\
-	    INDEXTOOLARGE(NAME);				\
-	    return; }						\
-	case STRING_:						\
-	    if (strlen(AGGR->u.str) < (size_t)INDEX->u.num)	\
-		INDEXTOOLARGE(NAME);				\
-	    BINARY(CHAR_NEWNODE,(long)AGGR->u.str[INDEX->u.num]);	\
-	    return;						\
-	case LIST_:						\
-	  { Node *n = AGGR->u.lis;  int i  = INDEX->u.num;	\
-	    CHECKEMPTYLIST(n,NAME);				\
-	    while (i > 0)					\
-	      { if (n->next == NULL)				\
-		    INDEXTOOLARGE(NAME);			\
-		n = n->next; i--; }				\
-	    GBINARY(n->op,n->u);				\
-	    return; }						\
-	default:						\
-	    BADAGGREGATE(NAME); }				\
+PRIVATE void dmake_(void)
+{
+    Dict *d = NULL;
+    Node *n;
+
+    ONEPARAM("dmake");
+    LIST("dmake");
+    for (n = stk->u.lis; n != NULL; n = n->next)
+      { CHECKPAIR(n,"dmake");
+	d = dict_put(d, n->u.lis, n->u.lis->next); }
+    UNARY(DICT_NEWNODE, d);
 }
-#else
-#define OF_AT(PROCEDURE,NAME,AGGR,INDEX)			\
-PRIVATE void PROCEDURE(void)					\
-{   switch (AGGR->op)						\
-      { case SET_:						\
-	  { long i; int indx = INDEX->u.num;			\
-	    for (i = 0; i < SETSIZE; i++)			\
-	      { if (AGGR->u.set & (1 << i))			\
-		  { if (indx == 0)				\
-			{BINARY(INTEGER_NEWNODE,i); return;}	\
-		    indx--; } }					\
-	    return; }						\
-	case STRING_:						\
-	    BINARY(CHAR_NEWNODE,(long)AGGR->u.str[INDEX->u.num]);	\
-	    return;						\
-	case LIST_:						\
-	  { Node *n = AGGR->u.lis;  int i  = INDEX->u.num;	\
-	    while (i > 0)					\
-	      { n = n->next; i--; }				\
-	    GBINARY(n->op,n->u);				\
-	    return; }						\
-	default:						\
-	    BADAGGREGATE(NAME); }				\
+
+PRIVATE void dput_(void)
+{
+    Dict *d;
+
+    THREEPARAMS("dput");
+    DICTIONARY(stk->next->next,"dput");
+    d = dict_put(stk->next->next->u.dict, stk->next, stk);
+    stk = DICT_NEWNODE(d, stk->next->next->next);
 }
-#endif
-OF_AT(of_,"of",stk,stk->next)
-OF_AT(at_,"at",stk->next,stk)
 
-PRIVATE void choice_(void)
+PRIVATE void dget_(void)
 {
-    THREEPARAMS("choice");
-    if (stk->next->next->u.num)
-	 stk = newnode(stk->next->op,stk->next->u,
-		       stk->next->next->next);
-    else stk = newnode(stk->op,stk->u,
-		       stk->next->next->next);
+    Node *val;
+
+    TWOPARAMS("dget");
+    DICTIONARY(stk->next,"dget");
+    if ((val = dict_get(stk->next->u.dict, stk)) == NULL)
+	execerror("key in dictionary", "dget");
+    GBINARY(val->op, val->u);
 }
 
-PRIVATE void case_(void)
+PRIVATE void ddel_(void)
 {
-    Node *n;
+    Dict *d;
+
+    TWOPARAMS("ddel");
+    DICTIONARY(stk->next,"ddel");
+    d = dict_del(stk->next->u.dict, stk);
+    BINARY(DICT_NEWNODE, d);
+}
+
+PRIVATE void dpairs_(void)
+{
+    long i;
+    Node *key, *val, *pair;
+
+    ONEPARAM("dpairs");
+    DICTIONARY(stk,"dpairs");
+    stk = LIST_NEWNODE(NULL, stk);		/* result, above the dict */
+    if (stk->next->u.dict)
+	for (i = stk->next->u.dict->count - 1; i >= 0; i--)
+	  { key = dict_nth(stk->next->u.dict, i, &val);
+	    pair = dict_pair(key, val);
+	    pair = LIST_NEWNODE(pair, stk->u.lis);
+	    stk->u.lis = pair; }
+    stk->next = stk->next->next;
+}
+
+PRIVATE void vmake_(void)
+{
+    ONEPARAM("vmake");
+    LIST("vmake");
+    UNARY(VECTOR_NEWNODE, vec_make(stk->u.lis));
+}
+
+PRIVATE void vlist_(void)
+{
+    Node *list;
+
+    ONEPARAM("vlist");
+    VECTOR(stk,"vlist");
+    list = vec_list(stk->u.vec);
+    UNARY(LIST_NEWNODE, list);
+}
+
+PRIVATE void vpush_(void)
+{
+    Vector *v;
+
+    TWOPARAMS("vpush");
+    VECTOR(stk->next,"vpush");
+    v = vec_push(stk->next->u.vec, stk);
+    BINARY(VECTOR_NEWNODE, v);
+}
+
+PRIVATE void assign_(void)
+{
+    Vector *v;
+
+    THREEPARAMS("assign");
+    VECTOR(stk->next->next,"assign");
+    VECINDEX(stk->next,vec_size(stk->next->next->u.vec) + 1,"assign");
+    v = vec_assign(stk->next->next->u.vec, stk->next->u.num, stk);
+    stk = VECTOR_NEWNODE(v, stk->next->next->next);
+}
+
+#ifdef SINGLE
+PRIVATE void update_(void)
+{			/*  V I [P] update  ==>  V'	*/
+    Node *save, *elem;
+    Vector *v;
+
+    THREEPARAMS("update");
+    ONEQUOTE("update");
+    VECTOR(stk->next->next,"update");
+    VECINDEX(stk->next,vec_size(stk->next->next->u.vec),"update");
+    save = stk;
+    elem = vec_at(save->next->next->u.vec, save->next->u.num);
+    stk = newnode(elem->op, elem->u, save->next->next->next);
+    exeterm(save->u.lis);
+    if (stk == NULL) execerror("value to push","update");
+    v = vec_assign(save->next->next->u.vec, save->next->u.num, stk);
+    stk = VECTOR_NEWNODE(v, save->next->next->next);
+}
+#else
+PRIVATE void update_(void)
+{
+    Node *elem;
+    Vector *v;
+
+    THREEPARAMS("update");
+    ONEQUOTE("update");
+    VECTOR(stk->next->next,"update");
+    VECINDEX(stk->next,vec_size(stk->next->next->u.vec),"update");
+    SAVESTACK;
+    elem = vec_at(SAVED3->u.vec, SAVED2->u.num);
+    stk = newnode(elem->op, elem->u, SAVED4);
+    exeterm(SAVED1->u.lis);
+    if (stk == NULL) execerror("value to push","update");
+    v = vec_assign(SAVED3->u.vec, SAVED2->u.num, stk);
+    stk = VECTOR_NEWNODE(v, SAVED4);
+    POP(dump);
+}
+#endif
+
+PRIVATE void qmake_(void)
+{
+    ONEPARAM("qmake");
+    LIST("qmake");
+    UNARY(DEQUE_NEWNODE, deq_make(stk->u.lis));
+}
+
+PRIVATE void qlist_(void)
+{
+    Node *list;
+
+    ONEPARAM("qlist");
+    DEQUE(stk,"qlist");
+    list = deq_list(stk->u.deq);
+    UNARY(LIST_NEWNODE, list);
+}
+
+#define QPUSH(PROCEDURE,NAME,END)				\
+PRIVATE void PROCEDURE(void)					\
+{   Deque *q;							\
+    TWOPARAMS(NAME);						\
+    DEQUE(stk->next,NAME);					\
+    q = deq_push(stk->next->u.deq, stk, END);			\
+    BINARY(DEQUE_NEWNODE, q); }
+QPUSH(qpushf_,"qpushf",'f')
+QPUSH(qpushb_,"qpushb",'b')
+
+#define QPOP(PROCEDURE,NAME,END)				\
+PRIVATE void PROCEDURE(void)					\
+{   ONEPARAM(NAME);						\
+    DEQUE(stk,NAME);						\
+    CHECKEMPTYDEQUE(stk->u.deq,NAME);				\
+    UNARY(DEQUE_NEWNODE, deq_pop(stk->u.deq, END)); }
+QPOP(qpopf_,"qpopf",'f')
+QPOP(qpopb_,"qpopb",'b')
+
+#define QPEEK(PROCEDURE,NAME,END)				\
+PRIVATE void PROCEDURE(void)					\
+{   Node *elem;							\
+    ONEPARAM(NAME);						\
+    DEQUE(stk,NAME);						\
+    CHECKEMPTYDEQUE(stk->u.deq,NAME);				\
+    elem = deq_peek(stk->u.deq, END);				\
+    GUNARY(elem->op, elem->u); }
+QPEEK(qfront_,"qfront",'f')
+QPEEK(qback_,"qback",'b')
+
+/*
+    heap_less runs the order of heap_current, or uses Compare when that is
+    empty. The elements are in boxes that stay where they are, and the
+    heaps that refer to them are on the stack, so that they are kept up to
+    date by the garbage collector.
+*/
+#define heap_current	(joy_context->heap_current)
+
+PRIVATE int heap_less(Node *first, Node *second)
+{
+    int error, less;
+#ifdef SINGLE
+    Node *save = stk;
+#endif
+
+    if (heap_current->order.u.lis == NULL)
+      { less = Compare(first, second, &error) < 0;
+	if (error) BADDATA("heap");
+	return less; }
+#ifdef SINGLE
+    stk = newnode(first->op, first->u, stk);
+    stk = newnode(second->op, second->u, stk);
+    exeterm(heap_current->order.u.lis);
+    less = stk->u.num != 0;
+    stk = save;
+#else
+    SAVESTACK;
+    stk = newnode(first->op, first->u, stk);
+    stk = newnode(second->op, second->u, stk);
+    exeterm(heap_current->order.u.lis);
+    less = stk->u.num != 0;
+    stk = SAVED1;
+    POP(dump);
+#endif
+    return less;
+}
+
+PRIVATE void hmake_(void)
+{
+    Heap *h, *outer = heap_current;		/* hmake in an order */
+
+    TWOPARAMS("hmake");
+    ONEQUOTE("hmake");
+    LIST2("hmake");
+    h = heap_boxes(heap_new(stk->u.lis), stk->next->u.lis);
+    stk = HEAP_NEWNODE(h, stk->next->next);
+    heap_current = stk->u.heap;
+    h = heap_build(stk->u.heap, heap_less);
+    heap_current = outer;
+    UNARY(HEAP_NEWNODE, h);
+}
+
+PRIVATE void hpush_(void)
+{
+    Heap *h, *outer = heap_current;
+
+    TWOPARAMS("hpush");
+    HEAP(stk->next,"hpush");
+    h = heap_single(stk->next->u.heap, stk);
+    stk = HEAP_NEWNODE(h, stk->next);		/* keeps the box */
+    heap_current = stk->next->u.heap;
+    h = heap_merge(stk->next->u.heap, stk->u.heap, heap_less);
+    heap_current = outer;
+    BINARY(HEAP_NEWNODE, h);
+}
+
+PRIVATE void htop_(void)
+{
+    Node *elem;
+
+    ONEPARAM("htop");
+    HEAP(stk,"htop");
+    CHECKEMPTYHEAP(stk->u.heap,"htop");
+    elem = heap_top(stk->u.heap);
+    GUNARY(elem->op, elem->u);
+}
+
+PRIVATE void hpop_(void)
+{
+    Heap *h, *outer = heap_current;
+
+    ONEPARAM("hpop");
+    HEAP(stk,"hpop");
+    CHECKEMPTYHEAP(stk->u.heap,"hpop");
+    heap_current = stk->u.heap;
+    h = heap_pop(stk->u.heap, heap_less);
+    heap_current = outer;
+    UNARY(HEAP_NEWNODE, h);
+}
+
+PRIVATE void smake_(void)
+{
+    ONEPARAM("smake");
+    LIST("smake");
+    UNARY(ORDSET_NEWNODE, ord_make(stk->u.lis, 0, "smake"));
+}
+
+PRIVATE void slist_(void)
+{
+    Node *list;
+
+    ONEPARAM("slist");
+    ORDSET(stk,"slist");
+    list = ord_list(stk->u.ord);
+    UNARY(LIST_NEWNODE, list);
+}
+
+PRIVATE void sinsert_(void)
+{
+    Otree *t;
+
+    TWOPARAMS("sinsert");
+    ORDSET(stk->next,"sinsert");
+    t = ord_insert(stk->next->u.ord, stk, NULL, "sinsert");
+    BINARY(ORDSET_NEWNODE, t);
+}
+
+PRIVATE void sdelete_(void)
+{
+    Otree *t;
+
+    TWOPARAMS("sdelete");
+    ORDSET(stk->next,"sdelete");
+    t = ord_delete(stk->next->u.ord, stk, "sdelete");
+    BINARY(ORDSET_NEWNODE, t);
+}
+
+#define ORDCOMBINE(PROCEDURE,NAME,OPER)				\
+PRIVATE void PROCEDURE(void)					\
+{   Otree *t;							\
+    TWOPARAMS(NAME);						\
+    ORDERED(stk,NAME);						\
+    if (stk->next->op != stk->op)				\
+	BADDATA(NAME);						\
+    t = ord_combine(stk->next->u.ord, stk->u.ord, OPER, NAME);	\
+    bucket.ord = t;						\
+    stk = newnode(stk->op, bucket, stk->next->next); }
+ORDCOMBINE(sunion_,"sunion",'u')
+ORDCOMBINE(sintersect_,"sintersect",'i')
+ORDCOMBINE(sdifference_,"sdifference",'d')
+
+PRIVATE void omake_(void)
+{
+    ONEPARAM("omake");
+    LIST("omake");
+    UNARY(ORDMAP_NEWNODE, ord_make(stk->u.lis, 1, "omake"));
+}
+
+PRIVATE void oput_(void)
+{
+    Otree *t;
+
+    THREEPARAMS("oput");
+    ORDMAP(stk->next->next,"oput");
+    t = ord_insert(stk->next->next->u.ord, stk->next, stk, "oput");
+    stk = ORDMAP_NEWNODE(t, stk->next->next->next);
+}
+
+PRIVATE void oget_(void)
+{
+    Otree *t;
+
+    TWOPARAMS("oget");
+    ORDMAP(stk->next,"oget");
+    if ((t = ord_find(stk->next->u.ord, stk, "oget")) == NULL)
+	execerror("key in map", "oget");
+    GBINARY(t->val.op, t->val.u);
+}
+
+PRIVATE void odel_(void)
+{
+    Otree *t;
+
+    TWOPARAMS("odel");
+    ORDMAP(stk->next,"odel");
+    t = ord_delete(stk->next->u.ord, stk, "odel");
+    BINARY(ORDMAP_NEWNODE, t);
+}
+
+PRIVATE void opairs_(void)
+{
+    long i;
+    Node *key, *val, *pair;
+
+    ONEPARAM("opairs");
+    ORDMAP(stk,"opairs");
+    stk = LIST_NEWNODE(NULL, stk);		/* result, above the map */
+    if (stk->next->u.ord)
+	for (i = stk->next->u.ord->size - 1; i >= 0; i--)
+	  { key = ord_nth(stk->next->u.ord, i, &val);
+	    pair = dict_pair(key, val);
+	    pair = LIST_NEWNODE(pair, stk->u.lis);
+	    stk->u.lis = pair; }
+    stk->next = stk->next->next;
+}
+
+PRIVATE void hash_(void)
+{
+    ONEPARAM("hash");
+    UNARY(INTEGER_NEWNODE, (Num)(dict_hash(stk) >> 1));
+}
+
+PRIVATE void share_(void)
+{
+    ONEPARAM("share");
+    LIST("share");
+    UNARY(LIST_NEWNODE, hash_cons(stk->u.lis));
+}
+
+#define PACK(PROCEDURE,NAME,TYPE)				\
+PRIVATE void PROCEDURE(void)					\
+{   Operator op;						\
+    Types u;							\
+    ONEPARAM(NAME);						\
+    op = arr_pack(stk, TYPE, &u, NAME);				\
+    GUNARY(op, u);						\
+}
+PACK(farray_,"farray",FLOATARRAY_)
+PACK(iarray_,"iarray",INTARRAY_)
+
+PRIVATE void unpack_(void)
+{
+    Node *list;
+
+    ONEPARAM("unpack");
+    if (!ARRAY(stk->op))
+	execerror("array", "unpack");
+    list = arr_unpack(stk);
+    UNARY(LIST_NEWNODE, list);
+}
+
+PRIVATE void dot_(void)
+{
+    Operator op;
+    Types u;
+
+    TWOPARAMS("dot");
+    op = arr_dot(stk->next, stk, &u, "dot");
+    GBINARY(op, u);
+}
+
+#define REDUCE(PROCEDURE,NAME,OPER)				\
+PRIVATE void PROCEDURE(void)					\
+{   Operator op;						\
+    Types u;							\
+    ONEPARAM(NAME);						\
+    op = arr_reduce(stk, OPER, &u, NAME);			\
+    GUNARY(op, u);						\
+}
+REDUCE(asum_,"asum",'+')
+REDUCE(amin_,"amin",'<')
+REDUCE(amax_,"amax",'>')
+
+#define MATRIX(PROCEDURE,NAME,FUNCTION)				\
+PRIVATE void PROCEDURE(void)					\
+{   Operator op;						\
+    Types u;							\
+    TWOPARAMS(NAME);						\
+    op = FUNCTION(stk->next, stk, &u, NAME);			\
+    GBINARY(op, u);						\
+}
+MATRIX(mmul_,"mmul",mat_mul)
+MATRIX(madd_,"madd",mat_add)
+MATRIX(mscale_,"mscale",mat_scale)
+
+PRIVATE void mtranspose_(void)
+{
+    Operator op;
+    Types u;
+    Node *list, *row, *e, **cur;
+    long i, rows = 0, cols = -1;
+
+    ONEPARAM("mtranspose");
+    if (stk->op == FLOATARRAY_) {
+	op = mat_transpose(stk, &u, "mtranspose");
+	GUNARY(op, u);
+	return;
+    }
+    if (stk->op != LIST_)
+	execerror("matrix", "mtranspose");
+    for (row = stk->u.lis; row; row = row->next, rows++) {
+	if (row->op != LIST_)
+	    execerror("matrix", "mtranspose");
+	for (i = 0, e = row->u.lis; e; e = e->next)
+	    i++;
+	if (cols < 0)
+	    cols = i;
+	else if (i != cols)
+	    execerror("rows of equal length", "mtranspose");
+    }
+    if (cols < 0)
+	cols = 0;
+    list = mat_cells(cols, rows);
+    if ((cur = malloc(cols * sizeof(Node *) + 1)) == 0)
+	execerror("memory", "mtranspose");
+    for (i = 0, row = list; row; row = row->next)
+	cur[i++] = row->u.lis;
+    for (row = stk->u.lis; row; row = row->next)
+	for (i = 0, e = row->u.lis; i < cols; i++, e = e->next) {
+	    cur[i]->op = e->op;
+	    cur[i]->u = e->u;
+	    cur[i] = cur[i]->next;
+	}
+    free(cur);
+    UNARY(LIST_NEWNODE, list);
+}
+
+PRIVATE void mpack_(void)
+{
+    Operator op;
+    Types u;
+
+    ONEPARAM("mpack");
+    op = mat_pack(stk, &u, "mpack");
+    GUNARY(op, u);
+}
+
+PRIVATE void munpack_(void)
+{
+    Node *list;
+
+    ONEPARAM("munpack");
+    if (stk->op != FLOATARRAY_)
+	execerror("packed matrix", "munpack");
+    list = mat_unpack(stk, "munpack");
+    UNARY(LIST_NEWNODE, list);
+}
+
+#ifdef RUNTIME_CHECKS
+#define OF_AT(PROCEDURE,NAME,AGGR,INDEX)			\
+PRIVATE void PROCEDURE(void)					\
+{   TWOPARAMS(NAME);						\
+    if (INDEX->op != INTEGER_ || INDEX->u.num < 0)		\
+	execerror("non-negative integer", NAME);		\
+    switch (AGGR->op)						\
+      { case SET_: case BIGSET_:				\
+	  { long i;						\
+	    CHECKEMPTYSET(AGGR->u.set,NAME);			\
+	    if ((i = set_nth(AGGR, INDEX->u.num)) < 0)		\
+		INDEXTOOLARGE(NAME);				\
+	    BINARY(INTEGER_NEWNODE,i);				\
+	    return; }						\
+	case STRING_:						\
+	    if (strlen(AGGR->u.str) < (size_t)INDEX->u.num)	\
+		INDEXTOOLARGE(NAME);				\
+	    BINARY(CHAR_NEWNODE,(long)AGGR->u.str[INDEX->u.num]);	\
+	    return;						\
+	case FLOATARRAY_: case INTARRAY_:			\
+	  { Node n;						\
+	    if (arr_size(AGGR) <= INDEX->u.num)		\
+		INDEXTOOLARGE(NAME);				\
+	    arr_at(AGGR, INDEX->u.num, &n);			\
+	    GBINARY(n.op,n.u);					\
+	    return; }						\
+	case RANGE_:						\
+	    if (rng_size(AGGR->u.rng) <= INDEX->u.num)		\
+		INDEXTOOLARGE(NAME);				\
+	    bucket.num = rng_nth(AGGR->u.rng, INDEX->u.num);	\
+	    GBINARY(AGGR->u.rng->type,bucket);			\
+	    return;						\
+	case VECTOR_:						\
+	  { Node *n;						\
+	    if (vec_size(AGGR->u.vec) <= INDEX->u.num)		\
+		INDEXTOOLARGE(NAME);				\
+	    n = vec_at(AGGR->u.vec, INDEX->u.num);		\
+	    GBINARY(n->op,n->u);				\
+	    return; }						\
+	case LIST_:						\
+	  { Node *n = AGGR->u.lis;  int i  = INDEX->u.num;	\
+	    CHECKEMPTYLIST(n,NAME);				\
+	    while (i > 0)					\
+	      { if (n->next == NULL)				\
+		    INDEXTOOLARGE(NAME);			\
+		n = n->next; i--; }				\
+	    GBINARY(n->op,n->u);				\
+	    return; }						\
+	default:						\
+	    BADAGGREGATE(NAME); }				\
+}
+#else
+#define OF_AT(PROCEDURE,NAME,AGGR,INDEX)			\
+PRIVATE void PROCEDURE(void)					\
+{   switch (AGGR->op)						\
+      { case SET_: case BIGSET_:				\
+	    BINARY(INTEGER_NEWNODE,set_nth(AGGR, INDEX->u.num));	\
+	    return;						\
+	case STRING_:						\
+	    BINARY(CHAR_NEWNODE,(long)AGGR->u.str[INDEX->u.num]);	\
+	    return;						\
+	case FLOATARRAY_: case INTARRAY_:			\
+	  { Node n;						\
+	    arr_at(AGGR, INDEX->u.num, &n);			\
+	    GBINARY(n.op,n.u);					\
+	    return; }						\
+	case RANGE_:						\
+	    bucket.num = rng_nth(AGGR->u.rng, INDEX->u.num);	\
+	    GBINARY(AGGR->u.rng->type,bucket);			\
+	    return;						\
+	case VECTOR_:						\
+	  { Node *n = vec_at(AGGR->u.vec, INDEX->u.num);	\
+	    GBINARY(n->op,n->u);				\
+	    return; }						\
+	case LIST_:						\
+	  { Node *n = AGGR->u.lis;  int i  = INDEX->u.num;	\
+	    while (i > 0)					\
+	      { n = n->next; i--; }				\
+	    GBINARY(n->op,n->u);				\
+	    return; }						\
+	default:						\
+	    BADAGGREGATE(NAME); }				\
+}
+#endif
+OF_AT(of_,"of",stk,stk->next)
+OF_AT(at_,"at",stk->next,stk)
+
+PRIVATE void choice_(void)
+{
+    THREEPARAMS("choice");
+    if (stk->next->next->u.num)
+	 stk = newnode(stk->next->op,stk->next->u,
+		       stk->next->next->next);
+    else stk = newnode(stk->op,stk->u,
+		       stk->next->next->next);
+}
+
+PRIVATE void case_(void)
+{
+    Node *n;
 #ifdef CORRECT_CASE_COMPARE
     int error;
 #endif
@@ -1844,7 +3205,7 @@ PRIVATE void opcase_(void)
     CHECKEMPTYLIST(n,"opcase");
     while ( n->next != NULL &&
 	    n->op == LIST_ &&
-	    n->u.lis->op != stk->next->op )
+	    BASETYPE(n->u.lis->op) != BASETYPE(stk->next->op) )
 	n = n->next;
     CHECKLIST(n->op,"opcase");
     UNARY(LIST_NEWNODE, n->next != NULL ? n->u.lis->next : n->u.lis);
@@ -1853,15 +3214,18 @@ PRIVATE void opcase_(void)
 #ifdef RUNTIME_CHECKS
 #define CONS_SWONS(PROCEDURE,NAME,AGGR,ELEM)			\
 PRIVATE void PROCEDURE(void)					\
-{   TWOPARAMS(NAME);						\
+{   Operator op;						\
+    Types u;							\
+    TWOPARAMS(NAME);						\
     switch (AGGR->op)						\
       { case LIST_:						\
 	    BINARY(LIST_NEWNODE,newnode(ELEM->op,		\
 				 ELEM->u,AGGR->u.lis));		\
 	    break;						\
-	case SET_:						\
+	case SET_: case BIGSET_:				\
 	    CHECKSETMEMBER(ELEM,NAME);				\
-	    BINARY(SET_NEWNODE,AGGR->u.set | (1 << ELEM->u.num));	\
+	    op = set_insert(AGGR, ELEM->u.num, &u);		\
+	    GBINARY(op, u);					\
 	    break;						\
 	case STRING_:						\
 	  { char *s;						\
@@ -1878,14 +3242,17 @@ PRIVATE void PROCEDURE(void)					\
 #else
 #define CONS_SWONS(PROCEDURE,NAME,AGGR,ELEM)			\
 PRIVATE void PROCEDURE(void)					\
-{   TWOPARAMS(NAME);						\
+{   Operator op;						\
+    Types u;							\
+    TWOPARAMS(NAME);						\
     switch (AGGR->op)						\
       { case LIST_:						\
 	    BINARY(LIST_NEWNODE,newnode(ELEM->op,		\
 				 ELEM->u,AGGR->u.lis));		\
 	    break;						\
-	case SET_:						\
-	    BINARY(SET_NEWNODE,AGGR->u.set | (1 << ELEM->u.num));	\
+	case SET_: case BIGSET_:				\
+	    op = set_insert(AGGR, ELEM->u.num, &u);		\
+	    GBINARY(op, u);					\
 	    break;						\
 	case STRING_:						\
 	  { char *s;						\
@@ -1903,15 +3270,15 @@ CONS_SWONS(swons_,"swons",stk->next,stk)
 
 PRIVATE void drop_(void)
 {   int n = stk->u.num;
+    Operator op;
+    Types u;
     TWOPARAMS("drop");
     switch (stk->next->op)
-      { case SET_:
-	  { int i; long result = 0;
-	    for (i = 0; i < SETSIZE; i++)
-		if (stk->next->u.set & (1 << i))
-		  { if (n < 1) result = result | (1 << i);
-		    else n--; }
-	    BINARY(SET_NEWNODE,result);
+      { case SET_: case BIGSET_:
+	  { long i = n < 1 ? 0 : set_nth(stk->next,n);
+	    op = i < 0 ? set_range(stk->next,0,0,&u) :
+			 set_range(stk->next,i,BIGSETMAX,&u);
+	    GBINARY(op, u);
 	    return; }
 	case STRING_:
 	  { char *result = stk->next->u.str;
@@ -1923,6 +3290,11 @@ PRIVATE void drop_(void)
 	    while (n-- > 0 && result != NULL) result = result->next;
 	    BINARY(LIST_NEWNODE,result);
 	    return; }
+	case STREAM_:
+	    POP(stk);
+	    while (n-- > 0 && stk->u.stream != NULL)
+		stream_step(1);
+	    return;
 	default:
 	    BADAGGREGATE("drop"); }
 }
@@ -1934,16 +3306,14 @@ PRIVATE void take_(void)
     Node *my_dump2 = 0; /* head */
     Node *my_dump3 = 0; /* last */
 #endif
+    Operator op;
+    Types u;
     TWOPARAMS("take");
     switch (stk->next->op)
-      { case SET_:
-	  { int i; long result = 0;
-	    for (i = 0; i < SETSIZE; i++)
-		if (stk->next->u.set & (1 << i))
-		  { if (n > 0)
-		      { --n;  result = result | (1 << i); }
-		    else break; }
-	    BINARY(SET_NEWNODE,result);
+      { case SET_: case BIGSET_:
+	  { long i = n < 1 ? 0 : set_nth(stk->next,n);
+	    op = set_range(stk->next,0,i < 0 ? BIGSETMAX : i,&u);
+	    GBINARY(op, u);
 	    return; }
 	case STRING_:
 	  { int i; char *old, *p, *result;
@@ -1990,6 +3360,23 @@ PRIVATE void take_(void)
 	    POP(dump1); POP(dump2); POP(dump3);
 #endif
 	    return; }
+	case STREAM_:
+	  { int i = stk->u.num;
+	    Node *elem, *prev = NULL, *next;
+	    stk = LIST_NEWNODE(NULL,stk->next);	/* result, reversed */
+	    stk = STREAM_NEWNODE(stk->next->u.stream,stk);
+	    while (i-- > 0 && stk->u.stream != NULL)
+	      { elem = newnode(stk->u.stream->head.op,stk->u.stream->head.u,
+			       stk->next->u.lis);
+		stk->next->u.lis = elem;
+		if (i > 0)
+		    stream_step(1); }
+	    for (elem = stk->next->u.lis; elem != NULL; elem = next)
+	      { next = elem->next;
+		elem->next = prev;
+		prev = elem; }
+	    stk = LIST_NEWNODE(prev,stk->next->next->next);
+	    return; }
 	default:
 	    BADAGGREGATE("take"); }
 }
@@ -2001,11 +3388,17 @@ PRIVATE void concat_(void)
     Node *my_dump2 = 0; /* head */
     Node *my_dump3 = 0; /* last */
 #endif
+    Operator op;
+    Types u;
     TWOPARAMS("concat");
     SAME2TYPES("concat");
     switch (stk->op)
-      { case SET_:
-	    BINARY(SET_NEWNODE,stk->next->u.set | stk->u.set);
+      { case SET_: case BIGSET_:
+	    if (stk->op == SET_ && stk->next->op == SET_)
+		BINARY(SET_NEWNODE,stk->next->u.set | stk->u.set);
+	    else
+	      { op = set_binop(stk->next,stk,'|',&u);
+		GBINARY(op, u); }
 	    return;
 	case STRING_:
 	  { char *s, *p;
@@ -2087,6 +3480,36 @@ PRIVATE void null_(void)
 	case SET_:
 	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.set));
 	    break;
+	case BIGSET_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(set_next(stk, 0) < 0));
+	    break;
+	case DICT_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.dict));
+	    break;
+	case FLOATARRAY_: case INTARRAY_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! arr_size(stk)));
+	    break;
+	case VECTOR_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.vec));
+	    break;
+	case DEQUE_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.deq));
+	    break;
+	case HEAP_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.heap->count));
+	    break;
+	case ORDSET_: case ORDMAP_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.ord));
+	    break;
+	case STREAM_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.stream));
+	    break;
+	case RANGE_:
+	    UNARY(BOOLEAN_NEWNODE, (long)(! rng_size(stk->u.rng)));
+	    break;
+	case BIGNUM_: case RATIONAL_:
+	    UNARY(BOOLEAN_NEWNODE, 0L);
+	    break;
 	case BOOLEAN_: case CHAR_: case INTEGER_:
 	    UNARY(BOOLEAN_NEWNODE, (long)(! stk->u.num));
 	    break;
@@ -2096,10 +3519,14 @@ PRIVATE void null_(void)
 
 PRIVATE void not_(void)
 {
+    Operator op;
+    Types u;
+
     ONEPARAM("not");
     switch (stk->op)
-      { case SET_:
-	    UNARY(SET_NEWNODE, ~stk->u.set);
+      { case SET_: case BIGSET_:
+	    op = set_not(stk, &u);
+	    GUNARY(op, u);
 	    break;
 #ifndef ONLY_LOGICAL_NOT
 	case STRING_:
@@ -2132,11 +3559,9 @@ PRIVATE void size_(void)
     long siz = 0;
     ONEPARAM("size");
     switch (stk->op)
-      { case SET_:
-	  { int i;
-	    for (i = 0; i < SETSIZE; i++)
-		if (stk->u.set & (1 << i)) siz++;
-	    break; }
+      { case SET_: case BIGSET_:
+	    siz = set_size(stk);
+	    break;
 	case STRING_:
 	    siz = strlen(stk->u.str);
 	    break;
@@ -2144,6 +3569,31 @@ PRIVATE void size_(void)
 	  { Node *e = stk->u.lis;
 	    while (e != NULL) {e = e->next; siz++;};
 	    break; }
+	case DICT_:
+	    siz = stk->u.dict ? stk->u.dict->count : 0;
+	    break;
+	case FLOATARRAY_: case INTARRAY_:
+	    siz = arr_size(stk);
+	    break;
+	case VECTOR_:
+	    siz = vec_size(stk->u.vec);
+	    break;
+	case DEQUE_:
+	    siz = deq_size(stk->u.deq);
+	    break;
+	case HEAP_:
+	    siz = stk->u.heap->count;
+	    break;
+	case ORDSET_: case ORDMAP_:
+	    siz = stk->u.ord ? stk->u.ord->size : 0;
+	    break;
+	case STREAM_:
+	    for (siz = 0; stk->u.stream; siz++)
+		stream_step(1);
+	    break;
+	case RANGE_:
+	    siz = rng_size(stk->u.rng);
+	    break;
 	default :
 	    BADAGGREGATE("size"); }
     UNARY(INTEGER_NEWNODE,siz);
@@ -2157,12 +3607,11 @@ PRIVATE void small_(void)
       { case BOOLEAN_: case INTEGER_:
 	    sml = stk->u.num < 2;
 	    break;
-	case SET_:
-	    if (stk->u.set == 0) sml = 1; else
-	      { int i = 0;
-		while  (!(stk->u.set & (1 << i))) i++;
-D(		printf("small: first member found is %d\n",i); )
-		sml = (stk->u.set & ~(1 << i)) == 0; }
+	case BIGNUM_:
+	    sml = stk->u.bnum->size < 0;
+	    break;
+	case SET_: case BIGSET_:
+	    sml = set_nth(stk, 1) < 0;
 	    break;
 	case STRING_:
 	    sml = stk->u.str[0] == '\0' || stk->u.str[1] == '\0';
@@ -2178,7 +3627,7 @@ D(		printf("small: first member found is %d\n",i); )
 #define TYPE(PROCEDURE,NAME,REL,TYP)				\
     PRIVATE void PROCEDURE(void)				\
     {   ONEPARAM(NAME);						\
-	UNARY(BOOLEAN_NEWNODE,(long)(stk->op REL TYP)); }
+	UNARY(BOOLEAN_NEWNODE,(long)(BASETYPE(stk->op) REL TYP)); }
 TYPE(integer_,"integer",==,INTEGER_)
 TYPE(char_,"char",==,CHAR_)
 TYPE(logical_,"logical",==,BOOLEAN_)
@@ -2188,6 +3637,18 @@ TYPE(list_,"list",==,LIST_)
 TYPE(leaf_,"leaf",!=,LIST_)
 TYPE(float_,"float",==,FLOAT_)
 TYPE(file_,"file",==,FILE_)
+TYPE(dict_,"dict",==,DICT_)
+TYPE(rational_,"rational",==,RATIONAL_)
+TYPE(floatarray_,"floatarray",==,FLOATARRAY_)
+TYPE(intarray_,"intarray",==,INTARRAY_)
+TYPE(vector_,"vector",==,VECTOR_)
+TYPE(deque_,"deque",==,DEQUE_)
+TYPE(heap_,"heap",==,HEAP_)
+TYPE(oset_,"oset",==,ORDSET_)
+TYPE(omap_,"omap",==,ORDMAP_)
+TYPE(stream_,"stream",==,STREAM_)
+TYPE(range_,"range",==,RANGE_)
+TYPE(channel_,"channel",==,CHANNEL_)
 TYPE(user_,"user",==,USR_)
 
 #define USETOP(PROCEDURE,NAME,TYPE,BODY)			\
@@ -2200,6 +3661,7 @@ USETOP( setecho_,"setecho",NUMERICTYPE, echoflag = stk->u.num )
 USETOP( setautoput_,"setautoput",NUMERICTYPE, autoput = stk->u.num )
 USETOP( setundeferror_, "setundeferror", NUMERICTYPE, undeferror = stk->u.num )
 USETOP( settracegc_,"settracegc",NUMERICTYPE, tracegc = stk->u.num )
+USETOP( setpardepth_,"setpardepth",INTEGER, par_setdepth(stk->u.num) )
 USETOP( srand_,"srand",INTEGER, srand((unsigned int) stk->u.num) )
 USETOP( include_,"include",STRING, doinclude(stk->u.str) )
 USETOP( system_,"system",STRING, (void)system(stk->u.str) )
@@ -2304,11 +3766,13 @@ PUBLIC void printfactor(Node *n, FILE *stm)
     switch (n->op)
       { case BOOLEAN_:
 	    fprintf(stm, "type boolean"); return;
-	case INTEGER_:
+	case INTEGER_: case BIGNUM_:
 	    fprintf(stm, "type integer"); return;
+	case RATIONAL_:
+	    fprintf(stm, "type rational"); return;
 	case FLOAT_:
 	    fprintf(stm, "type float"); return;
-	case SET_:
+	case SET_: case BIGSET_:
 	    fprintf(stm, "type set"); return;
 	case CHAR_:
 	    fprintf(stm, "type char"); return;
@@ -2320,6 +3784,28 @@ PUBLIC void printfactor(Node *n, FILE *stm)
 	    fprintf(stm, n->u.ent->name); return;
 	case FILE_:
 	    fprintf(stm, "type file"); return;
+	case DICT_:
+	    fprintf(stm, "type dict"); return;
+	case FLOATARRAY_:
+	    fprintf(stm, "type floatarray"); return;
+	case INTARRAY_:
+	    fprintf(stm, "type intarray"); return;
+	case VECTOR_:
+	    fprintf(stm, "type vector"); return;
+	case DEQUE_:
+	    fprintf(stm, "type deque"); return;
+	case HEAP_:
+	    fprintf(stm, "type heap"); return;
+	case ORDSET_:
+	    fprintf(stm, "type oset"); return;
+	case ORDMAP_:
+	    fprintf(stm, "type omap"); return;
+	case STREAM_:
+	    fprintf(stm, "type stream"); return;
+	case RANGE_:
+	    fprintf(stm, "type range"); return;
+	case CHANNEL_:
+	    fprintf(stm, "type channel"); return;
 	default:
 	    fprintf(stm, "%s",symtab[(int) n->op].name); return; }
 }
@@ -2389,11 +3875,30 @@ void exeterm(Node *n)
 	case LIST_:
 	case FLOAT_:
 	case FILE_:
+	case BIGSET_:
+	case DICT_:
+	case BIGNUM_:
+	case RATIONAL_:
+	case FLOATARRAY_:
+	case INTARRAY_:
+	case VECTOR_:
+	case DEQUE_:
+	case HEAP_:
+	case ORDSET_:
+	case ORDMAP_:
+	case STREAM_:
+	case RANGE_:
+	case CHANNEL_:
 	    stk = newnode(n->op, n->u, stk);
 	    break;
 	case USR_:
 	    if (!n->u.ent->u.body && undeferror)
 		execerror("definition", n->u.ent->name);
+	    if (n->u.ent->memo) {
+		stk = LIST_NEWNODE(n->u.ent->u.body, stk);
+		memo_exec((size_t)n->u.ent, n->u.ent->memo - 1, 0);
+		break;
+	    }
 	    if (!n->next) {
 		n = n->u.ent->u.body;
 		continue;
@@ -2443,11 +3948,20 @@ start:
 #endif
 	switch (stepper->op)
 	  { case BOOLEAN_: case CHAR_: case INTEGER_: case FLOAT_:
-	    case SET_: case STRING_: case LIST_: case FILE_:
+	    case SET_: case STRING_: case LIST_: case FILE_: case BIGSET_:
+	    case DICT_: case BIGNUM_: case RATIONAL_:
+	    case FLOATARRAY_: case INTARRAY_: case VECTOR_:
+	    case DEQUE_: case HEAP_: case ORDSET_: case ORDMAP_:
+	    case STREAM_: case RANGE_: case CHANNEL_:
 		stk = newnode(stepper->op, stepper->u, stk); break;
 	    case USR_:
 	      if (stepper->u.ent->u.body == NULL && undeferror)
 		  execerror("definition", stepper->u.ent->name);
+		if (stepper->u.ent->memo)
+		  { Entry *ent = stepper->u.ent;
+		    stk = LIST_NEWNODE(ent->u.body, stk);
+		    memo_exec((size_t)ent, ent->memo - 1, 0);
+		    break; }
 		if (stepper->next == NULL)
 		  { POP(conts);
 		    n = stepper->u.ent->u.body;
@@ -2927,15 +4441,66 @@ PRIVATE void map_(void)
 		resultstring[j++] = (char)stk->u.num; }
 	    stk = STRING_NEWNODE(resultstring,save);
 	    break; }
-	case SET_:
-	  { long i; long set = stk->u.set, resultset = 0;
-	    for (i = 0; i < SETSIZE; i++)
-		if (set & (1 << i))
-		  { stk = INTEGER_NEWNODE(i,save);
-		    exeterm(program);
-		    resultset = resultset | (1 << stk->u.num); }
-	    stk = SET_NEWNODE(resultset,save);
+	case SET_: case BIGSET_:
+	  { long i; Node *data = stk; Bigset *result = 0;
+	    Operator op; Types u;
+	    for (i = set_next(data,0); i >= 0; i = set_next(data,i + 1))
+	      { stk = INTEGER_NEWNODE(i,save);
+		exeterm(program);
+		CHECKSETMEMBER(stk,"map");
+		result = set_add(result,stk->u.num); }
+	    op = set_make(result,&u);
+	    stk = newnode(op,u,save);
+	    break; }
+	case DICT_:
+	  { long i; Dict *data = stk->u.dict, *result = 0;
+	    Node *key, *val;
+	    for (i = 0; (key = dict_nth(data,i,&val)) != NULL; i++)
+	      { my_dump1 = dict_pair(key,val);
+		stk = LIST_NEWNODE(my_dump1,save);
+		exeterm(program);
+		CHECKPAIR(stk,"map");
+		result = dict_put(result,stk->u.lis,stk->u.lis->next); }
+	    stk = DICT_NEWNODE(result,save);
 	    break; }
+	case ORDSET_:
+	  { long i; Otree *data = stk->u.ord, *result = 0;
+	    Node *key;
+	    for (i = 0; (key = ord_nth(data,i,NULL)) != NULL; i++)
+	      { stk = newnode(key->op,key->u,save);
+		exeterm(program);
+		result = ord_insert(result,stk,NULL,"map"); }
+	    stk = ORDSET_NEWNODE(result,save);
+	    break; }
+	case ORDMAP_:
+	  { long i; Otree *data = stk->u.ord, *result = 0;
+	    Node *key, *val;
+	    for (i = 0; (key = ord_nth(data,i,&val)) != NULL; i++)
+	      { my_dump1 = dict_pair(key,val);
+		stk = LIST_NEWNODE(my_dump1,save);
+		exeterm(program);
+		CHECKPAIR(stk,"map");
+		result = ord_insert(result,stk->u.lis,stk->u.lis->next,"map"); }
+	    stk = ORDMAP_NEWNODE(result,save);
+	    break; }
+	case RANGE_:
+	  { long i; Range *r = stk->u.rng;
+	    for (i = 0; i < rng_size(r); i++)
+	      { bucket.num = rng_nth(r,i);
+		stk = newnode(r->type,bucket,save);
+		exeterm(program);
+		if (my_dump2 == NULL)			/* first */
+		  { my_dump2 = newnode(stk->op,stk->u,NULL);
+		    my_dump3 = my_dump2; }
+		else					/* further */
+		  { my_dump3->next = newnode(stk->op,stk->u,NULL);
+		    my_dump3 = my_dump3->next; } }
+	    stk = LIST_NEWNODE(my_dump2,save);
+	    break; }
+	case STREAM_:
+	    stk = LIST_NEWNODE(program,stk);
+	    stream_make('m');
+	    break;
 	default:
 	    BADAGGREGATE("map"); }
 }
@@ -2983,15 +4548,75 @@ D(		printf("map: "); writefactor(stk, stdout); printf("\n"); )
 		resultstring[j++] = stk->u.num; }
 	    stk = STRING_NEWNODE(resultstring,SAVED3);
 	    break; }
-	case SET_:
-	  { long i; long resultset = 0;
-	    for (i = 0; i < SETSIZE; i++)
-		if (SAVED2->u.set & (1 << i))
-		  { stk = INTEGER_NEWNODE(i,SAVED3);
-		    exeterm(SAVED1->u.lis);
-		    resultset = resultset | (1 << stk->u.num); }
-	    stk = SET_NEWNODE(resultset,SAVED3);
+	case SET_: case BIGSET_:
+	  { long i; Bigset *result = 0;
+	    Operator op; Types u;
+	    for (i = set_next(SAVED2,0); i >= 0; i = set_next(SAVED2,i + 1))
+	      { stk = INTEGER_NEWNODE(i,SAVED3);
+		exeterm(SAVED1->u.lis);
+		CHECKSETMEMBER(stk,"map");
+		result = set_add(result,stk->u.num); }
+	    op = set_make(result,&u);
+	    stk = newnode(op,u,SAVED3);
+	    break; }
+	case DICT_:
+	  { long i; Node *key, *val, *pair;
+	    dump1 = DICT_NEWNODE(NULL,dump1);		/* result */
+	    for (i = 0; (key = dict_nth(SAVED2->u.dict,i,&val)) != NULL; i++)
+	      { pair = dict_pair(key,val);
+		stk = LIST_NEWNODE(pair,SAVED3);
+		exeterm(SAVED1->u.lis);
+		CHECKPAIR(stk,"map");
+		dump1->u.dict = dict_put(dump1->u.dict,
+					 stk->u.lis,stk->u.lis->next); }
+	    stk = DICT_NEWNODE(dump1->u.dict,SAVED3);
+	    POP(dump1);
+	    break; }
+	case ORDSET_:
+	  { long i; Node *key;
+	    dump1 = ORDSET_NEWNODE(NULL,dump1);		/* result */
+	    for (i = 0; (key = ord_nth(SAVED2->u.ord,i,NULL)) != NULL; i++)
+	      { stk = newnode(key->op,key->u,SAVED3);
+		exeterm(SAVED1->u.lis);
+		dump1->u.ord = ord_insert(dump1->u.ord,stk,NULL,"map"); }
+	    stk = ORDSET_NEWNODE(dump1->u.ord,SAVED3);
+	    POP(dump1);
+	    break; }
+	case ORDMAP_:
+	  { long i; Node *key, *val, *pair;
+	    dump1 = ORDMAP_NEWNODE(NULL,dump1);		/* result */
+	    for (i = 0; (key = ord_nth(SAVED2->u.ord,i,&val)) != NULL; i++)
+	      { pair = dict_pair(key,val);
+		stk = LIST_NEWNODE(pair,SAVED3);
+		exeterm(SAVED1->u.lis);
+		CHECKPAIR(stk,"map");
+		dump1->u.ord = ord_insert(dump1->u.ord,
+					  stk->u.lis,stk->u.lis->next,"map"); }
+	    stk = ORDMAP_NEWNODE(dump1->u.ord,SAVED3);
+	    POP(dump1);
 	    break; }
+	case RANGE_:
+	  { long i; Node *elem;
+	    dump2 = LIST_NEWNODE(0L,dump2);		/* head new */
+	    dump3 = LIST_NEWNODE(0L,dump3);		/* last new */
+	    for (i = 0; i < rng_size(SAVED2->u.rng); i++)
+	      { bucket.num = rng_nth(SAVED2->u.rng,i);
+		stk = newnode(SAVED2->u.rng->type,bucket,SAVED3);
+		exeterm(SAVED1->u.lis);
+		elem = newnode(stk->op,stk->u,NULL);
+		if (DMP2 == NULL)			/* first */
+		    DMP2 = elem;
+		else					/* further */
+		    DMP3->next = elem;
+		DMP3 = elem; }
+	    stk = LIST_NEWNODE(DMP2,SAVED3);
+	    POP(dump3);
+	    POP(dump2);
+	    break; }
+	case STREAM_:
+	    stk = SAVED1;
+	    stream_make('m');
+	    break;
 	default:
 	    BADAGGREGATE("map"); }
     POP(dump);
@@ -3022,12 +4647,58 @@ PRIVATE void step_(void)
 	      { stk = CHAR_NEWNODE((long)*s,stk);
 		exeterm(program); }
 	    break; }
-	case SET_:
-	  { long i, set = data->u.set;
-	    for (i = 0; i < SETSIZE; i++)
-		if (set & (1 << i))
-		  { stk = INTEGER_NEWNODE(i,stk);
-		    exeterm(program); }
+	case SET_: case BIGSET_:
+	  { long i;
+	    for (i = set_next(data,0); i >= 0; i = set_next(data,i + 1))
+	      { stk = INTEGER_NEWNODE(i,stk);
+		exeterm(program); }
+	    break; }
+	case DICT_:
+	  { long i; Node *key, *val;
+	    for (i = 0; (key = dict_nth(data->u.dict,i,&val)) != NULL; i++)
+	      { my_dump = dict_pair(key,val);
+		stk = LIST_NEWNODE(my_dump,stk);
+		exeterm(program); }
+	    break; }
+	case VECTOR_:
+	  { long i;
+	    for (i = 0; i < vec_size(data->u.vec); i++)
+	      { my_dump = vec_at(data->u.vec,i);
+		GNULLARY(my_dump->op,my_dump->u);
+		exeterm(program); }
+	    break; }
+	case DEQUE_:
+	  { my_dump = deq_list(data->u.deq);
+	    while (my_dump != NULL)
+	      { GNULLARY(my_dump->op,my_dump->u);
+		exeterm(program);
+		my_dump = my_dump->next; }
+	    break; }
+	case ORDSET_:
+	  { long i; Node *key;
+	    for (i = 0; (key = ord_nth(data->u.ord,i,NULL)) != NULL; i++)
+	      { GNULLARY(key->op,key->u);
+		exeterm(program); }
+	    break; }
+	case ORDMAP_:
+	  { long i; Node *key, *val;
+	    for (i = 0; (key = ord_nth(data->u.ord,i,&val)) != NULL; i++)
+	      { my_dump = dict_pair(key,val);
+		stk = LIST_NEWNODE(my_dump,stk);
+		exeterm(program); }
+	    break; }
+	case RANGE_:
+	  { long i; Range *r = data->u.rng;
+	    for (i = 0; i < rng_size(r); i++)
+	      { bucket.num = rng_nth(r,i);
+		GNULLARY(r->type,bucket);
+		exeterm(program); }
+	    break; }
+	case STREAM_:
+	  { Stream *str;
+	    for (str = data->u.stream; str != NULL; str = stream_rest(str))
+	      { GNULLARY(str->head.op,str->head.u);
+		exeterm(program); }
 	    break; }
 	default:
 	    BADAGGREGATE("step"); }
@@ -3054,12 +4725,63 @@ PRIVATE void step_(void)
 	      { stk = CHAR_NEWNODE((long)*s,stk);
 		exeterm(SAVED1->u.lis); }
 	    break; }
-	case SET_:
+	case SET_: case BIGSET_:
 	  { long i;
-	    for (i = 0; i < SETSIZE; i++)
-		if (SAVED2->u.set & (1 << i))
-		  { stk = INTEGER_NEWNODE(i,stk);
-		    exeterm(SAVED1->u.lis); }
+	    for (i = set_next(SAVED2,0); i >= 0; i = set_next(SAVED2,i + 1))
+	      { stk = INTEGER_NEWNODE(i,stk);
+		exeterm(SAVED1->u.lis); }
+	    break; }
+	case DICT_:
+	  { long i; Node *key, *val, *pair;
+	    for (i = 0; (key = dict_nth(SAVED2->u.dict,i,&val)) != NULL; i++)
+	      { pair = dict_pair(key,val);
+		stk = LIST_NEWNODE(pair,stk);
+		exeterm(SAVED1->u.lis); }
+	    break; }
+	case VECTOR_:
+	  { long i; Node *elem;
+	    for (i = 0; i < vec_size(SAVED2->u.vec); i++)
+	      { elem = vec_at(SAVED2->u.vec,i);
+		GNULLARY(elem->op,elem->u);
+		exeterm(SAVED1->u.lis); }
+	    break; }
+	case DEQUE_:
+	  { dump1 = LIST_NEWNODE(deq_list(SAVED2->u.deq),dump1);
+	    while (DMP1 != NULL)
+	      { GNULLARY(DMP1->op,DMP1->u);
+		exeterm(SAVED1->u.lis);
+		DMP1 = DMP1->next; }
+	    POP(dump1);
+	    break; }
+	case ORDSET_:
+	  { long i; Node *key;
+	    for (i = 0; (key = ord_nth(SAVED2->u.ord,i,NULL)) != NULL; i++)
+	      { GNULLARY(key->op,key->u);
+		exeterm(SAVED1->u.lis); }
+	    break; }
+	case ORDMAP_:
+	  { long i; Node *key, *val, *pair;
+	    for (i = 0; (key = ord_nth(SAVED2->u.ord,i,&val)) != NULL; i++)
+	      { pair = dict_pair(key,val);
+		stk = LIST_NEWNODE(pair,stk);
+		exeterm(SAVED1->u.lis); }
+	    break; }
+	case RANGE_:
+	  { long i;
+	    for (i = 0; i < rng_size(SAVED2->u.rng); i++)
+	      { bucket.num = rng_nth(SAVED2->u.rng,i);
+		GNULLARY(SAVED2->u.rng->type,bucket);
+		exeterm(SAVED1->u.lis); }
+	    break; }
+	case STREAM_:
+	  { Stream *str;
+	    dump1 = STREAM_NEWNODE(SAVED2->u.stream,dump1);
+	    while (dump1->u.stream != NULL)
+	      { GNULLARY(dump1->u.stream->head.op,dump1->u.stream->head.u);
+		exeterm(SAVED1->u.lis);
+		str = stream_rest(dump1->u.stream);
+		dump1->u.stream = str; }
+	    POP(dump1);
 	    break; }
 	default:
 	    BADAGGREGATE("step"); }
@@ -3132,7 +4854,7 @@ PRIVATE void cond_(void)
 	stk = stk->next;					\
 	first = stk->u.lis;					\
 	stk = stk->next;					\
-	exeterm(stk->op == TYP ? first : second); }
+	exeterm(BASETYPE(stk->op) == TYP ? first : second); }
 #else
 #define IF_TYPE(PROCEDURE,NAME,TYP)				\
     PRIVATE void PROCEDURE(void)				\
@@ -3140,7 +4862,7 @@ PRIVATE void cond_(void)
 	TWOQUOTES(NAME);					\
 	SAVESTACK;						\
 	stk = SAVED3;						\
-	exeterm(stk->op == TYP ? SAVED2->u.lis : SAVED1->u.lis);\
+	exeterm(BASETYPE(stk->op) == TYP ? SAVED2->u.lis : SAVED1->u.lis);\
 	POP(dump); }
 #endif
 IF_TYPE(ifinteger_,"ifinteger",INTEGER_)
@@ -3165,15 +4887,16 @@ PRIVATE void filter_(void)
     stk = stk->next;
     save = stk->next;
     switch (stk->op)
-      { case SET_ :
-	  { long j, set = stk->u.set, resultset = 0;
-	    for (j = 0; j < SETSIZE; j++)
-	      { if (set & (1 << j))
-		  { stk = INTEGER_NEWNODE(j,save);
-		    exeterm(program);
-		    if (stk->u.num)
-			resultset = resultset | (1 << j); } }
-	    stk = SET_NEWNODE(resultset,save);
+      { case SET_ : case BIGSET_ :
+	  { long j; Node *data = stk; Bigset *result = 0;
+	    Operator op; Types u;
+	    for (j = set_next(data,0); j >= 0; j = set_next(data,j + 1))
+	      { stk = INTEGER_NEWNODE(j,save);
+		exeterm(program);
+		if (stk->u.num)
+		    result = set_add(result,j); }
+	    op = set_make(result,&u);
+	    stk = newnode(op,u,save);
 	    break; }
 	case STRING_ :
 	  { char *s, *resultstring; int j = 0;
@@ -3205,64 +4928,307 @@ PRIVATE void filter_(void)
 		my_dump1 = my_dump1->next; }
 	    stk = LIST_NEWNODE(my_dump2,save);
 	    break; }
+	case RANGE_:
+	  { long i; Range *r = stk->u.rng;
+	    for (i = 0; i < rng_size(r); i++)
+	      { bucket.num = rng_nth(r,i);
+		stk = newnode(r->type,bucket,save);
+		exeterm(program);
+		if (stk->u.num)				/* test */
+		  { bucket.num = rng_nth(r,i);
+		    if (my_dump2 == NULL)		/* first */
+		      { my_dump2 = newnode(r->type,bucket,NULL);
+			my_dump3 = my_dump2; }
+		    else				/* further */
+		      { my_dump3->next = newnode(r->type,bucket,NULL);
+			my_dump3 = my_dump3->next; } } }
+	    stk = LIST_NEWNODE(my_dump2,save);
+	    break; }
+	case STREAM_:
+	    stk = LIST_NEWNODE(program,stk);
+	    stream_make('f');
+	    break;
+	default :
+	    BADAGGREGATE("filter"); }
+}
+#else
+PRIVATE void filter_(void)
+{
+    TWOPARAMS("filter");
+    ONEQUOTE("filter");
+    SAVESTACK;
+    switch (SAVED2->op)
+      { case SET_ : case BIGSET_ :
+	  { long j; Bigset *result = 0;
+	    Operator op; Types u;
+	    for (j = set_next(SAVED2,0); j >= 0; j = set_next(SAVED2,j + 1))
+	      { stk = INTEGER_NEWNODE(j,SAVED3);
+		exeterm(SAVED1->u.lis);
+		if (stk->u.num)
+		    result = set_add(result,j); }
+	    op = set_make(result,&u);
+	    stk = newnode(op,u,SAVED3);
+	    break; }
+	case STRING_ :
+	  { char *s, *resultstring; int j = 0;
+	    resultstring =
+		(char *) malloc(strlen(SAVED2->u.str) + 1);
+	    for (s = SAVED2->u.str; *s != '\0'; s++)
+	      { stk = CHAR_NEWNODE((long)*s, SAVED3);
+		exeterm(SAVED1->u.lis);
+		if (stk->u.num) resultstring[j++] = *s; }
+	    resultstring[j] = '\0';
+	    stk = STRING_NEWNODE(resultstring,SAVED3);
+	    break; }
+	case LIST_:
+	  { dump1 = newnode(LIST_,SAVED2->u,dump1);	/* step old */
+	    dump2 = LIST_NEWNODE(0L,dump2);		/* head new */
+	    dump3 = LIST_NEWNODE(0L,dump3);		/* last new */
+	    while (DMP1 != NULL)
+	      { stk = newnode(DMP1->op,DMP1->u,SAVED3);
+		exeterm(SAVED1->u.lis);
+D(		printf("filter: "); writefactor(stk, stdout); printf("\n"); )
+		if (stk->u.num)				/* test */
+		    { if (DMP2 == NULL)			/* first */
+		      { DMP2 =
+			    newnode(DMP1->op,
+				DMP1->u,NULL);
+			DMP3 = DMP2; }
+		    else				/* further */
+		      { DMP3->next =
+			    newnode(DMP1->op,
+				DMP1->u,NULL);
+			DMP3 = DMP3->next; } }
+		DMP1 = DMP1->next; }
+	    stk = LIST_NEWNODE(DMP2,SAVED3);
+	    POP(dump3);
+	    POP(dump2);
+	    POP(dump1);
+	    break; }
+	case RANGE_:
+	  { long i; Node *elem;
+	    dump2 = LIST_NEWNODE(0L,dump2);		/* head new */
+	    dump3 = LIST_NEWNODE(0L,dump3);		/* last new */
+	    for (i = 0; i < rng_size(SAVED2->u.rng); i++)
+	      { bucket.num = rng_nth(SAVED2->u.rng,i);
+		stk = newnode(SAVED2->u.rng->type,bucket,SAVED3);
+		exeterm(SAVED1->u.lis);
+		if (stk->u.num)				/* test */
+		  { bucket.num = rng_nth(SAVED2->u.rng,i);
+		    elem = newnode(SAVED2->u.rng->type,bucket,NULL);
+		    if (DMP2 == NULL)			/* first */
+			DMP2 = elem;
+		    else				/* further */
+			DMP3->next = elem;
+		    DMP3 = elem; } }
+	    stk = LIST_NEWNODE(DMP2,SAVED3);
+	    POP(dump3);
+	    POP(dump2);
+	    break; }
+	case STREAM_:
+	    stk = SAVED1;
+	    stream_make('f');
+	    break;
 	default :
 	    BADAGGREGATE("filter"); }
+    POP(dump);
+}
+#endif
+
+/*
+    pipe_stages checks that the quotation n is a chain [P] map or [B]
+    filter, ended by nothing, by [P] step or by V0 [P] fold. It delivers
+    the number of map and filter stages and the end in term: 0, 's' or
+    'f', or -1 when n is not such a chain.
+*/
+PRIVATE int pipe_stages(Node *n, int *term)
+{
+    int count;
+
+    for (*term = count = 0; n != NULL; n = n->next->next, count++) {
+	if (n->op == LIST_ && n->next != NULL && n->next->next == NULL &&
+	    n->next->op >= FALSE_ && n->next->u.proc == step_) {
+	    *term = 's';
+	    break;
+	}
+	if (n->op != USR_ && n->op < FALSE_ && n->next != NULL &&
+	    n->next->op == LIST_ && n->next->next != NULL &&
+	    n->next->next->next == NULL && n->next->next->op >= FALSE_ &&
+	    n->next->next->u.proc == fold_) {
+	    *term = 'f';
+	    break;
+	}
+	if (n->op != LIST_ || n->next == NULL || n->next->op < FALSE_ ||
+	    (n->next->u.proc != map_ && n->next->u.proc != filter_))
+	    return -1;
+    }
+    return count;
+}
+
+/*
+    pipe_stage delivers the i-th stage of the chain n, or its end.
+*/
+PRIVATE Node *pipe_stage(Node *n, int i)
+{
+    while (i--)
+	n = n->next->next;
+    return n;
+}
+
+#ifdef SINGLE
+/*
+    pipe_elem runs the count stages of the chain n on X, each time on
+    top of the stack save. It delivers the result, or NULL when a filter
+    drops X.
+*/
+PRIVATE Node *pipe_elem(Node *n, int count, Node *x, Node *save)
+{
+    for (; count--; n = n->next->next) {
+	stk = newnode(x->op, x->u, save);
+	exeterm(n->u.lis);
+	if (n->next->u.proc == map_)
+	    x = stk;
+	else if (!stk->u.num)
+	    return NULL;
+    }
+    return x;
+}
+
+PRIVATE void pipe_(void)
+{
+    Node *program, *data, *save, *state = 0, *end, *x, *elem = 0,
+	 *head = 0, *last = 0;
+    long i = 0;
+    int count, term;
+
+    TWOPARAMS("pipe");
+    ONEQUOTE("pipe");
+    program = stk->u.lis;
+    data = stk->next;
+    save = data->next;
+    count = pipe_stages(program, &term);
+    if (count < 0 || (data->op != LIST_ && data->op != RANGE_)) {
+	stk = data;
+	exeterm(program);
+	return;
+    }
+    end = pipe_stage(program, count);
+    if (term == 's')
+	state = save;
+    else if (term == 'f')
+	state = newnode(end->op, end->u, save);
+    if (data->op == LIST_)
+	elem = data->u.lis;
+    for (;;) {
+	if (data->op == LIST_) {
+	    if (elem == NULL)
+		break;
+	    x = elem;
+	    elem = elem->next;
+	} else {
+	    if (i == rng_size(data->u.rng))
+		break;
+	    bucket.num = rng_nth(data->u.rng, i++);
+	    x = newnode(data->u.rng->type, bucket, NULL);
+	}
+	if ((x = pipe_elem(program, count, x, save)) == NULL)
+	    continue;
+	if (term) {
+	    stk = newnode(x->op, x->u, state);
+	    exeterm(term == 's' ? end->u.lis : end->next->u.lis);
+	    state = stk;
+	} else if (head == NULL)			/* first */
+	    head = last = newnode(x->op, x->u, NULL);
+	else {						/* further */
+	    last->next = newnode(x->op, x->u, NULL);
+	    last = last->next;
+	}
+    }
+    stk = term ? state : LIST_NEWNODE(head, save);
 }
 #else
-PRIVATE void filter_(void)
+/*
+    pipe_elem runs the count stages of the chain in SAVED1 on X, each time
+    on top of the stack SAVED3. It leaves the result in dump5 and delivers
+    1, or delivers 0 when a filter drops X.
+*/
+PRIVATE int pipe_elem(int count, Node *x)
 {
-    TWOPARAMS("filter");
-    ONEQUOTE("filter");
+    int i;
+
+    dump5 = newnode(x->op, x->u, dump5);
+    for (i = 0; i < count; i++) {
+	stk = newnode(dump5->op, dump5->u, SAVED3);
+	exeterm(pipe_stage(SAVED1->u.lis, i)->u.lis);
+	if (pipe_stage(SAVED1->u.lis, i)->next->u.proc == map_) {
+	    dump5->op = stk->op;
+	    dump5->u = stk->u;
+	} else if (!stk->u.num) {
+	    POP(dump5);
+	    return 0;
+	}
+    }
+    return 1;
+}
+
+PRIVATE void pipe_(void)
+{
+    Node *end, *elem;
+    long i = 0;
+    int count, term;
+
+    TWOPARAMS("pipe");
+    ONEQUOTE("pipe");
+    count = pipe_stages(stk->u.lis, &term);
+    if (count < 0 || (stk->next->op != LIST_ && stk->next->op != RANGE_)) {
+	SAVESTACK;
+	stk = SAVED2;
+	exeterm(SAVED1->u.lis);
+	POP(dump);
+	return;
+    }
     SAVESTACK;
-    switch (SAVED2->op)
-      { case SET_ :
-	  { long j; long resultset = 0;
-	    for (j = 0; j < SETSIZE; j++)
-	      { if (SAVED2->u.set & (1 << j))
-		  { stk = INTEGER_NEWNODE(j,SAVED3);
-		    exeterm(SAVED1->u.lis);
-		    if (stk->u.num)
-			resultset = resultset | (1 << j); } }
-	    stk = SET_NEWNODE(resultset,SAVED3);
-	    break; }
-	case STRING_ :
-	  { char *s, *resultstring; int j = 0;
-	    resultstring =
-		(char *) malloc(strlen(SAVED2->u.str) + 1);
-	    for (s = SAVED2->u.str; *s != '\0'; s++)
-	      { stk = CHAR_NEWNODE((long)*s, SAVED3);
-		exeterm(SAVED1->u.lis);
-		if (stk->u.num) resultstring[j++] = *s; }
-	    resultstring[j] = '\0';
-	    stk = STRING_NEWNODE(resultstring,SAVED3);
-	    break; }
-	case LIST_:
-	  { dump1 = newnode(LIST_,SAVED2->u,dump1);	/* step old */
-	    dump2 = LIST_NEWNODE(0L,dump2);		/* head new */
-	    dump3 = LIST_NEWNODE(0L,dump3);		/* last new */
-	    while (DMP1 != NULL)
-	      { stk = newnode(DMP1->op,DMP1->u,SAVED3);
-		exeterm(SAVED1->u.lis);
-D(		printf("filter: "); writefactor(stk, stdout); printf("\n"); )
-		if (stk->u.num)				/* test */
-		    { if (DMP2 == NULL)			/* first */
-		      { DMP2 =
-			    newnode(DMP1->op,
-				DMP1->u,NULL);
-			DMP3 = DMP2; }
-		    else				/* further */
-		      { DMP3->next =
-			    newnode(DMP1->op,
-				DMP1->u,NULL);
-			DMP3 = DMP3->next; } }
-		DMP1 = DMP1->next; }
-	    stk = LIST_NEWNODE(DMP2,SAVED3);
-	    POP(dump3);
-	    POP(dump2);
-	    POP(dump1);
-	    break; }
-	default :
-	    BADAGGREGATE("filter"); }
+    dump4 = LIST_NEWNODE(SAVED3,dump4);		/* state */
+    if (term == 'f')
+      { end = pipe_stage(SAVED1->u.lis,count);
+	DMP4 = newnode(end->op,end->u,SAVED3); }
+    dump1 = LIST_NEWNODE(SAVED2->op == LIST_ ? SAVED2->u.lis : NULL,
+			 dump1);			/* step old */
+    dump2 = LIST_NEWNODE(0L,dump2);		/* head new */
+    dump3 = LIST_NEWNODE(0L,dump3);		/* last new */
+    for (;;)
+      { if (SAVED2->op == LIST_)
+	  { if (DMP1 == NULL)
+		break;
+	    if (!pipe_elem(count,DMP1))
+	      { DMP1 = DMP1->next;
+		continue; }
+	    DMP1 = DMP1->next; }
+	else
+	  { if (i == rng_size(SAVED2->u.rng))
+		break;
+	    bucket.num = rng_nth(SAVED2->u.rng,i++);
+	    elem = newnode(SAVED2->u.rng->type,bucket,NULL);
+	    if (!pipe_elem(count,elem))
+		continue; }
+	if (term)
+	  { stk = newnode(dump5->op,dump5->u,DMP4);
+	    end = pipe_stage(SAVED1->u.lis,count);
+	    exeterm(term == 's' ? end->u.lis : end->next->u.lis);
+	    DMP4 = stk; }
+	else
+	  { elem = newnode(dump5->op,dump5->u,NULL);
+	    if (DMP2 == NULL)				/* first */
+		DMP2 = elem;
+	    else					/* further */
+		DMP3->next = elem;
+	    DMP3 = elem; }
+	POP(dump5); }
+    stk = term ? DMP4 : LIST_NEWNODE(DMP2,SAVED3);
+    POP(dump3);
+    POP(dump2);
+    POP(dump1);
+    POP(dump4);
     POP(dump);
 }
 #endif
@@ -3282,17 +5248,19 @@ PRIVATE void split_(void)
     stk = stk->next;
     save = stk->next;
     switch (stk->op)
-      { case SET_ :
-	  { long j, set = stk->u.set, yes_set = 0, no_set = 0;
-	    for (j = 0; j < SETSIZE; j++)
-	      { if (set & (1 << j))
-		  { stk = INTEGER_NEWNODE(j,save);
-		    exeterm(program);
-		    if (stk->u.num)
-			  yes_set = yes_set | (1 << j);
-		    else  no_set = no_set | (1 << j); } }
-	    stk = SET_NEWNODE(yes_set,save);
-	    NULLARY(SET_NEWNODE,no_set);
+      { case SET_ : case BIGSET_ :
+	  { long j; Node *data = stk; Bigset *yes_set = 0, *no_set = 0;
+	    Operator op; Types u;
+	    for (j = set_next(data,0); j >= 0; j = set_next(data,j + 1))
+	      { stk = INTEGER_NEWNODE(j,save);
+		exeterm(program);
+		if (stk->u.num)
+		      yes_set = set_add(yes_set,j);
+		else  no_set = set_add(no_set,j); }
+	    op = set_make(yes_set,&u);
+	    stk = newnode(op,u,save);
+	    op = set_make(no_set,&u);
+	    GNULLARY(op,u);
 	    break; }
 	case STRING_ :
 	  { char *s, *yesstring, *nostring; int yesptr = 0, noptr = 0;
@@ -3350,17 +5318,19 @@ PRIVATE void split_(void)
     ONEQUOTE("split");
     SAVESTACK;
     switch (SAVED2->op)
-      { case SET_ :
-	  { long j; long yes_set = 0, no_set = 0;
-	    for (j = 0; j < SETSIZE; j++)
-	      { if (SAVED2->u.set & (1 << j))
-		  { stk = INTEGER_NEWNODE(j,SAVED3);
-		    exeterm(SAVED1->u.lis);
-		    if (stk->u.num)
-			  yes_set = yes_set | (1 << j);
-		    else  no_set = no_set | (1 << j); } }
-	    stk = SET_NEWNODE(yes_set,SAVED3);
-	    NULLARY(SET_NEWNODE,no_set);
+      { case SET_ : case BIGSET_ :
+	  { long j; Bigset *yes_set = 0, *no_set = 0;
+	    Operator op; Types u;
+	    for (j = set_next(SAVED2,0); j >= 0; j = set_next(SAVED2,j + 1))
+	      { stk = INTEGER_NEWNODE(j,SAVED3);
+		exeterm(SAVED1->u.lis);
+		if (stk->u.num)
+		      yes_set = set_add(yes_set,j);
+		else  no_set = set_add(no_set,j); }
+	    op = set_make(yes_set,&u);
+	    stk = newnode(op,u,SAVED3);
+	    op = set_make(no_set,&u);
+	    GNULLARY(op,u);
 	    break; }
 	case STRING_ :
 	  { char *s, *yesstring, *nostring; int yesptr = 0, noptr = 0;
@@ -3424,6 +5394,309 @@ D(		printf("split: "); writefactor(stk, stdout); printf("\n"); )
 }
 #endif
 
+/*
+    sort, sortby and sortkey copy the aggregate into fresh cells, that
+    are then relinked in order by a stable merge sort. sortkey first
+    decorates each cell with its key as [key cell ..], sortby asks the
+    quotation whether X comes strictly before Y. Strings are sorted on
+    their characters, sort does that by counting them, and vectors on
+    their elements.
+*/
+#define sort_name	(joy_context->sort_name)
+
+/*
+    sort_vector replaces a vector to be sorted by the list of its elements;
+    the sorted list is made a vector again at the end.
+*/
+PRIVATE void sort_vector(int mode)
+{
+    Node *list;
+
+    if (mode)
+      { list = vec_list(stk->next->u.vec);
+	list = LIST_NEWNODE(list, stk->next->next);
+	stk = newnode(stk->op, stk->u, list); }
+    else
+      { list = vec_list(stk->u.vec);
+	UNARY(LIST_NEWNODE, list); }
+}
+
+PRIVATE int sort_less(Node *first, Node *second)
+{
+    int error;
+
+    if (Compare(first, second, &error) < 0)
+	return 1;
+    if (error)
+	BADDATA(sort_name);
+    return 0;
+}
+
+PRIVATE int sortkey_less(Node *first, Node *second)
+{
+    return sort_less(first->u.lis, second->u.lis);
+}
+
+PRIVATE char *sort_string(char *str)
+{
+    long count[256], i, j, k;
+    char *result;
+
+    result = (char *) malloc(strlen(str) + 1);
+    memset(count, 0, sizeof(count));
+    for (i = 0; str[i] != '\0'; i++)
+	count[(unsigned char)str[i]]++;
+    for (i = CHAR_MIN, k = 0; i <= CHAR_MAX; i++)
+	for (j = count[(unsigned char)i]; j > 0; j--)
+	    result[k++] = (char)i;
+    result[k] = '\0';
+    return result;
+}
+
+PRIVATE char *sort_chars(Node *list, long n)
+{
+    char *result;
+    long i;
+
+    result = (char *) malloc(n + 1);
+    for (i = 0; list != NULL; list = list->next)
+	result[i++] = (char)list->u.num;
+    result[i] = '\0';
+    return result;
+}
+
+PRIVATE Node *sort_unwrap(Node *list)	/* [key cell ..] -> cell */
+{
+    Node *pair;
+
+    for (pair = list; pair != NULL; pair = pair->next)
+	pair->u.lis->next->next =
+		pair->next != NULL ? pair->next->u.lis->next : NULL;
+    return list != NULL ? list->u.lis->next : NULL;
+}
+
+#ifdef SINGLE
+#define sort_program	(joy_context->sort_program)
+
+PRIVATE int sortby_less(Node *first, Node *second)
+{
+    Node *save = stk;
+    int less;
+
+    stk = newnode(first->op, first->u, stk);
+    stk = newnode(second->op, second->u, stk);
+    exeterm(sort_program);
+    less = stk->u.num != 0;
+    stk = save;
+    return less;
+}
+
+PRIVATE void sort_aux(char *name, int mode)
+{
+    Node *program = NULL, *save, *list = NULL, *last = NULL, *cell, *next;
+    long n = 0;
+    int string, vector;
+    char *s;
+
+    if (mode)
+      { TWOPARAMS(name);
+	ONEQUOTE(name); }
+    else
+	ONEPARAM(name);
+    if ((vector = (mode ? stk->next : stk)->op == VECTOR_) != 0)
+	sort_vector(mode);
+    if (mode)
+      { program = stk->u.lis;
+	POP(stk); }
+    if (!mode && stk->op == STRING_)
+      { UNARY(STRING_NEWNODE, sort_string(stk->u.str));
+	return; }
+    save = stk->next;
+    if ((string = stk->op == STRING_) != 0)
+	for (s = stk->u.str; *s != '\0'; s++, n++)
+	  { cell = CHAR_NEWNODE((long) *s, NULL);
+	    if (list == NULL) list = cell; else last->next = cell;
+	    last = cell; }
+    else if (stk->op == LIST_)
+	for (next = stk->u.lis; next != NULL; next = next->next, n++)
+	  { cell = newnode(next->op, next->u, NULL);
+	    if (list == NULL) list = cell; else last->next = cell;
+	    last = cell; }
+    else
+	BADAGGREGATE(name);
+    sort_name = name;
+    switch (mode)
+      { case 'b':
+	  { Node *outer = sort_program;		/* sortby in sortby */
+	    sort_program = program;
+	    list = sort_list(list, n, sortby_less);
+	    sort_program = outer;
+	    break; }
+	case 'k':
+	    for (cell = list, list = NULL; cell != NULL; cell = next)
+	      { next = cell->next;
+		cell->next = NULL;
+		stk = newnode(cell->op, cell->u, save);
+		exeterm(program);
+		stk = newnode(stk->op, stk->u, cell);
+		stk = LIST_NEWNODE(stk, NULL);
+		if (list == NULL) list = stk; else last->next = stk;
+		last = stk; }
+	    sort_name = name;
+	    list = sort_unwrap(sort_list(list, n, sortkey_less));
+	    break;
+	default:
+	    list = sort_list(list, n, sort_less);
+	    break; }
+    stk = save;
+    if (string)
+	NULLARY(STRING_NEWNODE, sort_chars(list, n));
+    else if (vector)
+	NULLARY(VECTOR_NEWNODE, vec_make(list));
+    else
+	NULLARY(LIST_NEWNODE, list);
+}
+#else
+/*
+    The comparisons of sortby may move the cells, so the merge sort works
+    on their positions in the copy, that stays in its original order and
+    is rooted in dump1; the cells are looked up again after a collection.
+*/
+#define SORTDATA (mode ? SAVED2 : SAVED1)
+#define SORTREST (mode ? SAVED3 : SAVED2)
+#define SORTAPPEND						\
+    if (DMP1 == NULL) DMP1 = stk; else DMP2->next = stk;	\
+    DMP2 = stk
+
+#define sort_cells	(joy_context->sort_cells)
+#define sort_count	(joy_context->sort_count)
+#define sort_epoch	(joy_context->sort_epoch)
+
+PRIVATE void sort_refresh(void)
+{
+    Node *cell;
+    long i;
+
+    for (cell = DMP1, i = 0; i < sort_count; cell = cell->next)
+	sort_cells[i++] = cell;
+    sort_epoch = gc_epoch;
+}
+
+PRIVATE int sortby_less(long first, long second)
+{
+    if (sort_epoch != gc_epoch)
+	sort_refresh();
+    stk = newnode(sort_cells[first]->op, sort_cells[first]->u, SAVED3);
+    if (sort_epoch != gc_epoch)
+	sort_refresh();
+    stk = newnode(sort_cells[second]->op, sort_cells[second]->u, stk);
+    exeterm(SAVED1->u.lis);
+    return stk->u.num != 0;
+}
+
+PRIVATE void sort_aux(char *name, int mode)
+{
+    long i, n = 0, *index, *temp;
+    int string, vector;
+    char *s;
+
+    if (mode)
+      { TWOPARAMS(name);
+	ONEQUOTE(name); }
+    else
+	ONEPARAM(name);
+    if ((vector = (mode ? stk->next : stk)->op == VECTOR_) != 0)
+	sort_vector(mode);
+    if (!mode && stk->op == STRING_)
+      { UNARY(STRING_NEWNODE, sort_string(stk->u.str));
+	return; }
+    SAVESTACK;
+    dump1 = LIST_NEWNODE(0L,dump1);		/* head */
+    dump2 = LIST_NEWNODE(0L,dump2);		/* last */
+    if ((string = SORTDATA->op == STRING_) != 0)
+	for (s = SORTDATA->u.str; *s != '\0'; s++, n++)
+	  { stk = CHAR_NEWNODE((long) *s, NULL);
+	    SORTAPPEND; }
+    else if (SORTDATA->op == LIST_)
+      { dump3 = newnode(LIST_,SORTDATA->u,dump3);	/* step */
+	for (; DMP3 != NULL; DMP3 = DMP3->next, n++)
+	  { stk = newnode(DMP3->op,DMP3->u,NULL);
+	    SORTAPPEND; }
+	POP(dump3); }
+    else
+	BADAGGREGATE(name);
+    sort_name = name;
+    switch (mode)
+      { case 'b':
+	  { Node **cells = sort_cells;		/* sortby in sortby */
+	    long count = sort_count, epoch = sort_epoch;
+	    index = (long *) malloc(n * sizeof(long) + 1);
+	    temp = (long *) malloc(n * sizeof(long) + 1);
+	    sort_cells = (Node **) malloc(n * sizeof(Node *) + 1);
+	    for (i = 0; i < n; i++)
+		index[i] = i;
+	    sort_count = n;
+	    sort_refresh();
+	    sort_index(index, temp, n, sortby_less);
+	    sort_refresh();
+	    for (i = 1; i < n; i++)
+		sort_cells[index[i - 1]]->next = sort_cells[index[i]];
+	    if (n)
+	      { sort_cells[index[n - 1]]->next = NULL;
+		DMP1 = sort_cells[index[0]]; }
+	    free(index);
+	    free(temp);
+	    free(sort_cells);
+	    sort_cells = cells;
+	    sort_count = count;
+	    sort_epoch = epoch;
+	    break; }
+	case 'k':
+	    dump3 = LIST_NEWNODE(DMP1,dump3);	/* step */
+	    DMP1 = NULL;
+	    while (DMP3 != NULL)
+	      { stk = newnode(DMP3->op,DMP3->u,SAVED3);
+		exeterm(SAVED1->u.lis);
+		stk = newnode(stk->op,stk->u,DMP3);
+		DMP3 = DMP3->next;
+		stk->next->next = NULL;
+		stk = LIST_NEWNODE(stk,NULL);
+		SORTAPPEND; }
+	    POP(dump3);
+	    sort_name = name;
+	    DMP1 = sort_unwrap(sort_list(DMP1, n, sortkey_less));
+	    break;
+	default:
+	    DMP1 = sort_list(DMP1, n, sort_less);
+	    break; }
+    stk = SORTREST;
+    if (string)
+	NULLARY(STRING_NEWNODE, sort_chars(DMP1, n));
+    else if (vector)
+	NULLARY(VECTOR_NEWNODE, vec_make(DMP1));
+    else
+	NULLARY(LIST_NEWNODE, DMP1);
+    POP(dump2);
+    POP(dump1);
+    POP(dump);
+}
+#endif
+
+PRIVATE void sort_(void)
+{
+    sort_aux("sort", 0);
+}
+
+PRIVATE void sortby_(void)
+{
+    sort_aux("sortby", 'b');
+}
+
+PRIVATE void sortkey_(void)
+{
+    sort_aux("sortkey", 'k');
+}
+
 #ifdef SINGLE
 #define SOMEALL(PROCEDURE,NAME,INITIAL)				\
 PRIVATE void PROCEDURE(void)					\
@@ -3435,14 +5708,14 @@ PRIVATE void PROCEDURE(void)					\
     stk = stk->next;						\
     save = stk->next;						\
     switch (stk->op)						\
-      { case SET_ :						\
-	  { long j, set = stk->u.set;				\
-	    for (j = 0; j < SETSIZE && result == INITIAL; j++)	\
-	      { if (set & (1 << j))				\
-		  { stk = INTEGER_NEWNODE(j,save);		\
-		    exeterm(program);				\
-		    if (stk->u.num != INITIAL)			\
-			result = 1 - INITIAL; } }		\
+      { case SET_ : case BIGSET_ :				\
+	  { long j; Node *data = stk;				\
+	    for (j = set_next(data,0); j >= 0 && result == INITIAL; \
+		 j = set_next(data,j + 1))			\
+	      { stk = INTEGER_NEWNODE(j,save);			\
+		exeterm(program);				\
+		if (stk->u.num != INITIAL)			\
+		    result = 1 - INITIAL; }			\
 	    break; }						\
 	case STRING_ :						\
 	  { char *s;						\
@@ -3463,6 +5736,15 @@ PRIVATE void PROCEDURE(void)					\
 		     result = 1 - INITIAL;			\
 		my_dump = my_dump->next; }			\
 	    break; }						\
+	case RANGE_ :						\
+	  { long j; Range *r = stk->u.rng;			\
+	    for (j = 0; j < rng_size(r) && result == INITIAL; j++) \
+	      { bucket.num = rng_nth(r,j);			\
+		stk = newnode(r->type,bucket,save);		\
+		exeterm(program);				\
+		if (stk->u.num != INITIAL)			\
+		    result = 1 - INITIAL; }			\
+	    break; }						\
 	default :						\
 	    BADAGGREGATE(NAME); }				\
     stk = BOOLEAN_NEWNODE(result,save);				\
@@ -3475,14 +5757,14 @@ PRIVATE void PROCEDURE(void)					\
     ONEQUOTE(NAME);						\
     SAVESTACK;							\
     switch (SAVED2->op)						\
-      { case SET_ :						\
+      { case SET_ : case BIGSET_ :				\
 	  { long j;						\
-	    for (j = 0; j < SETSIZE && result == INITIAL; j++)	\
-	      { if (SAVED2->u.set & (1 << j))			\
-		  { stk = INTEGER_NEWNODE(j,SAVED3);		\
-		    exeterm(SAVED1->u.lis);			\
-		    if (stk->u.num != INITIAL)			\
-			result = 1 - INITIAL; } }		\
+	    for (j = set_next(SAVED2,0); j >= 0 && result == INITIAL; \
+		 j = set_next(SAVED2,j + 1))			\
+	      { stk = INTEGER_NEWNODE(j,SAVED3);		\
+		exeterm(SAVED1->u.lis);				\
+		if (stk->u.num != INITIAL)			\
+		    result = 1 - INITIAL; }			\
 	    break; }						\
 	case STRING_ :						\
 	  { char *s;						\
@@ -3504,6 +5786,16 @@ PRIVATE void PROCEDURE(void)					\
 		DMP1 = DMP1->next; }				\
 	    POP(dump1);						\
 	    break; }						\
+	case RANGE_ :						\
+	  { long j;						\
+	    for (j = 0; j < rng_size(SAVED2->u.rng) && result == INITIAL; \
+		 j++)						\
+	      { bucket.num = rng_nth(SAVED2->u.rng,j);		\
+		stk = newnode(SAVED2->u.rng->type,bucket,SAVED3); \
+		exeterm(SAVED1->u.lis);				\
+		if (stk->u.num != INITIAL)			\
+		    result = 1 - INITIAL; }			\
+	    break; }						\
 	default :						\
 	    BADAGGREGATE(NAME); }				\
     stk = BOOLEAN_NEWNODE(result,SAVED3);			\
@@ -3540,12 +5832,11 @@ PRIVATE void primrec_(void)
 	      { stk = CHAR_NEWNODE((long) *s, stk);
 		n++; }
 	    break; }
-	case SET_:
-	  { long j; long set = data->u.set;
-	    for (j = 0; j < SETSIZE; j++)
-		if (set & (1 << j))
-		  { stk = INTEGER_NEWNODE(j,stk);
-		    n++; }
+	case SET_: case BIGSET_:
+	  { long j;
+	    for (j = set_next(data,0); j >= 0; j = set_next(data,j + 1))
+	      { stk = INTEGER_NEWNODE(j,stk);
+		n++; }
 	    break; }
 	case INTEGER_:
 	  { long j;
@@ -3553,6 +5844,13 @@ PRIVATE void primrec_(void)
 	      { stk = INTEGER_NEWNODE(j, stk);
 		n++; }
 	    break; }
+	case RANGE_:
+	  { long j; Range *r = data->u.rng;
+	    for (j = 0; j < rng_size(r); j++)
+	      { bucket.num = rng_nth(r,j);
+		stk = newnode(r->type,bucket,stk);
+		n++; }
+	    break; }
 	default:
 	    BADDATA("primrec"); }
     exeterm(second);
@@ -3582,12 +5880,11 @@ PRIVATE void primrec_(void)
 	      { stk = CHAR_NEWNODE((long) *s, stk);
 		n++; }
 	    break; }
-	case SET_:
-	  { long j; long set = SAVED3->u.set;
-	    for (j = 0; j < SETSIZE; j++)
-		if (set & (1 << j))
-		  { stk = INTEGER_NEWNODE(j,stk);
-		    n++; }
+	case SET_: case BIGSET_:
+	  { long j;
+	    for (j = set_next(SAVED3,0); j >= 0; j = set_next(SAVED3,j + 1))
+	      { stk = INTEGER_NEWNODE(j,stk);
+		n++; }
 	    break; }
 	case INTEGER_:
 	  { long j;
@@ -3595,6 +5892,13 @@ PRIVATE void primrec_(void)
 	      { stk = INTEGER_NEWNODE(j, stk);
 		n++; }
 	    break; }
+	case RANGE_:
+	  { long j;
+	    for (j = 0; j < rng_size(SAVED3->u.rng); j++)
+	      { bucket.num = rng_nth(SAVED3->u.rng,j);
+		stk = newnode(SAVED3->u.rng->type,bucket,stk);
+		n++; }
+	    break; }
 	default:
 	    BADDATA("primrec"); }
     exeterm(SAVED2->u.lis);
@@ -4044,54 +6348,179 @@ PRIVATE void linrec_(void)
 #endif
 
 #ifdef SINGLE
-PRIVATE void binrecaux(Node *first, Node *second, Node *third, Node *fourth)
+PRIVATE void binrecaux(Node *first, Node *second, Node *third, Node *fourth)
+{
+    Node *save;
+    int result;
+
+    save = stk;
+    exeterm(first);
+    result = stk->u.num;
+    stk = save;
+    if (result)
+	exeterm(second);
+    else {
+	exeterm(third);				/* split */
+	save = stk;
+	stk = stk->next;
+	binrecaux(first, second, third, fourth);/* first */
+	GNULLARY(save->op, save->u);
+	binrecaux(first, second, third, fourth);/* second */
+	exeterm(fourth);			/* combine */
+    }
+}
+#else
+PRIVATE void binrecaux(void)
+{
+    int result;
+    dump1 = LIST_NEWNODE(stk,dump1);
+    exeterm(SAVED4->u.lis);
+    result = stk->u.num;
+    stk = DMP1; POP(dump1);
+    if (result) exeterm(SAVED3->u.lis); else
+      { exeterm(SAVED2->u.lis);		/* split */
+	dump2 = newnode(stk->op,stk->u,dump2);
+	POP(stk);
+	binrecaux();			/* first */
+	GNULLARY(dump2->op,dump2->u);
+	POP(dump2);
+	binrecaux();			/* second */
+	exeterm(SAVED1->u.lis); }	/* combine */
+}
+#endif
+
+#ifdef SINGLE
+PRIVATE void binrec_(void)
+{
+    Node *first, *second, *third, *fourth;
+
+    FOURPARAMS("binrec");
+    FOURQUOTES("binrec");
+    fourth = stk->u.lis;
+    stk = stk->next;
+    third = stk->u.lis;
+    stk = stk->next;
+    second = stk->u.lis;
+    stk = stk->next;
+    first = stk->u.lis;
+    stk = stk->next;
+    binrecaux(first, second, third, fourth);
+}
+#else
+PRIVATE void binrec_(void)
+{
+    FOURPARAMS("binrec");
+    FOURQUOTES("binrec");
+    SAVESTACK;
+    stk = SAVED5;
+    binrecaux();
+    POP(dump);
+}
+#endif
+
+/*
+    pbinrecaux is binrecaux that, up to depth levels of recursion, hands
+    the first branch to a worker and does the second branch meanwhile.
+    The branches must each replace just their own argument: if one of
+    them does more, or the worker fails, the branches are done again,
+    one after the other.
+*/
+#ifdef SINGLE
+PRIVATE void pbinrecaux(Node *first, Node *second, Node *third, Node *fourth,
+			long depth)
 {
-    Node *save;
-    int result;
+    Node *save, *rest, *value;
+    int result, job, ok = 0;
 
+    if (depth <= 0) {
+	binrecaux(first, second, third, fourth);
+	return;
+    }
     save = stk;
     exeterm(first);
     result = stk->u.num;
     stk = save;
-    if (result)
+    if (result) {
 	exeterm(second);
-    else {
-	exeterm(third);				/* split */
-	save = stk;
-	stk = stk->next;
+	return;
+    }
+    exeterm(third);				/* split */
+    save = stk;
+    rest = stk->next->next;
+    if ((job = par_fork()) == 0) {		/* first */
+	stk = save->next;
+	pbinrecaux(first, second, third, fourth, depth - 1);
+	par_done(stk->next == rest ? stk : NULL);
+    }
+    if (job > 0) {				/* second */
+	stk = newnode(save->op, save->u, rest);
+	pbinrecaux(first, second, third, fourth, depth - 1);
+	value = stk;
+	stk = rest;
+	ok = par_join(job) && value->next == rest;
+	if (ok)
+	    GNULLARY(value->op, value->u);
+    }
+    if (!ok) {
+	stk = save->next;
 	binrecaux(first, second, third, fourth);/* first */
 	GNULLARY(save->op, save->u);
 	binrecaux(first, second, third, fourth);/* second */
-	exeterm(fourth);			/* combine */
     }
+    exeterm(fourth);				/* combine */
 }
 #else
-PRIVATE void binrecaux(void)
+PRIVATE void pbinrecaux(long depth)
 {
-    int result;
+    int result, job, ok = 0;
+
+    if (depth <= 0)
+      { binrecaux();
+	return; }
     dump1 = LIST_NEWNODE(stk,dump1);
     exeterm(SAVED4->u.lis);
     result = stk->u.num;
     stk = DMP1; POP(dump1);
-    if (result) exeterm(SAVED3->u.lis); else
-      { exeterm(SAVED2->u.lis);		/* split */
+    if (result)
+      { exeterm(SAVED3->u.lis);
+	return; }
+    exeterm(SAVED2->u.lis);			/* split */
+    dump3 = LIST_NEWNODE(stk,dump3);		/* X2 X1 .. */
+    if ((job = par_fork()) == 0)		/* first */
+      { stk = DMP3->next;
+	pbinrecaux(depth - 1);
+	par_done(stk->next == DMP3->next->next ? stk : NULL); }
+    if (job > 0)				/* second */
+      { stk = newnode(DMP3->op,DMP3->u,DMP3->next->next);
+	pbinrecaux(depth - 1);
 	dump2 = newnode(stk->op,stk->u,dump2);
-	POP(stk);
+	ok = stk->next == DMP3->next->next;
+	stk = DMP3->next->next;
+	ok = par_join(job) && ok;
+	if (ok)
+	    GNULLARY(dump2->op,dump2->u);
+	POP(dump2); }
+    if (!ok)
+      { stk = DMP3->next;
 	binrecaux();			/* first */
-	GNULLARY(dump2->op,dump2->u);
-	POP(dump2);
-	binrecaux();			/* second */
-	exeterm(SAVED1->u.lis); }	/* combine */
+	GNULLARY(DMP3->op,DMP3->u);
+	binrecaux(); }			/* second */
+    POP(dump3);
+    exeterm(SAVED1->u.lis);		/* combine */
 }
 #endif
 
 #ifdef SINGLE
-PRIVATE void binrec_(void)
+PRIVATE void pbinrec_(void)
 {
     Node *first, *second, *third, *fourth;
 
-    FOURPARAMS("binrec");
-    FOURQUOTES("binrec");
+    FOURPARAMS("pbinrec");
+    FOURQUOTES("pbinrec");
+    if (!memo_is_pure(stk->u.lis, stk->next, 3)) {
+	binrec_();
+	return;
+    }
     fourth = stk->u.lis;
     stk = stk->next;
     third = stk->u.lis;
@@ -4100,16 +6529,19 @@ PRIVATE void binrec_(void)
     stk = stk->next;
     first = stk->u.lis;
     stk = stk->next;
-    binrecaux(first, second, third, fourth);
+    pbinrecaux(first, second, third, fourth, par_maxdepth());
 }
 #else
-PRIVATE void binrec_(void)
+PRIVATE void pbinrec_(void)
 {
-    FOURPARAMS("binrec");
-    FOURQUOTES("binrec");
+    FOURPARAMS("pbinrec");
+    FOURQUOTES("pbinrec");
+    if (!memo_is_pure(stk->u.lis, stk->next, 3))
+      { binrec_();
+	return; }
     SAVESTACK;
     stk = SAVED5;
-    binrecaux();
+    pbinrecaux(par_maxdepth());
     POP(dump);
 }
 #endif
@@ -4334,6 +6766,330 @@ PRIVATE void manual_list_aux_(void)
 }
 #endif
 
+/* - - - - -   M E M O I Z A T I O N   - - - - - */
+
+/*
+    A program can be memoized when its result depends only on its
+    arguments: it must not do input or output, nor look at the clock or
+    at settings, and it must not take the stack apart. Nor may it make a
+    symbol from a string with intern, as that can name any operator, and
+    enters new names in the symbol table. The operators that do any of
+    this are listed here by name, and a program is pure when neither
+    it nor the definitions it uses, however deep, contain one of them.
+    It is up to the user that it takes no more than the arguments given.
+*/
+static char *memo_impure[] = {
+    "__symtabindex", "__dump", "conts", "autoput", "undeferror", "undefs",
+    "echo", "clock", "time", "rand", "srand", "stdin", "stdout", "stderr",
+    "localtime", "mktime", "strftime", "fclose", "feof", "ferror",
+    "fflush", "fget", "fgetch", "fgets", "fopen", "fread", "fwrite",
+    "fremove", "frename", "fput", "fputch", "fputchars", "fputstring",
+    "fseek", "ftell", "stack", "unstack", "help", "_help", "helpdetail",
+    "manual", "__html_manual", "__latex_manual", "__manual_list",
+    "__settracegc", "setautoput", "setundeferror", "setecho", "gc",
+    "system", "getenv", "__memoryindex", "get", "getch", "put", "putch",
+    "putchars", "include", "abort", "quit", "memoize", "memostats",
+    "memoclear", "pardepth", "setpardepth", "spawn", "join", "chan", "send", "recv", "trysend", "tryrecv", "close",
+    "intern", "__native", 0 };
+
+PRIVATE int memo_purity(Node *n, Entry ***seen, long *count, long *max)
+{
+    Entry *ent;
+    long i;
+
+    for (; n; n = n->next)
+	switch (n->op) {
+	case LIST_:
+	    if (!memo_purity(n->u.lis, seen, count, max))
+		return 0;
+	    break;
+	case USR_:
+	    ent = n->u.ent;
+	    for (i = 0; i < *count; i++)
+		if ((*seen)[i] == ent)
+		    break;
+	    if (i < *count)
+		break;
+	    if (*count == *max) {
+		*max = *max ? 2 * *max : 16;
+		if ((*seen = realloc(*seen, *max * sizeof(Entry *))) == 0)
+		    execerror("memory", "memo");
+	    }
+	    (*seen)[(*count)++] = ent;
+	    if (!memo_purity(ent->u.body, seen, count, max))
+		return 0;
+	    break;
+	default:
+	    if (n->op < FALSE_)
+		break;
+	    for (i = 0; memo_impure[i]; i++)
+		if (!strcmp(symtab[(int)n->op].name, memo_impure[i]))
+		    return 0;
+	    break;
+	}
+    return 1;
+}
+
+/*
+    memo_is_pure tells whether the program prog, and the first nargs
+    values of args, that may be quotations that it runs, are pure.
+*/
+PRIVATE int memo_is_pure(Node *prog, Node *args, int nargs)
+{
+    Entry **seen = 0;
+    long count = 0, max = 0;
+    int pure;
+
+    pure = memo_purity(prog, &seen, &count, &max);
+    for (; pure && nargs > 0; nargs--, args = args->next)
+	if (args->op == LIST_ || args->op == USR_)
+	    pure = memo_purity(args->op == LIST_ ? args->u.lis : args,
+			       &seen, &count, &max);
+    free(seen);
+    return pure;
+}
+
+PRIVATE void memo_pure(Node *prog, Node *args, int nargs, char *name)
+{
+    if (!memo_is_pure(prog, args, nargs))
+	execerror("pure program", name);
+}
+
+/*
+    memo_exec runs the program on top of the stack, with nargs arguments
+    below it, or finds the result of an earlier run with equal arguments.
+    Program and arguments are replaced by the result. The program is
+    quoted when it comes from memo, and then it is kept with the result.
+*/
+#ifdef SINGLE
+PRIVATE void memo_exec(unsigned long id, int nargs, int quoted)
+{
+    Node *quote = quoted ? stk : NULL, *prog = stk->u.lis, *args = stk->next,
+	 *below, *hit;
+    unsigned long hash;
+    int i;
+
+    for (below = args, i = 0; i < nargs; i++, below = below->next)
+	if (!below)
+	    execerror("more parameters", "memo");
+    hash = memo_key(id, nargs, args);
+    if ((hit = memo_find(id, quote, hash, nargs, args)) != NULL) {
+	stk = newnode(hit->op, hit->u, below);
+	return;
+    }
+    stk = args;
+    exeterm(prog);
+    if (stk == NULL)
+	execerror("result", "memo");
+    memo_store(id, quote, hash, nargs, args, stk);
+    stk = newnode(stk->op, stk->u, below);
+}
+#else
+PRIVATE void memo_exec(unsigned long id, int nargs, int quoted)
+{
+    Node *below, *hit;
+    unsigned long hash;
+    int i;
+
+    for (below = stk->next, i = 0; i < nargs; i++, below = below->next)
+	if (below == NULL)
+	    execerror("more parameters", "memo");
+    hash = memo_key(id, nargs, stk->next);
+    if ((hit = memo_find(id, quoted ? stk : NULL, hash, nargs, stk->next))
+	!= NULL)
+      { stk = newnode(hit->op, hit->u, below);
+	return; }
+    SAVESTACK;
+    stk = SAVED2;
+    exeterm(SAVED1->u.lis);
+    if (stk == NULL)
+	execerror("result", "memo");
+    memo_store(id, quoted ? SAVED1 : NULL, hash, nargs, SAVED2, stk);
+    for (below = SAVED2, i = 0; i < nargs; i++)
+	below = below->next;
+    stk = newnode(stk->op, stk->u, below);
+    POP(dump);
+}
+#endif
+
+PRIVATE void memo_(void)
+{
+    unsigned long id;
+    Node *args;
+    int nargs, i;
+
+    TWOPARAMS("memo");
+    ONEQUOTE("memo");
+    if (stk->next->op != INTEGER_ || stk->next->u.num < 0 ||
+	stk->next->u.num > MEMOARGS)
+	execerror("small non-negative integer", "memo");
+    nargs = stk->next->u.num;
+    for (args = stk->next->next, i = 0; i < nargs; i++, args = args->next)
+	if (args == NULL)
+	    execerror("more parameters", "memo");
+    id = dict_hash(stk) | 1;			/* entries are even */
+    if (!memo_known(id, stk))
+      { memo_pure(stk->u.lis, stk->next->next, nargs, "memo");
+	memo_learn(id, stk); }
+    stk = newnode(LIST_, stk->u, stk->next->next);
+    memo_exec(id, nargs, 1);
+}
+
+PRIVATE void memoize_(void)
+{
+    Entry *ent;
+
+    TWOPARAMS("memoize");
+    INTEGER("memoize");
+    if (stk->u.num < 0 || stk->u.num > MEMOARGS)
+	execerror("small non-negative integer", "memoize");
+    if (stk->next->op != LIST_ || stk->next->u.lis == NULL ||
+	stk->next->u.lis->op != USR_)
+	execerror("quoted definition", "memoize");
+    ent = stk->next->u.lis->u.ent;
+    if (ent->u.body == NULL)
+	execerror("definition", ent->name);
+    memo_pure(stk->next->u.lis, NULL, 0, "memoize");
+    ent->memo = stk->u.num + 1;
+    POP(stk);
+    POP(stk);
+}
+
+PRIVATE void memostats_(void)
+{
+    Node *list = NULL;
+    long hits, misses, count, evictions;
+
+    memo_stats(&hits, &misses, &count, &evictions);
+    list = INTEGER_NEWNODE(evictions, list);
+    list = INTEGER_NEWNODE(count, list);
+    list = INTEGER_NEWNODE(misses, list);
+    list = INTEGER_NEWNODE(hits, list);
+    NULLARY(LIST_NEWNODE, list);
+}
+
+PRIVATE void memoclear_(void)
+{
+    memo_clear();
+}
+
+/* - - - - -   P A R A L L E L   - - - - - */
+
+/*
+    pmap and pfilter hand a list to par_run, that divides it over worker
+    processes, when the program is pure, so that it makes no difference
+    in which order or where the members are done. Otherwise, and when
+    par_run declines, they are map and filter.
+*/
+PRIVATE void pmap_(void)
+{
+    TWOPARAMS("pmap");
+    ONEQUOTE("pmap");
+    if (stk->next->op == LIST_ && memo_is_pure(stk->u.lis, NULL, 0) &&
+	par_run(0))
+	return;
+    map_();
+}
+
+PRIVATE void pfilter_(void)
+{
+    TWOPARAMS("pfilter");
+    ONEQUOTE("pfilter");
+    if (stk->next->op == LIST_ && memo_is_pure(stk->u.lis, NULL, 0) &&
+	par_run(1))
+	return;
+    filter_();
+}
+
+/* - - - - -   T A S K S   - - - - - */
+
+PRIVATE void spawn_(void)
+{
+    ONEPARAM("spawn");
+    ONEQUOTE("spawn");
+    task_spawn();
+}
+
+PRIVATE void join_(void)
+{
+    long id;
+
+    ONEPARAM("join");
+    INTEGER("join");
+    id = stk->u.num;
+    POP(stk);
+    task_join(id);
+}
+
+/* - - - - -   C H A N N E L S   - - - - - */
+
+PRIVATE void chan_(void)
+{
+    ONEPARAM("chan");
+    INTEGER("chan");
+    if (stk->u.num <= 0)
+	execerror("positive capacity", "chan");
+    UNARY(CHANNEL_NEWNODE, chan_new(stk->u.num));
+}
+
+PRIVATE void send_(void)
+{
+    TWOPARAMS("send");
+    CHANNEL(stk->next, "send");
+    chan_send(stk->next->u.chan, stk, 1, "send");
+    POP(stk);
+}
+
+PRIVATE void recv_(void)
+{
+    ONEPARAM("recv");
+    CHANNEL(stk, "recv");
+    chan_recv(stk->u.chan, 1, "recv");
+}
+
+PRIVATE void trysend_(void)
+{
+    TWOPARAMS("trysend");
+    CHANNEL(stk->next, "trysend");
+    UNARY(BOOLEAN_NEWNODE, (long)chan_send(stk->next->u.chan, stk, 0,
+					   "trysend"));
+}
+
+/*
+    tryrecv wraps what it receives in a list, so that an empty channel can
+    be told from any value.
+*/
+PRIVATE void tryrecv_(void)
+{
+    ONEPARAM("tryrecv");
+    CHANNEL(stk, "tryrecv");
+    if (chan_recv(stk->u.chan, 0, "tryrecv"))
+	make_list(1);
+    else
+	NULLARY(LIST_NEWNODE, 0);
+}
+
+PRIVATE void close_(void)
+{
+    ONEPARAM("close");
+    CHANNEL(stk, "close");
+    chan_close(stk->u.chan);
+    POP(stk);
+}
+
+/* - - - - -   N A T I V E   - - - - - */
+
+PRIVATE void native_(void)
+{
+    long n;
+
+    ONEPARAM("__native");
+    INTEGER("__native");
+    n = stk->u.num;
+    POP(stk);
+    native_exec(n);
+}
+
 /* - - - - -   I N I T I A L I S A T I O N   - - - - - */
 
 static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
@@ -4362,10 +7118,10 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "The type of characters. Literals are written with a single quote.\nExamples:  'A  '7  ';  and so on. Unix style escapes are allowed."},
 
 {" integer type",	dummy_,		"->  I",
-"The type of negative, zero or positive integers.\nLiterals are written in decimal notation. Examples:  -123   0   42."},
+"The type of negative, zero or positive integers.\nLiterals are written in decimal notation. Examples:  -123   0   42.\nIntegers have no fixed size: results beyond maxint are exact."},
 
 {" set type",		dummy_,		"->  {...}",
-"The type of sets of small non-negative integers.\nThe maximum is platform dependent, typically the range is 0..31.\nLiterals are written inside curly braces.\nExamples:  {}  {0}  {1 3 5}  {19 18 17}."},
+"The type of sets of non-negative integers.\nMembers below setsize are held in a single word, larger members\nup to 1048575 are held in a big set.\nLiterals are written inside curly braces.\nExamples:  {}  {0}  {1 3 5}  {19 18 17}  {100 1000}."},
 
 {" string type",	dummy_,		"->  \"...\" ",
 "The type of strings of characters. Literals are written inside double quotes.\nExamples: \"\"  \"A\"  \"hello world\" \"123\".\nUnix style escapes are accepted."},
@@ -4379,6 +7135,48 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {" file type",		dummy_,		"->  FILE:",
 "The type of references to open I/O streams,\ntypically but not necessarily files.\nThe only literals of this type are stdin, stdout, and stderr."},
 
+{" bigset type",	dummy_,		"->  {...}",
+"The type of sets with members of setsize or more.\nBig sets are sets: they are written, compared and operated upon\nlike small sets, and the type is not visible to programs."},
+
+{" dict type",		dummy_,		"->  dict:[..]",
+"The type of dictionaries, mapping keys to values in constant time.\nKeys are equal when = says so. Dictionaries are made by dmake\nand are never changed: dput and ddel deliver a new one.\nThey are aggregates for size, null, in, has, step and map;\nstep and map see the pairs [K V]. There are no literals."},
+
+{" bignum type",	dummy_,		"->  I",
+"The type of integers beyond maxint, made by literals and arithmetic.\nBignums are integers: they are written, compared and operated upon\nlike other integers, and the type is not visible to programs."},
+
+{" rational type",	dummy_,		"->  R",
+"The type of exact fractions, kept in lowest terms.\nLiterals are written as two integers with a slash (like 3/4 or -1/3).\n+ - * / mix them with integers, giving an integer when the result is whole;\nmixed with floats they give a float. floor ceil trunc give integers."},
+
+{" floatarray type",	dummy_,		"->  farray:[..]",
+"The type of packed arrays of floats, made by farray.\n+ - * / work elementwise on two arrays of equal size,\nor on an array and a number. size null at of = accept them.\nThere are no literals."},
+
+{" intarray type",	dummy_,		"->  iarray:[..]",
+"The type of packed arrays of integers, made by iarray.\nArithmetic stays integer, unless a float takes part\nor an element overflows: then the result is a float array."},
+
+{" vector type",	dummy_,		"->  vector:[..]",
+"The type of vectors, made by vmake. Elements are found by at and of\nand replaced by assign and update, in logarithmic time; vpush appends.\nVectors are never changed: a new one is delivered. They are aggregates\nfor size, null and step. There are no literals."},
+
+{" deque type",	dummy_,		"->  deque:[..]",
+"The type of double ended queues, made by qmake. Elements are added by\nqpushf and qpushb and removed by qpopf and qpopb, at the front or the\nback, in amortized constant time. Deques are never changed: a new one\nis delivered. They are aggregates for size, null and step."},
+
+{" heap type",		dummy_,		"->  heap:N",
+"The type of priority queues, made by hmake, with N elements. htop is\nthe first element in the order of the heap; hpush and hpop take\nlogarithmic time. Heaps are never changed: a new one is delivered."},
+
+{" oset type",		dummy_,		"->  oset:[..]",
+"The type of ordered sets, made by smake, in the order of < and =.\nsinsert, sdelete and in or has take logarithmic time; sunion,\nsintersect and sdifference linear time. step and map go in order."},
+
+{" omap type",		dummy_,		"->  omap:[..[K V]..]",
+"The type of ordered maps, made by omake, with keys in the order of\n< and =. oput, oget, odel and in or has take logarithmic time; step\nand map go over the pairs [K V] in order of the keys."},
+
+{" stream type",		dummy_,		"->  stream:[X ..]",
+"The type of lazy lists, made by lazy, iterate, unfold and lcons. Only\nthe first element is known; rest computes the next one when asked,\nand map, filter and lzip deliver streams that do so too."},
+
+{" range type",		dummy_,		"->  range:[..]",
+"The type of ranges of integers or characters, made by rmake. The\nelements are not stored: size, at, in and rest take constant time, and\nstep, map and filter go over them in order. map and filter give lists."},
+
+{" channel type",		dummy_,		"->  chan:N",
+"The type of channels, made by chan, that carry values between tasks in\nthe order in which they were sent. N is the number of values a channel\nholds before send has to wait."},
+
 /* OPERANDS */
 
 {"false",		dummy_,		"->  false",
@@ -4388,10 +7186,10 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "Pushes the value true."},
 
 {"maxint",		dummy_,		"->  maxint",
-"Pushes largest integer (platform dependent). Typically it is 32 bits."},
+"Pushes largest integer that fits in a machine word. Typically it is 64 bits.\nLarger integers are bignums."},
 
 {"setsize",		setsize_,	"->  setsize",
-"Pushes the maximum number of elements in a set (platform dependent).\nTypically it is 32, and set members are in the range 0..31."},
+"Pushes the number of members that fit in a small set (platform dependent).\nTypically it is 64; larger members make a big set."},
 
 {"stack",		stack_,		".. X Y Z  ->  .. X Y Z [Z Y X ..]",
 "Pushes the stack as a list."},
@@ -4414,6 +7212,9 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"undeferror",		undeferror_,	"->  I",
 "Pushes current value of undefined-is-error flag."},
 
+{"pardepth",		pardepth_,	"->  I",
+"Pushes the depth of recursion up to which pbinrec uses workers."},
+
 {"undefs",		undefs_,	"->  [..]",
 "Push a list of all undefined symbols in the current symbol table."},
 
@@ -4495,19 +7296,19 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "Z is the intersection of sets X and Y, logical conjunction for truth values."},
 
 {"not",			not_,		"X  ->  Y",
-"Y is the complement of set X, logical negation for truth values."},
+"Y is the complement below setsize of set X, that has no larger members,\nlogical negation for truth values."},
 
 {"+",			plus_,		"M I  ->  N",
-"Numeric N is the result of adding integer I to numeric M.\nAlso supports float."},
+"Numeric N is the result of adding integer I to numeric M.\nAlso supports float. With an array, adds elementwise."},
 
 {"-",			minus_,		"M I  ->  N",
-"Numeric N is the result of subtracting integer I from numeric M.\nAlso supports float."},
+"Numeric N is the result of subtracting integer I from numeric M.\nAlso supports float. With an array, subtracts elementwise."},
 
 {"*",			mul_,		"I J  ->  K",
-"Integer K is the product of integers I and J.  Also supports float."},
+"Integer K is the product of integers I and J.  Also supports float.\nWith an array, multiplies elementwise; a number scales the array."},
 
 {"/",			divide_,	"I J  ->  K",
-"Integer K is the (rounded) ratio of integers I and J.  Also supports float."},
+"Integer K is the (rounded) ratio of integers I and J.  Also supports float.\nWith a rational operand the ratio is exact. With an array, divides elementwise."},
 
 {"rem",			rem_,		"I J  ->  K",
 "Integer K is the remainder of dividing I by J.  Also supports float."},
@@ -4543,7 +7344,7 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "H is the arc tangent of F / G."},
 
 {"ceil",		ceil_,		"F  ->  G",
-"G is the float ceiling of F."},
+"G is the float ceiling of F. The ceiling of a rational is an integer."},
 
 {"cos",			cos_,		"F  ->  G",
 "G is the cosine of F."},
@@ -4555,7 +7356,7 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "G is e (2.718281828...) raised to the Fth power."},
 
 {"floor",		floor_,		"F  ->  G",
-"G is the floor of F."},
+"G is the floor of F. The floor of a rational is an integer."},
 
 {"frexp",		frexp_,		"F  ->  G I",
 "G is the mantissa and I is the exponent of F.\nUnless F = 0, 0.5 <= abs(G) < 1.0."},
@@ -4573,7 +7374,7 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "G is the fractional part and H is the integer part\n(but expressed as a float) of F."},
 
 {"pow",			pow_,		"F G  ->  H",
-"H is F raised to the Gth power."},
+"H is F raised to the Gth power.\nExact for integer F and non-negative integer G."},
 
 {"sin",			sin_,		"F  ->  G",
 "G is the sine of F."},
@@ -4591,7 +7392,16 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "G is the hyperbolic tangent of F."},
 
 {"trunc",		trunc_,		"F  ->  I",
-"I is an integer equal to the float F truncated toward zero."},
+"I is an integer equal to the float or rational F truncated toward zero."},
+
+{"ratio",		ratio_,		"I J  ->  R",
+"R is the exact ratio of integers or rationals I and J,\na rational or an integer when J divides I."},
+
+{"numerator",		numerator_,	"R  ->  I",
+"I is the numerator of rational R in lowest terms, or R itself if an integer."},
+
+{"denominator",		denominator_,	"R  ->  I",
+"I is the positive denominator of rational R in lowest terms, or 1."},
 
 {"localtime",		localtime_,	"I  ->  T",
 "Converts a time I into a list T representing local time:\n[year month day hour minute second isdst yearday weekday].\nMonth is 1 = January ... 12 = December;\nisdst is a Boolean flagging daylight savings/summer time;\nweekday is 1 = Monday ... 7 = Sunday."},
@@ -4612,7 +7422,7 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 "String S is converted to the float R."},
 
 {"format",		format_,	"N C I J  ->  S",
-"S is the formatted version of N in mode C\n('d or 'i = decimal, 'o = octal, 'x or\n'X = hex with lower or upper case letters)\nwith maximum width I and minimum width J."},
+"S is the formatted version of N in mode C\n('d or 'i = decimal, 'o = octal, 'x or\n'X = hex with lower or upper case letters)\nwith maximum width I and minimum width J.\nBignums and rationals are written in decimal, with width I."},
 
 {"formatf",		formatf_,	"F C I J  ->  S",
 "S is the formatted version of F in mode C\n('e or 'E = exponential, 'f = fractional,\n'g or G = general with lower or upper case letters)\nwith maximum width I and precision J."},
@@ -4739,6 +7549,159 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"enconcat",		enconcat_,	"X S T  ->  U",
 "Sequence U is the concatenation of sequences S and T\nwith X inserted between S and T (== swapd cons concat)"},
 
+{"dmake",		dmake_,		"[..[K V]..]  ->  D",
+"D is the dictionary of the pairs [K V]; later pairs replace earlier ones\nwith an equal key."},
+
+{"dput",		dput_,		"D K V  ->  E",
+"E is dictionary D with key K mapped to V. D itself is unchanged."},
+
+{"dget",		dget_,		"D K  ->  V",
+"V is the value of key K in dictionary D."},
+
+{"ddel",		ddel_,		"D K  ->  E",
+"E is dictionary D without key K. D itself is unchanged."},
+
+{"dpairs",		dpairs_,	"D  ->  [..[K V]..]",
+"The list of pairs [K V] in dictionary D, in no particular order."},
+
+{"vmake",		vmake_,		"[..X..]  ->  V",
+"V is the vector of the elements of the list."},
+
+{"vlist",		vlist_,		"V  ->  [..X..]",
+"The list of the elements of vector V."},
+
+{"vpush",		vpush_,		"V X  ->  W",
+"W is vector V with X appended. V itself is unchanged."},
+
+{"assign",		assign_,	"V I X  ->  W",
+"W is vector V with element I replaced by X, or appended when I is\nthe size of V. V itself is unchanged."},
+
+{"qmake",		qmake_,		"[..X..]  ->  Q",
+"Q is the deque of the elements of the list, the first one at the front."},
+
+{"qlist",		qlist_,		"Q  ->  [..X..]",
+"The list of the elements of deque Q, from the front to the back."},
+
+{"qpushf",		qpushf_,	"Q X  ->  R",
+"R is deque Q with X added at the front."},
+
+{"qpushb",		qpushb_,	"Q X  ->  R",
+"R is deque Q with X added at the back."},
+
+{"qpopf",		qpopf_,		"Q  ->  R",
+"R is non-empty deque Q without its front element."},
+
+{"qpopb",		qpopb_,		"Q  ->  R",
+"R is non-empty deque Q without its back element."},
+
+{"qfront",		qfront_,	"Q  ->  X",
+"X is the front element of non-empty deque Q."},
+
+{"qback",		qback_,		"Q  ->  X",
+"X is the back element of non-empty deque Q."},
+
+{"hpush",		hpush_,		"H X  ->  G",
+"G is heap H with X added, in the order of H."},
+
+{"htop",		htop_,		"H  ->  X",
+"X is the first element of non-empty heap H."},
+
+{"hpop",		hpop_,		"H  ->  G",
+"G is non-empty heap H without its first element."},
+
+{"smake",		smake_,		"[..X..]  ->  S",
+"S is the ordered set of the members of the list."},
+
+{"slist",		slist_,		"S  ->  [..X..]",
+"The list of the members of ordered set S, in ascending order."},
+
+{"sinsert",		sinsert_,	"S X  ->  T",
+"T is ordered set S with X added. S itself is unchanged."},
+
+{"sdelete",		sdelete_,	"S X  ->  T",
+"T is ordered set S without X. S itself is unchanged."},
+
+{"sunion",		sunion_,	"S T  ->  U",
+"U is the union of ordered sets or maps S and T; keys in both keep the\nvalue in S."},
+
+{"sintersect",		sintersect_,	"S T  ->  U",
+"U is the intersection of ordered sets or maps S and T; it has the\nvalues in S."},
+
+{"sdifference",		sdifference_,	"S T  ->  U",
+"U is ordered set or map S without the keys in T."},
+
+{"omake",		omake_,		"[..[K V]..]  ->  M",
+"M is the ordered map of the pairs [K V] in the list."},
+
+{"oput",		oput_,		"M K V  ->  N",
+"N is ordered map M with value V for key K. M itself is unchanged."},
+
+{"oget",		oget_,		"M K  ->  V",
+"V is the value of key K in ordered map M."},
+
+{"odel",		odel_,		"M K  ->  N",
+"N is ordered map M without key K. M itself is unchanged."},
+
+{"opairs",		opairs_,	"M  ->  [..[K V]..]",
+"The list of pairs [K V] in ordered map M, in ascending order of K."},
+
+{"lazy",		lazy_,		"[..X..]  ->  S",
+"S is the stream of the members of the list."},
+
+{"lcons",		lcons_,		"X [P]  ->  S",
+"S is the stream with first element X, of which the rest is the stream\nor list that P delivers, when it is needed."},
+
+{"lzip",		lzip_,		"S1 S2  ->  S",
+"S is the stream of the pairs [X1 X2] of the elements of the streams\nor lists S1 and S2, as long as both have elements."},
+
+{"rmake",		rmake_,		"X1 X2 I  ->  R",
+"R is the range of the integers or characters from X1 up to X2 in steps\nof I, or down when I is negative. The elements are not made."},
+
+{"hash",		hash_,		"X  ->  I",
+"I is a non-negative hash of X; values that are equal have equal hashes."},
+
+{"share",		share_,		"[L]  ->  [L]",
+"The same list, with its parts equal to each other or to parts of lists\nshared before made the same; shared lists compare equal at once."},
+
+{"farray",		farray_,	"A  ->  F",
+"F is the packed float array of the numbers in list or array A."},
+
+{"iarray",		iarray_,	"A  ->  I",
+"I is the packed integer array of the integers in list A,\nor of the numbers in array A truncated toward zero."},
+
+{"unpack",		unpack_,	"A  ->  L",
+"L is the list of the numbers in packed array A."},
+
+{"dot",			dot_,		"A B  ->  N",
+"N is the dot product of the arrays A and B, of equal size."},
+
+{"asum",		asum_,		"A  ->  N",
+"N is the sum of the numbers in array A."},
+
+{"amin",		amin_,		"A  ->  N",
+"N is the least number in the non-empty array A."},
+
+{"amax",		amax_,		"A  ->  N",
+"N is the greatest number in the non-empty array A."},
+
+{"mmul",		mmul_,		"M N  ->  P",
+"P is the matrix product of M and N, lists of rows or packed matrices;\nthe rows of M must be as long as N has rows."},
+
+{"mtranspose",		mtranspose_,	"M  ->  T",
+"T is the transpose of matrix M, a list of rows of equal length or packed."},
+
+{"madd",		madd_,		"M N  ->  P",
+"P is the sum of the matrices M and N, of equal size."},
+
+{"mscale",		mscale_,	"M N  ->  P",
+"P is matrix M with each element multiplied by number N."},
+
+{"mpack",		mpack_,		"M  ->  F",
+"F is the packed matrix of the numbers in the list of rows M."},
+
+{"munpack",		munpack_,	"F  ->  M",
+"M is the list of rows of floats in packed matrix F."},
+
 {"name",		name_,		"sym  ->  \"sym\"",
 "For operators and combinators, the string \"sym\" is the name of item sym,\nfor literals sym the result string is its type."},
 
@@ -4818,6 +7781,42 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"file",		file_,		"F  ->  B",
 "Tests whether F is a file."},
 
+{"dict",		dict_,		"X  ->  B",
+"Tests whether X is a dictionary."},
+
+{"rational",		rational_,	"X  ->  B",
+"Tests whether X is a rational."},
+
+{"floatarray",		floatarray_,	"X  ->  B",
+"Tests whether X is a packed float array."},
+
+{"intarray",		intarray_,	"X  ->  B",
+"Tests whether X is a packed integer array."},
+
+{"vector",		vector_,	"X  ->  B",
+"Tests whether X is a vector."},
+
+{"deque",		deque_,		"X  ->  B",
+"Tests whether X is a deque."},
+
+{"heap",		heap_,		"X  ->  B",
+"Tests whether X is a heap."},
+
+{"oset",		oset_,		"X  ->  B",
+"Tests whether X is an ordered set."},
+
+{"omap",		omap_,		"X  ->  B",
+"Tests whether X is an ordered map."},
+
+{"stream",		stream_,	"X  ->  B",
+"Tests whether X is a stream."},
+
+{"range",		range_,		"X  ->  B",
+"Tests whether X is a range."},
+
+{"channel",		channel_,	"X  ->  B",
+"Tests whether X is a channel."},
+
 /* COMBINATORS */
 
 {"i",			i_,		"[P]  ->  ...",
@@ -4832,6 +7831,18 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"app1",		app1_,		"X [P]  ->  R",
 "Executes P, pushes result R on stack."},
 
+{"update",		update_,	"V I [P]  ->  W",
+"Executes P on element I of vector V; W is V with the result in its place."},
+
+{"hmake",		hmake_,		"[..X..] [C]  ->  H",
+"H is the heap of the elements of the list, where X Y C tests whether X\ncomes before Y; with [] for C, smaller values come first."},
+
+{"iterate",		iterate_,	"X [B]  ->  S",
+"S is the endless stream X, B(X), B(B(X)) .."},
+
+{"unfold",		unfold_,	"X [P] [B]  ->  S",
+"S is the stream X, B(X), B(B(X)) .. for as long as P holds."},
+
 {"app11",		app11_,		"X Y [P]  ->  R",
 "Executes P, pushes result R on stack."},
 
@@ -4919,6 +7930,9 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"binrec",		binrec_,	"[P] [T] [R1] [R2]  ->  ...",
 "Executes P. If that yields true, executes T.\nElse uses R1 to produce two intermediates, recurses on both,\nthen executes R2 to combines their results."},
 
+{"pbinrec",		pbinrec_,	"[P] [T] [R1] [R2]  ->  ...",
+"As binrec, but when all four are pure the first recursion is done by a\nworker process and the second by this one, as deep as pardepth says."},
+
 {"genrec",		genrec_,	"[B] [T] [R1] [R2]  ->  ...",
 "Executes B, if that yields true executes T.\nElse executes R1 and then [[[B] [T] [R1] R2] genrec] R2."},
 
@@ -4949,9 +7963,51 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"filter",		filter_,	"A [B]  ->  A1",
 "Uses test B to filter aggregate A producing sametype aggregate A1."},
 
+{"pmap",		pmap_,		"A [P]  ->  B",
+"As map, but for a list A and a pure program P the members are divided\nover worker processes, one for each processor."},
+
+{"pfilter",		pfilter_,	"A [B]  ->  A1",
+"As filter, but for a list A and a pure test B the members are divided\nover worker processes, one for each processor."},
+
+{"spawn",		spawn_,		"[P]  ->  T",
+"Hands P with a copy of the stack to a task, that a thread runs meanwhile,\nand pushes its handle T. Only plain values can be handed over."},
+
+{"join",		join_,		"T  ->  X",
+"Waits for task T and pushes the top of its stack, or repeats its error.\nEach task is joined once."},
+
+{"chan",		chan_,		"I  ->  C",
+"Pushes a new channel C that holds up to I values."},
+
+{"send",		send_,		"C X  ->  C",
+"Sends a copy of X over channel C, and waits while C is full.\nOnly plain values can be sent."},
+
+{"recv",		recv_,		"C  ->  C X",
+"Receives the first value X from channel C, and waits while C is empty.\nFails when C is closed and empty."},
+
+{"trysend",		trysend_,	"C X  ->  C B",
+"As send, but does not wait: B tells whether X has been sent."},
+
+{"tryrecv",		tryrecv_,	"C  ->  C L",
+"As recv, but does not wait: L is [X], or [] when C is empty."},
+
+{"close",		close_,		"C  ->",
+"Closes channel C: nothing can be sent any more, and recv fails once\nthe values sent before have been received."},
+
+{"pipe",		pipe_,		"A [Q]  ->  ...",
+"Q is a chain of [P] map and [B] filter, possibly ended by [P] step or\nby V0 [P] fold. For a list or range A, runs the chain on each member in\none pass, without the aggregates in between. Otherwise executes Q."},
+
 {"split",		split_,		"A [B]  ->  A1 A2",
 "Uses test B to split aggregate A into sametype aggregates A1 and A2 ."},
 
+{"sort",		sort_,		"A  ->  B",
+"Sorts list, string or vector A in ascending order, as compared by <,\ninto B. The sort is stable: equal members keep their order."},
+
+{"sortby",		sortby_,	"A [C]  ->  B",
+"Sorts list, string or vector A into B, where X Y C tells whether X\ncomes strictly before Y. The sort is stable."},
+
+{"sortkey",		sortkey_,	"A [K]  ->  B",
+"Sorts list, string or vector A into B on the keys computed by K, once\nfor each member, as compared by <. The sort is stable."},
+
 {"some",		some_,		"A  [B]  ->  X",
 "Applies test B to members of aggregate A, X = true if some pass."},
 
@@ -4967,6 +8023,9 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"treegenrec",		treegenrec_,	"T [O1] [O2] [C]  ->  ...",
 "T is a tree. If T is a leaf, executes O1.\nElse executes O2 and then [[[O1] [O2] C] treegenrec] C."},
 
+{"memo",		memo_,		"X1 .. XN N [P]  ->  R",
+"Executes P, that must be pure, on the N values X1 .. XN, leaving R.\nThe result is cached, so that P is run once for equal values."},
+
 /* MISCELLANEOUS */
 
 {"help",		help1_,		"->",
@@ -4999,12 +8058,24 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"setundeferror",	setundeferror_,	"I  ->",
 "Sets flag that controls behavior of undefined functions\n(0 = no error, 1 = error)."},
 
+{"setpardepth",		setpardepth_,	"I  ->",
+"Sets the depth of recursion up to which pbinrec uses workers\n(0 = none, negative = as many as there are processors)."},
+
 {"setecho",		setecho_,	"I ->",
 "Sets value of echo flag for listing.\nI = 0: no echo, 1: echo, 2: with tab, 3: and linenumber."},
 
 {"gc",			gc_,		"->",
 "Initiates garbage collection."},
 
+{"memoize",		memoize_,	"[S] N  ->",
+"The definition S, that must be pure, caches its results\nfor the N values it takes from the stack."},
+
+{"memostats",		memostats_,	"->  [H M C E]",
+"Pushes the hits, misses, cached results and evictions of the memo cache."},
+
+{"memoclear",		memoclear_,	"->",
+"Empties the memo cache."},
+
 {"system",		system_,	"\"command\"  ->",
 "Escapes to shell, executes string \"command\".\nThe string may cause execution of another program.\nWhen that has finished, the process returns to Joy."},
 
@@ -5020,6 +8091,9 @@ static struct {char *name; void (*proc)(void); char *messg1, *messg2 ; }
 {"__memoryindex",	memoryindex_,	"->",
 "Pushes current value of memory."},
 
+{"__native",		native_,	"I  ->  ...",
+"Runs native primitive I of the program that uses libjoy, see joy_register."},
+
 {"get",			get_,		"->  F",
 "Reads a factor from input and pushes it onto stack."},
 
@@ -5060,7 +8134,7 @@ PUBLIC void inisymboltable(void)		/* initialise		*/
     for (i = 0; optable[i].name; i++)
       { char *s = optable[i].name;
 	HashValue(s);
-	symtabindex->name = optable[i].name;
+	symtabindex->name = intern_static(optable[i].name, &symtabindex->hash);
 	symtabindex->u.proc = optable[i].proc;
 	symtabindex->next = hashentry[hashvalue];
 	hashentry[hashvalue] = symtabindex;
@@ -0,0 +1,169 @@
+/* FILE: joy.c */
+/*
+ *  module  : joy.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+The joy program: it reads definitions and terms from the file that is
+given, or from stdin, and runs them, after usrlib.joy. The interpreter
+itself is in libjoy, that other programs can use as well, see joy.h.
+
+Before the file, --save-image image writes the definitions to image
+when the input ends, and --image image reads them from image instead of
+reading usrlib.joy, see image.c. With --cache directory an included
+file is read from its cache in directory, see cache.c.
+
+Instead of a file, --serve socket reads the libraries once and then runs
+the programs sent to socket, see serve.c, each for at most --timeout
+seconds, 10 by default, and in at most --memory megabytes, 512 by
+default; 0 means no limit.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "globals.h"
+#ifdef GC_BDW
+#include <gc.h>
+#endif
+
+#define SERVETIME	10			/* seconds	*/
+#define SERVEMEMORY	512			/* megabytes	*/
+
+static int mustinclude = 1;
+static char *image_name;			/* --save-image	*/
+static char *serve_name;			/* --serve	*/
+static int serve_seconds = SERVETIME;
+static long serve_megabytes = SERVEMEMORY;
+
+static void save_image(void)
+{
+    if (!img_save(image_name))
+	printf("failed to save the image '%s'.\n", image_name);
+}
+
+/*
+    preload reads the library name before the server starts, as libjoy
+    reads a file.
+*/
+static void preload(char *name)
+{
+    FILE *fp;
+
+    if ((fp = fopen(name, "r")) == 0)
+	return;
+    fclose(fp);
+    joy_context->embedded = 1;
+    if (joy_eval_file(joy_context, name) != JOY_OK)
+	printf("%s: %s\n", name, joy_error(joy_context));
+    joy_context->embedded = 0;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *fp;
+    char *image = 0;
+    int n;
+
+#ifdef GC_BDW
+    GC_init();
+#endif
+    if ((joy_context = joy_context_new()) == 0) {
+	printf("failed to create a context.\n");
+	exit(0);
+    }
+    while (argc > 1) {
+	n = 2;
+	if (argc > 2 && !strcmp(argv[1], "--cache"))
+	    cachedir = argv[2];
+	else if (argc > 2 && !strcmp(argv[1], "--image"))
+	    image = argv[2];
+	else if (argc > 2 && !strcmp(argv[1], "--save-image"))
+	    image_name = argv[2];
+	else if (argc > 2 && !strcmp(argv[1], "--serve"))
+	    serve_name = argv[2];
+	else if (argc > 2 && !strcmp(argv[1], "--timeout"))
+	    serve_seconds = atoi(argv[2]);
+	else if (argc > 2 && !strcmp(argv[1], "--memory"))
+	    serve_megabytes = atol(argv[2]);
+	else
+	    break;
+	argv[n] = argv[0];
+	argc -= n;
+	argv += n;
+    }
+    g_argc = argc;
+    g_argv = argv;
+    if (argc > 1) {
+	g_argc--;
+	g_argv++;
+	srcfile = fopen(argv[1], "r");
+	if (!srcfile) {
+	    printf("failed to open the file '%s'.\n", argv[1]);
+	    exit(0);
+	}
+	inilinebuffer(argv[1]);
+	if (!strcmp(argv[1], "joytut.inp") ||
+	    !strcmp(argv[1], "jp-joytst.joy")) {
+	    printf("JOY  -  compiled at 11:59:37 on Jul  2 2001 (NOBDW)\n");
+	    printf("Copyright 2001 by Manfred von Thun\n");
+	}
+	if (!strcmp(argv[1], "laztst.joy")) {
+	    printf("JOY  -  compiled at 15:32:32 on Nov 12 2001 (BDW)\n");
+	    printf("Copyright 2001 by Manfred von Thun\n");
+	}
+	if (!strcmp(argv[1], "lsptst.joy") || !strcmp(argv[1], "plgtst.joy") ||
+	    !strcmp(argv[1], "symtst.joy")) {
+	    printf("JOY  -  compiled at 14:54:45 on Feb  1 2002 (BDW)\n");
+	    printf("Copyright 2001 by Manfred von Thun\n");
+	}
+	if (!strcmp(argv[1], "grmtst.joy") || !strcmp(argv[1], "mtrtst.joy")) {
+	    printf("JOY  -  compiled at 15:19:20 on Apr  3 2002 (BDW)\n");
+	    printf("Copyright 2001 by Manfred von Thun\n");
+	}
+	if (!strcmp(argv[1], "modtst.joy")) {
+	    printf("JOY  -  compiled at 16:57:51 on Mar 17 2003 (BDW)\n");
+	    printf("Copyright 2001 by Manfred von Thun\n");
+	}
+    } else {
+	srcfile = stdin;
+	inilinebuffer(0);
+#ifdef GC_BDW
+	printf("JOY  -  compiled at %s on %s (BDW)\n", __TIME__, __DATE__);
+#else
+	printf("JOY  -  compiled at %s on %s (NOBDW)\n", __TIME__, __DATE__);
+#endif
+	printf("Copyright 2001 by Manfred von Thun\n");
+    }
+    inisymboltable();
+    if (image) {
+	if (!img_load(image)) {
+	    printf("failed to load the image '%s'.\n", image);
+	    exit(0);
+	}
+	mustinclude = 0;
+    }
+    if (serve_name) {
+	if (mustinclude)
+	    preload("usrlib.joy");
+	mustinclude = 0;
+	serve(serve_name, serve_seconds, serve_megabytes);
+    } else if (image_name)
+	atexit(save_image);
+    setjmp(joy_context->begin);
+D(  printf("starting main loop\n"); )
+    setbuf(stdout, 0);
+    while (1) {
+	if (mustinclude) {
+	    mustinclude = 0;
+	    if ((fp = fopen("usrlib.joy", "r")) != 0) {
+		fclose(fp);
+		doinclude("usrlib.joy");
+	    }
+	}
+	readeval();
+    }
+}
+/* END of JOY.C */
@@ -0,0 +1,91 @@
+/* FILE: joy.h */
+/*
+ *  module  : joy.h
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+#ifndef JOY_H
+#define JOY_H
+
+/*
+    The interface of libjoy, for programs that run Joy in their own
+    process. A context is an interpreter with its own stack; the functions
+    below make it the context of the calling thread, see globals.h. The
+    first context must be opened before other threads open theirs.
+
+    joy_eval and joy_eval_file read definitions and run terms, as the
+    joy program does with its input; libraries are loaded in the same
+    way. In the text of joy_eval the last term need not end with a
+    period. The values of the terms stay on the stack, unless autoput has
+    been set, and a definition empties the stack. These functions give
+    JOY_OK, or a status below and a message from joy_error.
+
+    joy_register defines name as a native primitive: fn is called with
+    the stack of the context that runs it, and gives JOY_OK or an error,
+    that then is a run time error. A native primitive must not call
+    joy_eval. Registering is a definition and empties the stack.
+
+    The joy_push functions push a value; joy_push_list replaces the top
+    count values by the list of them, the deepest first. The joy_pop
+    functions pop a value of their type, or leave the stack alone and
+    give JOY_TYPE; joy_pop_list replaces a list by its members, the last
+    on top, and gives their number. A string that is popped belongs to
+    the interpreter: it must be copied if it is to be kept.
+*/
+
+#ifdef BIT_32
+typedef long joy_int;
+#else
+typedef long long joy_int;
+#endif
+
+typedef struct JoyContext JoyContext;
+
+typedef int (*JoyNative)(JoyContext *c);
+
+enum {						/* status	*/
+    JOY_OK,
+    JOY_ERROR,					/* run time error */
+    JOY_SYNTAX,
+    JOY_ABORT,
+    JOY_QUIT,
+    JOY_TYPE,					/* joy_pop	*/
+    JOY_FILE,
+    JOY_FULL					/* joy_register	*/
+};
+
+enum {						/* joy_type	*/
+    JOY_NONE,					/* empty stack	*/
+    JOY_BOOLEAN,
+    JOY_CHAR,
+    JOY_INTEGER,
+    JOY_SET,
+    JOY_STRING,
+    JOY_LIST,
+    JOY_FLOAT,
+    JOY_OTHER
+};
+
+JoyContext *joy_open(void);
+void joy_close(JoyContext *c);
+int joy_eval(JoyContext *c, const char *text);
+int joy_eval_file(JoyContext *c, const char *name);
+const char *joy_error(JoyContext *c);
+int joy_register(JoyContext *c, const char *name, JoyNative fn);
+
+long joy_depth(JoyContext *c);
+int joy_type(JoyContext *c);
+int joy_push_boolean(JoyContext *c, int b);
+int joy_push_char(JoyContext *c, int ch);
+int joy_push_integer(JoyContext *c, joy_int n);
+int joy_push_float(JoyContext *c, double d);
+int joy_push_string(JoyContext *c, const char *s);
+int joy_push_list(JoyContext *c, long count);
+int joy_pop_boolean(JoyContext *c, int *b);
+int joy_pop_char(JoyContext *c, int *ch);
+int joy_pop_integer(JoyContext *c, joy_int *n);
+int joy_pop_float(JoyContext *c, double *d);
+int joy_pop_string(JoyContext *c, const char **s);
+int joy_pop_list(JoyContext *c, long *count);
+#endif
+/* END of JOY.H */
@@ -0,0 +1,341 @@
+/* FILE: libjoy.c */
+/*
+ *  module  : libjoy.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+libjoy runs Joy in the process of another program, see joy.h. The
+contexts it opens are embedded: a run time error, a syntax error, quit
+and the end of the text end joy_eval with a status, and the message is
+kept in the context instead of being printed.
+
+The native primitives of the program are in natives, that the contexts
+share; a name is defined as the number of its primitive followed by
+__native, so that it can be used like any other definition.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc_atomic
+#endif
+
+#define NATIVEMAX	64		/* native primitives	*/
+
+static struct {
+    char *name;
+    JoyNative fn;
+} natives[NATIVEMAX];
+static int native_count;
+static int open_count;				/* contexts	*/
+
+/*
+    ENTER makes c the context of the thread. Outside of joy_eval a run
+    time error, such as a lack of memory, must return here.
+*/
+#define ENTER(c)							\
+    joy_context = c;							\
+    if (!c->running) {							\
+	if (setjmp(c->begin))						\
+	    return c->status;						\
+    }
+
+JoyContext *joy_open(void)
+{
+    JoyContext *c;
+
+#ifdef GC_BDW
+    GC_init();
+#endif
+    if ((c = joy_context_new()) == 0)
+	return 0;
+    joy_context = c;
+    if (!symtabindex)
+	inisymboltable();
+    c->embedded = 1;
+    autoput = 0;
+    tracegc = 0;
+    open_count++;
+    return c;
+}
+
+/*
+    joy_close disposes of the context c. When it is the last one, the
+    threads that run tasks are stopped, see task.c.
+*/
+void joy_close(JoyContext *c)
+{
+    if (!c)
+	return;
+    if (--open_count == 0)
+	task_stop();
+    joy_context_free(c);
+}
+
+const char *joy_error(JoyContext *c)
+{
+    return c->errmsg;
+}
+
+/*
+    joy_run reads and runs from srcfile, or from srctext when that is 0,
+    until the end of the input or an error.
+*/
+PRIVATE int joy_run(JoyContext *c, FILE *fp, char *text, char *name)
+{
+    if (c->running) {
+	strcpy(c->errmsg, "joy_eval in a native primitive");
+	return JOY_ERROR;
+    }
+    joy_context = c;
+    srcfile = fp;
+    inilinebuffer(name);
+    c->srctext = text;
+    c->status = JOY_ABORT;
+    strcpy(c->errmsg, "abort");
+    c->running = 1;
+    if (setjmp(c->begin) == 0)
+	for (;;)
+	    readeval();
+    joy_context = c;
+    c->running = 0;
+    c->srctext = 0;
+    while (c->ilevel > 0)			/* unfinished includes */
+	endinclude(0);
+    if (c->errorcount && (c->status == JOY_OK || c->status == JOY_ABORT))
+	c->status = JOY_SYNTAX;
+    else if (c->status == JOY_OK || c->status == JOY_QUIT)
+	c->errmsg[0] = '\0';
+    return c->status;
+}
+
+int joy_eval(JoyContext *c, const char *text)
+{
+    return joy_run(c, 0, (char *)text, 0);
+}
+
+int joy_eval_file(JoyContext *c, const char *name)
+{
+    FILE *fp;
+    int status;
+
+    if ((fp = fopen(name, "r")) == 0) {
+#ifdef USE_SNPRINTF
+	snprintf(c->errmsg, INPLINEMAX, "failed to open the file '%s'", name);
+#else
+	sprintf(c->errmsg, "failed to open the file '%.*s'", INPLINEMAX - 40,
+		name);
+#endif
+	return JOY_FILE;
+    }
+    status = joy_run(c, fp, 0, (char *)name);
+    fclose(fp);
+    return status;
+}
+
+int joy_register(JoyContext *c, const char *name, JoyNative fn)
+{
+    char text[INPLINEMAX], *str;
+    int status;
+
+    if (native_count == NATIVEMAX) {
+	strcpy(c->errmsg, "too many native primitives");
+	return JOY_FULL;
+    }
+    if (strlen(name) >= ALEN || (str = malloc(strlen(name) + 1)) == 0) {
+	strcpy(c->errmsg, "valid name needed for joy_register");
+	return JOY_ERROR;
+    }
+    strcpy(str, name);
+    natives[native_count].name = str;
+    natives[native_count].fn = fn;
+    sprintf(text, "DEFINE %s == %d __native.", name, native_count);
+    if ((status = joy_eval(c, text)) == JOY_OK)
+	native_count++;
+    return status;
+}
+
+PUBLIC void native_exec(long n)
+{
+    JoyContext *c = joy_context;
+
+    if (n < 0 || n >= native_count)
+	execerror("native primitive", "__native");
+    if ((*natives[n].fn)(c) != JOY_OK) {
+	joy_context = c;
+	execerror("valid parameters", natives[n].name);
+    }
+    joy_context = c;
+}
+
+long joy_depth(JoyContext *c)
+{
+    long depth;
+    Node *n;
+
+    joy_context = c;
+    for (depth = 0, n = stk; n; n = n->next)
+	depth++;
+    return depth;
+}
+
+int joy_type(JoyContext *c)
+{
+    joy_context = c;
+    if (!stk)
+	return JOY_NONE;
+    switch (stk->op) {
+    case BOOLEAN_:
+	return JOY_BOOLEAN;
+    case CHAR_:
+	return JOY_CHAR;
+    case INTEGER_:
+	return JOY_INTEGER;
+    case SET_:
+	return JOY_SET;
+    case STRING_:
+	return JOY_STRING;
+    case LIST_:
+	return JOY_LIST;
+    case FLOAT_:
+	return JOY_FLOAT;
+    default:
+	return JOY_OTHER;
+    }
+}
+
+int joy_push_boolean(JoyContext *c, int b)
+{
+    ENTER(c);
+    stk = BOOLEAN_NEWNODE(b != 0, stk);
+    return JOY_OK;
+}
+
+int joy_push_char(JoyContext *c, int ch)
+{
+    ENTER(c);
+    stk = CHAR_NEWNODE(ch, stk);
+    return JOY_OK;
+}
+
+int joy_push_integer(JoyContext *c, joy_int n)
+{
+    ENTER(c);
+    stk = INTEGER_NEWNODE(n, stk);
+    return JOY_OK;
+}
+
+int joy_push_float(JoyContext *c, double d)
+{
+    ENTER(c);
+    stk = FLOAT_NEWNODE(d, stk);
+    return JOY_OK;
+}
+
+int joy_push_string(JoyContext *c, const char *s)
+{
+    char *str;
+
+    ENTER(c);
+    if ((str = malloc(strlen(s) + 1)) == 0)
+	execerror("memory", "joy_push_string");
+    strcpy(str, s);
+    stk = STRING_NEWNODE(str, stk);
+    return JOY_OK;
+}
+
+/*
+    make_list replaces the top count values by the list of them, the
+    deepest first. The list is built on dump1, where the garbage
+    collector can see it.
+*/
+PUBLIC void make_list(long count)
+{
+    Node *n;
+
+#ifdef SINGLE
+    for (n = 0; count--; stk = stk->next)
+	n = newnode(stk->op, stk->u, n);
+    stk = LIST_NEWNODE(n, stk);
+#else
+    dump1 = LIST_NEWNODE(0, dump1);
+    for (; count--; stk = stk->next) {
+	n = newnode(stk->op, stk->u, dump1->u.lis);
+	dump1->u.lis = n;
+    }
+    n = newnode(LIST_, dump1->u, stk);
+    stk = n;
+    dump1 = dump1->next;
+#endif
+}
+
+int joy_push_list(JoyContext *c, long count)
+{
+    if (count < 0 || joy_depth(c) < count)
+	return JOY_TYPE;
+    ENTER(c);
+    make_list(count);
+    return JOY_OK;
+}
+
+#define POPVALUE(TYPE, FIELD, VALUE)					\
+    joy_context = c;							\
+    if (!stk || stk->op != TYPE)					\
+	return JOY_TYPE;						\
+    *FIELD = stk->u.VALUE;						\
+    stk = stk->next;							\
+    return JOY_OK
+
+int joy_pop_boolean(JoyContext *c, int *b)
+{
+    POPVALUE(BOOLEAN_, b, num);
+}
+
+int joy_pop_char(JoyContext *c, int *ch)
+{
+    POPVALUE(CHAR_, ch, num);
+}
+
+int joy_pop_integer(JoyContext *c, joy_int *n)
+{
+    POPVALUE(INTEGER_, n, num);
+}
+
+int joy_pop_float(JoyContext *c, double *d)
+{
+    POPVALUE(FLOAT_, d, dbl);
+}
+
+int joy_pop_string(JoyContext *c, const char **s)
+{
+    POPVALUE(STRING_, s, str);
+}
+
+int joy_pop_list(JoyContext *c, long *count)
+{
+    Node *n;
+
+    ENTER(c);
+    if (!stk || stk->op != LIST_)
+	return JOY_TYPE;
+    *count = 0;
+#ifdef SINGLE
+    for (n = stk->u.lis, stk = stk->next; n; n = n->next, ++*count)
+	stk = newnode(n->op, n->u, stk);
+#else
+    dump1 = newnode(LIST_, stk->u, dump1);
+    for (stk = stk->next; dump1->u.lis; dump1->u.lis = dump1->u.lis->next) {
+	n = newnode(dump1->u.lis->op, dump1->u.lis->u, stk);
+	stk = n;
+	++*count;
+    }
+    dump1 = dump1->next;
+#endif
+    return JOY_OK;
+}
+/* END of LIBJOY.C */
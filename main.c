@@ -113,32 +113,74 @@ of doing this, possibly by separating the cases and duplicating
 some of the code.
 
 Manfred von Thun, 2006
+
+The symbol table is shared by the contexts of all threads, and new names
+can be entered while a program runs, by the intern primitive. A lock is
+held from the search in the global table until the name is entered, and
+while a hidden name is entered.
 */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#endif
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <setjmp.h>
-#include <time.h>
 #define ALLOC
 #include "globals.h"
-#ifdef strdup
-#undef strdup
-#endif
-#ifdef GC_BDW
-#include <gc.h>
-#define strdup GC_strdup
+#ifndef _WIN32
+#include <pthread.h>
+
+static pthread_mutex_t symtab_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK		pthread_mutex_lock(&symtab_lock)
+#define UNLOCK		pthread_mutex_unlock(&symtab_lock)
 #else
-char *my_strdup(char *str);
-#define strdup my_strdup
+#define LOCK
+#define UNLOCK
 #endif
 
-PRIVATE void enterglobal(void)
+#ifndef _WIN32
+static pthread_once_t symtab_once = PTHREAD_ONCE_INIT;
+
+PRIVATE void symtab_prepare(void)
+{
+    LOCK;
+    intern_prepare();
+}
+
+PRIVATE void symtab_release(void)
 {
-    if (symtabindex - symtab >= SYMTABMAX)
+    intern_release();
+    UNLOCK;
+}
+
+PRIVATE void symtab_register(void)
+{
+    pthread_atfork(symtab_prepare, symtab_release, symtab_release);
+}
+#endif
+
+/*
+    symtab_atfork makes a fork take the lock of the symbol table and then
+    that of the intern table, as lookup does, so that the child does not
+    start with one that is held by a thread it does not have.
+*/
+PUBLIC void symtab_atfork(void)
+{
+#ifndef _WIN32
+    pthread_once(&symtab_once, symtab_register);
+#endif
+}
+
+PRIVATE void enterglobal(void)		/* with the lock held	*/
+{
+    if (symtabindex - symtab >= SYMTABMAX) {
+	UNLOCK;
 	execerror("index", "symbols");
+    }
     location = symtabindex++;
 D(  printf("getsym, new: '%s'\n", ident); )
-    location->name = strdup(ident);
+    location->name = intern(ident, &location->hash);
     location->u.body = NULL; /* may be assigned in definition */
 #ifdef USE_UNKNOWN_SYMBOLS
     location->is_unknown = 1;
@@ -161,12 +203,14 @@ D(  printf("%s  hashes to %d\n", ident, hashvalue); )
 	    return;
     }
 
+    LOCK;
     location = hashentry[hashvalue];
     while (location != symtab && strcmp(ident, location->name) != 0)
 	location = location->next;
 
     if (location == symtab) /* not found, enter in global */
 	enterglobal();
+    UNLOCK;
 }
 
 #ifdef USE_UNKNOWN_SYMBOLS
@@ -192,30 +236,38 @@ PRIVATE void enteratom(void)
 #ifdef USE_UNKNOWN_SYMBOLS
     lookup();
     if (display_enter > 0) {
+	LOCK;
 	if (location->is_unknown)
 	    detachatom();
 	else {
-	    if (symtabindex - symtab >= SYMTABMAX)
+	    if (symtabindex - symtab >= SYMTABMAX) {
+		UNLOCK;
 		execerror("index", "symbols");
+	    }
 	    location = symtabindex++;
 D(  printf("hidden definition '%s' at %p\n",ident,(void *)LOC2INT(location)); )
-	    location->name = strdup(ident);
+	    location->name = intern(ident, &location->hash);
 	    location->u.body = NULL; /* may be assigned later */
 	}
 #ifdef NO_HELP_LOCAL_SYMBOLS
 	location->is_local = 1;
 #endif
+	UNLOCK;
 	location->next = display[display_enter];
 	display[display_enter] = location;
     }
     location->is_unknown = 0;
 #else
     if (display_enter > 0) {
-	if (symtabindex - symtab >= SYMTABMAX)
+	LOCK;
+	if (symtabindex - symtab >= SYMTABMAX) {
+	    UNLOCK;
 	    execerror("index", "symbols");
+	}
 	location = symtabindex++;
+	UNLOCK;
 D(  printf("hidden definition '%s' at %p\n",ident,(void *)LOC2INT(location)); )
-	location->name = strdup(ident);
+	location->name = intern(ident, &location->hash);
 	location->u.body = NULL; /* may be assigned later */
 #ifdef NO_HELP_LOCAL_SYMBOLS
 	location->is_local = 1;
@@ -268,6 +320,8 @@ D(  writeterm(stk->u.lis, stdout); )
 D(  printf("\n"); )
     if (here != NULL) {
 	here->u.body = stk->u.lis;
+	here->memo = 0;
+	memo_clear();				/* results may change */
 	/* here->is_module = 0; */
     }
     stk = stk->next;
@@ -351,10 +405,11 @@ PRIVATE void compound_def(void)
     }
 }
 
-jmp_buf begin;
+#define begin	(joy_context->begin)
 
 PUBLIC void abortexecution_(void)
 {
+    par_reap();
 #ifndef SINGLE
     conts = dump = dump1 = dump2 = dump3 = dump4 = dump5 = NULL;
 #endif
@@ -363,135 +418,86 @@ PUBLIC void abortexecution_(void)
 
 PUBLIC void execerror(char *message, char *op)
 {
-    printf("run time error: %s needed for %s\n", message, op);
+    par_exit();
+    if (joy_context->embedded) {
+	joy_context->status = JOY_ERROR;
+	strncpy(joy_context->errmess, message, INPLINEMAX / 2 - 1);
+	strncpy(joy_context->errop, op, INPLINEMAX / 2 - 1);
+#ifdef USE_SNPRINTF
+	snprintf(joy_context->errmsg, INPLINEMAX,
+		 "run time error: %s needed for %s", message, op);
+#else
+	sprintf(joy_context->errmsg, "run time error: %.*s needed for %.*s",
+		INPLINEMAX / 2 - 40, message, INPLINEMAX / 2 - 40, op);
+#endif
+    } else
+	printf("run time error: %s needed for %s\n", message, op);
     abortexecution_();
 }
 
 PUBLIC void quit_(void)
 {
+    if (joy_context->embedded) {
+	joy_context->status = JOY_QUIT;
+	abortexecution_();
+    }
     exit(0);
 }
 
-static int mustinclude = 1;
-
 #define CHECK(D, NAME)						\
     if (D) {							\
         printf("->  %s is not empty:\n", NAME);			\
 	writeterm(D, stdout); printf("\n"); }
 
-int main(int argc, char **argv)
+/*
+    readeval reads a definition or a term, and runs the term.
+*/
+PUBLIC void readeval(void)
 {
-    FILE *fp;
 #ifdef SINGLE
     Node *my_prog;
 #endif
-#ifdef GC_BDW
-    GC_init();
-#endif
-    g_argc = argc;
-    g_argv = argv;
-    if (argc > 1) {
-	g_argc--;
-	g_argv++;
-	srcfile = fopen(argv[1], "r");
-	if (!srcfile) {
-	    printf("failed to open the file '%s'.\n", argv[1]);
-	    exit(0);
-	}
-	inilinebuffer(argv[1]);
-	if (!strcmp(argv[1], "joytut.inp") ||
-	    !strcmp(argv[1], "jp-joytst.joy")) {
-	    printf("JOY  -  compiled at 11:59:37 on Jul  2 2001 (NOBDW)\n");
-	    printf("Copyright 2001 by Manfred von Thun\n");
-	}
-	if (!strcmp(argv[1], "laztst.joy")) {
-	    printf("JOY  -  compiled at 15:32:32 on Nov 12 2001 (BDW)\n");
-	    printf("Copyright 2001 by Manfred von Thun\n");
-	}
-	if (!strcmp(argv[1], "lsptst.joy") || !strcmp(argv[1], "plgtst.joy") ||
-	    !strcmp(argv[1], "symtst.joy")) {
-	    printf("JOY  -  compiled at 14:54:45 on Feb  1 2002 (BDW)\n");
-	    printf("Copyright 2001 by Manfred von Thun\n");
-	}
-	if (!strcmp(argv[1], "grmtst.joy") || !strcmp(argv[1], "mtrtst.joy")) {
-	    printf("JOY  -  compiled at 15:19:20 on Apr  3 2002 (BDW)\n");
-	    printf("Copyright 2001 by Manfred von Thun\n");
-	}
-	if (!strcmp(argv[1], "modtst.joy")) {
-	    printf("JOY  -  compiled at 16:57:51 on Mar 17 2003 (BDW)\n");
-	    printf("Copyright 2001 by Manfred von Thun\n");
-	}
+
+    getsym();
+    if (symb == LIBRA || symb == HIDE || symb == MODULE ) {
+	inimem1();
+	compound_def();
+	inimem2();
     } else {
-	srcfile = stdin;
-	inilinebuffer(0);
-#ifdef GC_BDW
-	printf("JOY  -  compiled at %s on %s (BDW)\n", __TIME__, __DATE__);
-#else
-	printf("JOY  -  compiled at %s on %s (NOBDW)\n", __TIME__, __DATE__);
-#endif
-	printf("Copyright 2001 by Manfred von Thun\n");
-    }
-    startclock = clock();
-    gc_clock = 0;
-    echoflag = INIECHOFLAG;
-    tracegc = INITRACEGC;
-    autoput = INIAUTOPUT;
-    inisymboltable();
-    display[0] = NULL;
-    inimem1();
-    inimem2();
-    setjmp(begin);
-D(  printf("starting main loop\n"); )
-    setbuf(stdout, 0);
-    while (1) {
-	if (mustinclude) {
-	    mustinclude = 0;
-	    if ((fp = fopen("usrlib.joy", "r")) != 0) {
-		fclose(fp);
-		doinclude("usrlib.joy");
-	    }
-	}
-	getsym();
-	if (symb == LIBRA || symb == HIDE || symb == MODULE ) {
-	    inimem1();
-	    compound_def();
-	    inimem2();
-	} else {
-	    readterm();
+	readterm();
 D(  printf("program is: "); writeterm(stk->u.lis, stdout); printf("\n"); )
 #ifdef SINGLE
-	    if (stk != NULL) {
-		my_prog = stk->u.lis;
-		stk = stk->next;
-		exeterm(my_prog);
-	    }
+	if (stk != NULL) {
+	    my_prog = stk->u.lis;
+	    stk = stk->next;
+	    exeterm(my_prog);
+	}
 #else
-	    if (stk != NULL) {
-		prog = stk->u.lis;
-		stk = stk->next;
-		conts = NULL;
-		exeterm(prog);
-	    }
-	    if (conts || dump || dump1 || dump2 || dump3 || dump4 || dump5) {
-		printf("the dumps are not empty\n");
-		CHECK(conts, "conts");
-		CHECK(dump, "dump"); CHECK(dump1, "dump1");
-		CHECK(dump2, "dump2"); CHECK(dump3, "dump3");
-		CHECK(dump4, "dump4"); CHECK(dump5, "dump5");
-	    }
+	if (stk != NULL) {
+	    joy_context->prog = stk->u.lis;
+	    stk = stk->next;
+	    conts = NULL;
+	    exeterm(joy_context->prog);
+	}
+	if (conts || dump || dump1 || dump2 || dump3 || dump4 || dump5) {
+	    printf("the dumps are not empty\n");
+	    CHECK(conts, "conts");
+	    CHECK(dump, "dump"); CHECK(dump1, "dump1");
+	    CHECK(dump2, "dump2"); CHECK(dump3, "dump3");
+	    CHECK(dump4, "dump4"); CHECK(dump5, "dump5");
+	}
 #endif
-	    if (autoput == 2 && stk != NULL) {
-		writeterm(stk, stdout);
-		printf("\n");
-	    } else if (autoput == 1 && stk != NULL) {
-		writefactor(stk, stdout);
-		printf("\n");
-		stk = stk->next;
-	    }
+	if (autoput == 2 && stk != NULL) {
+	    writeterm(stk, stdout);
+	    printf("\n");
+	} else if (autoput == 1 && stk != NULL) {
+	    writefactor(stk, stdout);
+	    printf("\n");
+	    stk = stk->next;
 	}
+    }
 #ifdef CHECK_END_SYMBOL
-	if (symb != END && symb != PERIOD)
-	    error(" END or period '.' expected");
+    if (symb != END && symb != PERIOD)
+	error(" END or period '.' expected");
 #endif
-    }
 }
@@ -0,0 +1,483 @@
+/* FILE: matrix.c */
+/*
+ *  module  : matrix.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A matrix is either a list of rows, each a list of numbers, or a packed
+FLOATARRAY_ whose rows field tells how the numbers are divided; a packed
+vector counts as a single row. A list of rows is read into dense arrays
+in row-major order before anything is allocated. Results are written
+back into a list of the same kind in two steps: first all cells are
+made, then they are filled, so that nothing is moved by the garbage
+collector during the filling. Results on lists follow the rules of +
+and * for each element: integers stay integers and become bignums when
+needed, floats are contagious. A packed operand gives a packed result.
+Products are computed in blocks that fit in the cache, with the inner
+loop running along a row of the result, so that it vectorizes; each
+element is still summed in the order of k.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+#define BLOCK		64		/* three blocks fit in the cache */
+#define MIN(a, b)	((a) < (b) ? (a) : (b))
+
+typedef struct Dense {
+    long rows, cols;
+    double *dbl;			/* the elements as doubles	*/
+    Num *num;				/* the elements, if integers	*/
+    Node *elem;				/* the elements of a list	*/
+} Dense;
+
+PRIVATE void *alloc_dense(long count, size_t size)
+{
+    void *p;
+
+    if ((p = malloc(count * size + 1)) == 0)
+	execerror("memory", "matrix");
+    return p;
+}
+
+PRIVATE double to_double(Node *n)
+{
+    switch (n->op) {
+    case FLOAT_:
+	return n->u.dbl;
+    case BIGNUM_:
+	return num_double(n);
+    case RATIONAL_:
+	return rat_double(n);
+    default:
+	return (double)n->u.num;
+    }
+}
+
+PRIVATE int is_number(Node *n)
+{
+    return n->op == INTEGER_ || n->op == FLOAT_ ||
+	   n->op == BIGNUM_ || n->op == RATIONAL_;
+}
+
+/*
+    read_dense reads a matrix. For a list, elem receives the elements,
+    and num as well when all of them are integers.
+*/
+PRIVATE void read_dense(Node *n, Dense *d, char *name)
+{
+    Node *row, *e;
+    long i, j;
+    int integral = 1;
+
+    memset(d, 0, sizeof(Dense));
+    if (n->op == FLOATARRAY_) {
+	d->rows = n->u.farr->rows ? n->u.farr->rows : n->u.farr->size > 0;
+	d->cols = d->rows ? n->u.farr->size / d->rows : 0;
+	d->dbl = n->u.farr->dbl;
+	return;
+    }
+    if (n->op != LIST_)
+	execerror("matrix", name);
+    for (row = n->u.lis; row; row = row->next, d->rows++) {
+	if (row->op != LIST_)
+	    execerror("matrix", name);
+	for (j = 0, e = row->u.lis; e; e = e->next, j++) {
+	    if (!is_number(e))
+		execerror("matrix of numbers", name);
+	    if (e->op != INTEGER_)
+		integral = 0;
+	}
+	if (row == n->u.lis)
+	    d->cols = j;
+	else if (j != d->cols)
+	    execerror("rows of equal length", name);
+    }
+    d->elem = alloc_dense(d->rows * d->cols, sizeof(Node));
+    d->dbl = alloc_dense(d->rows * d->cols, sizeof(double));
+    if (integral)
+	d->num = alloc_dense(d->rows * d->cols, sizeof(Num));
+    for (i = 0, row = n->u.lis; row; row = row->next)
+	for (e = row->u.lis; e; e = e->next, i++) {
+	    d->elem[i].op = e->op;
+	    d->elem[i].u = e->u;
+	    d->elem[i].next = 0;
+	    d->dbl[i] = to_double(e);
+	    if (integral)
+		d->num[i] = e->u.num;
+	}
+}
+
+PRIVATE void free_dense(Dense *d)
+{
+    if (d->elem) {
+	free(d->elem);
+	free(d->dbl);
+    }
+    if (d->num) {
+	free(d->num);
+    }
+}
+
+/*
+    mat_cells makes a list of rows of integers, to be filled in by the
+    caller. The list under construction is kept on the stack.
+*/
+PUBLIC Node *mat_cells(long rows, long cols)
+{
+    Node *row;
+    long i, j;
+
+    stk = LIST_NEWNODE(0, stk);
+    for (i = 0; i < rows; i++) {
+	for (row = 0, j = 0; j < cols; j++)
+	    row = INTEGER_NEWNODE(0, row);
+	row = LIST_NEWNODE(row, stk->u.lis);
+	stk->u.lis = row;
+    }
+    row = stk->u.lis;
+    stk = stk->next;
+    return row;
+}
+
+PRIVATE Operator write_list(Node *elem, long rows, long cols, Types *u)
+{
+    Node *row, *e;
+
+    u->lis = mat_cells(rows, cols);
+    for (row = u->lis; row; row = row->next)
+	for (e = row->u.lis; e; e = e->next, elem++) {
+	    e->op = elem->op;
+	    e->u = elem->u;
+	}
+    return LIST_;
+}
+
+/*
+    arith computes x OPER y, where OPER is + or *, as + and * would.
+*/
+PRIVATE void arith(Node *x, Node *y, int oper, Node *r)
+{
+    Node t;
+
+    t.next = 0;
+    if (x->op == FLOAT_ || y->op == FLOAT_) {
+	t.op = FLOAT_;
+	t.u.dbl = oper == '+' ? to_double(x) + to_double(y)
+			      : to_double(x) * to_double(y);
+    } else if (x->op == INTEGER_ && y->op == INTEGER_ &&
+	       !(oper == '+' ? OVERFLOW(x->u.num, y->u.num, add, &t.u.num)
+			     : OVERFLOW(x->u.num, y->u.num, mul, &t.u.num)))
+	t.op = INTEGER_;
+    else
+	t.op = rat_arith(x, y, oper, &t.u);
+    *r = t;
+}
+
+KERNEL
+PRIVATE void mul_double(double *restrict c, const double *restrict a,
+			const double *restrict b, long n, long m, long p)
+{
+    long i, j, k, ii, jj, kk, iend, jend, kend;
+    double x;
+
+    memset(c, 0, n * p * sizeof(double));
+    for (ii = 0; ii < n; ii += BLOCK)
+	for (kk = 0; kk < m; kk += BLOCK)
+	    for (jj = 0; jj < p; jj += BLOCK) {
+		iend = MIN(ii + BLOCK, n);
+		kend = MIN(kk + BLOCK, m);
+		jend = MIN(jj + BLOCK, p);
+		for (i = ii; i < iend; i++)
+		    for (k = kk; k < kend; k++) {
+			x = a[i * m + k];
+			for (j = jj; j < jend; j++)
+			    c[i * p + j] += x * b[k * p + j];
+		    }
+	    }
+}
+
+PRIVATE int mul_integer(Num *c, const Num *a, const Num *b,
+			long n, long m, long p)
+{
+    long i, j, k, ii, jj, kk, iend, jend, kend;
+    Num x, y;
+
+    memset(c, 0, n * p * sizeof(Num));
+    for (ii = 0; ii < n; ii += BLOCK)
+	for (kk = 0; kk < m; kk += BLOCK)
+	    for (jj = 0; jj < p; jj += BLOCK) {
+		iend = MIN(ii + BLOCK, n);
+		kend = MIN(kk + BLOCK, m);
+		jend = MIN(jj + BLOCK, p);
+		for (i = ii; i < iend; i++)
+		    for (k = kk; k < kend; k++) {
+			x = a[i * m + k];
+			for (j = jj; j < jend; j++)
+			    if (OVERFLOW(x, b[k * p + j], mul, &y) ||
+				OVERFLOW(c[i * p + j], y, add, &c[i * p + j]))
+				return 1;
+		    }
+	    }
+    return 0;
+}
+
+/*
+    mul_cell computes element i, j of the product with + and *.
+*/
+PRIVATE void mul_cell(Node *c, Node *a, Node *b, long i, long j,
+		      long m, long p)
+{
+    long k;
+    Node t;
+
+    c[i * p + j].op = INTEGER_;
+    c[i * p + j].u.num = 0;
+    for (k = 0; k < m; k++) {
+	arith(&a[i * m + k], &b[k * p + j], '*', &t);
+	arith(&c[i * p + j], &t, '+', &c[i * p + j]);
+    }
+}
+
+PRIVATE void mul_exact(Node *c, Node *a, Node *b, long n, long m, long p)
+{
+    long i, j;
+
+    for (i = 0; i < n; i++)
+	for (j = 0; j < p; j++)
+	    mul_cell(c, a, b, i, j, m, p);
+}
+
+/*
+    mul_mixed multiplies lists of integers and floats. An element is a
+    float when a float takes part in it, that is when its row of a or
+    its column of b holds one; it is taken from the kernel on doubles.
+    The other elements are computed with + and *, so that they stay
+    integers.
+*/
+PRIVATE void mul_mixed(Node *c, Dense *x, Dense *y)
+{
+    long i, j, k, n = x->rows, m = x->cols, p = y->cols;
+    char *row, *col;
+    double *d;
+
+    row = alloc_dense(n, 1);
+    col = alloc_dense(p, 1);
+    memset(row, 0, n);
+    memset(col, 0, p);
+    for (i = 0; i < n; i++)
+	for (k = 0; k < m; k++)
+	    if (x->elem[i * m + k].op == FLOAT_)
+		row[i] = 1;
+    for (k = 0; k < m; k++)
+	for (j = 0; j < p; j++)
+	    if (y->elem[k * p + j].op == FLOAT_)
+		col[j] = 1;
+    d = alloc_dense(n * p, sizeof(double));
+    mul_double(d, x->dbl, y->dbl, n, m, p);
+    for (i = 0; i < n; i++)
+	for (j = 0; j < p; j++)
+	    if (row[i] || col[j]) {
+		c[i * p + j].op = FLOAT_;
+		c[i * p + j].u.dbl = d[i * p + j];
+	    } else
+		mul_cell(c, x->elem, y->elem, i, j, m, p);
+    free(d);
+    free(col);
+    free(row);
+}
+
+/*
+    exact tells whether a list holds bignums or rationals, which the
+    kernel on doubles would round.
+*/
+PRIVATE int exact(Dense *d)
+{
+    long i;
+
+    for (i = 0; d->elem && i < d->rows * d->cols; i++)
+	if (d->elem[i].op == BIGNUM_ || d->elem[i].op == RATIONAL_)
+	    return 1;
+    return 0;
+}
+
+PUBLIC Operator mat_mul(Node *a, Node *b, Types *u, char *name)
+{
+    Dense x, y;
+    Node *c;
+    Num *k;
+    long i, n, m, p;
+    Operator op;
+
+    read_dense(a, &x, name);
+    read_dense(b, &y, name);
+    if (x.cols != y.rows)
+	execerror("conformable matrices", name);
+    n = x.rows;
+    m = x.cols;
+    p = y.cols;
+    if (!x.elem || !y.elem) {
+	u->farr = arr_new(n, p);
+	mul_double(u->farr->dbl, x.dbl, y.dbl, n, m, p);
+	free_dense(&x);
+	free_dense(&y);
+	return FLOATARRAY_;
+    }
+    c = alloc_dense(n * p, sizeof(Node));
+    if (x.num && y.num) {
+	k = alloc_dense(n * p, sizeof(Num));
+	if (mul_integer(k, x.num, y.num, n, m, p))
+	    mul_exact(c, x.elem, y.elem, n, m, p);
+	else
+	    for (i = 0; i < n * p; i++) {
+		c[i].op = INTEGER_;
+		c[i].u.num = k[i];
+	    }
+	free(k);
+    } else if (exact(&x) || exact(&y))
+	mul_exact(c, x.elem, y.elem, n, m, p);
+    else
+	mul_mixed(c, &x, &y);
+    free_dense(&x);
+    free_dense(&y);
+    op = write_list(c, n, p, u);
+    free(c);
+    return op;
+}
+
+KERNEL
+PRIVATE void add_double(double *restrict c, const double *restrict a,
+			const double *restrict b, long n)
+{
+    long i;
+
+    for (i = 0; i < n; i++)
+	c[i] = a[i] + b[i];
+}
+
+PUBLIC Operator mat_add(Node *a, Node *b, Types *u, char *name)
+{
+    Dense x, y;
+    Node *c;
+    long i, size;
+    Operator op;
+
+    read_dense(a, &x, name);
+    read_dense(b, &y, name);
+    if (x.rows != y.rows || x.cols != y.cols)
+	execerror("matrices of equal size", name);
+    size = x.rows * x.cols;
+    if (!x.elem || !y.elem) {
+	u->farr = arr_new(x.rows, x.cols);
+	add_double(u->farr->dbl, x.dbl, y.dbl, size);
+	free_dense(&x);
+	free_dense(&y);
+	return FLOATARRAY_;
+    }
+    c = alloc_dense(size, sizeof(Node));
+    for (i = 0; i < size; i++)
+	arith(&x.elem[i], &y.elem[i], '+', &c[i]);
+    free_dense(&x);
+    free_dense(&y);
+    op = write_list(c, x.rows, x.cols, u);
+    free(c);
+    return op;
+}
+
+KERNEL
+PRIVATE void scale_double(double *restrict c, const double *restrict a,
+			  double s, long n)
+{
+    long i;
+
+    for (i = 0; i < n; i++)
+	c[i] = a[i] * s;
+}
+
+PUBLIC Operator mat_scale(Node *a, Node *s, Types *u, char *name)
+{
+    Dense x;
+    Node *c;
+    long i, size;
+    Operator op;
+
+    if (!is_number(s))
+	execerror("number", name);
+    read_dense(a, &x, name);
+    size = x.rows * x.cols;
+    if (!x.elem) {
+	u->farr = arr_new(x.rows, x.cols);
+	scale_double(u->farr->dbl, x.dbl, to_double(s), size);
+	return FLOATARRAY_;
+    }
+    c = alloc_dense(size, sizeof(Node));
+    for (i = 0; i < size; i++)
+	arith(&x.elem[i], s, '*', &c[i]);
+    free_dense(&x);
+    op = write_list(c, x.rows, x.cols, u);
+    free(c);
+    return op;
+}
+
+/*
+    mat_transpose transposes a packed matrix, one block at a time, so
+    that the writes do not stride through the whole of memory.
+*/
+PUBLIC Operator mat_transpose(Node *a, Types *u, char *name)
+{
+    Dense x;
+    double *t;
+    long i, j, ii, jj, iend, jend;
+
+    read_dense(a, &x, name);
+    u->farr = arr_new(x.cols, x.rows);
+    t = u->farr->dbl;
+    for (ii = 0; ii < x.rows; ii += BLOCK)
+	for (jj = 0; jj < x.cols; jj += BLOCK) {
+	    iend = MIN(ii + BLOCK, x.rows);
+	    jend = MIN(jj + BLOCK, x.cols);
+	    for (i = ii; i < iend; i++)
+		for (j = jj; j < jend; j++)
+		    t[j * x.rows + i] = x.dbl[i * x.cols + j];
+	}
+    return FLOATARRAY_;
+}
+
+PUBLIC Operator mat_pack(Node *a, Types *u, char *name)
+{
+    Dense x;
+
+    read_dense(a, &x, name);
+    u->farr = arr_new(x.rows, x.cols);
+    memcpy(u->farr->dbl, x.dbl, x.rows * x.cols * sizeof(double));
+    free_dense(&x);
+    return FLOATARRAY_;
+}
+
+/*
+    mat_unpack delivers the rows of a packed matrix as lists of floats.
+*/
+PUBLIC Node *mat_unpack(Node *a, char *name)
+{
+    Dense x;
+    Node *list, *row, *e;
+    long i = 0;
+
+    read_dense(a, &x, name);
+    list = mat_cells(x.rows, x.cols);
+    for (row = list; row; row = row->next)
+	for (e = row->u.lis; e; e = e->next) {
+	    e->op = FLOAT_;
+	    e->u.dbl = x.dbl[i++];
+	}
+    return list;
+}
+/* END of MATRIX.C */
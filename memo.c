@@ -0,0 +1,206 @@
+/* FILE: memo.c */
+/*
+ *  module  : memo.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+The memo cache holds results of pure programs, for the memo combinator
+and for definitions that have been memoized. A result is found by the
+program, given as an id, and by the values of the arguments it was
+computed from: their hash selects a slot, and they are then compared
+with equal. The id of a definition is its entry; that of a quotation is
+its hash, so that the quotation itself is kept and compared as well.
+There are MEMOMAX slots and each holds one result, so that the cache
+stays bounded: a new result evicts the one in its slot.
+
+The garbage collector of the interpreter moves the nodes that lists and
+the like refer to, and the cache is not a root; so a result with such
+values is only valid in the collection it was stored in. Numbers, sets,
+strings and the other values that are not in node memory remain valid.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#endif
+
+#define MEMOMAX		4096		/* slots, a power of 2	*/
+
+#ifdef GC_BDW
+#define MEMOEPOCH	0
+#else
+#define MEMOEPOCH	gc_epoch
+#endif
+
+typedef struct Memo {
+    unsigned long id, hash;
+    long epoch;					/* of the store		*/
+    int nargs, stable;				/* nargs 0 is empty	*/
+    Node prog, arg[MEMOARGS], result;		/* prog: of memo	*/
+} Memo;
+
+#define memos		(joy_context->memos)
+#define memo_count	(joy_context->memo_count)
+#define memo_hits	(joy_context->memo_hits)
+#define memo_misses	(joy_context->memo_misses)
+#define memo_evictions	(joy_context->memo_evictions)
+#define memo_pure	(joy_context->memo_pure)
+
+PRIVATE int memo_stable(Node *n)
+{
+#ifdef GC_BDW
+    return n != 0;
+#else
+    switch (n->op) {
+    case LIST_:
+    case DICT_:
+    case VECTOR_:
+    case DEQUE_:
+    case HEAP_:
+    case ORDSET_:
+    case ORDMAP_:
+    case STREAM_:
+	return 0;
+    default:
+	return 1;
+    }
+#endif
+}
+
+/*
+    memo_key combines the id with the hashes of the top nargs values of
+    the list args.
+*/
+PUBLIC unsigned long memo_key(unsigned long id, int nargs, Node *args)
+{
+    unsigned long h = id * 31 + nargs;
+
+    for (; nargs > 0; nargs--, args = args->next)
+	h = h * 31 + dict_hash(args);
+    return h;
+}
+
+/*
+    memo_same tells whether the kept quotation kept is prog; a definition
+    has none.
+*/
+PRIVATE int memo_same(Node *kept, Node *prog)
+{
+    if (!prog)
+	return !kept->op;
+    return kept->op && equal_aux(kept, prog);
+}
+
+PRIVATE void memo_keep(Node *kept, Node *prog)
+{
+    kept->op = prog ? prog->op : 0;
+    kept->u.lis = prog ? prog->u.lis : 0;
+    kept->next = 0;
+}
+
+/*
+    memo_find delivers the result stored for id, the quotation prog and
+    the top nargs values of args, or 0 when there is none; it counts hits
+    and misses.
+*/
+PUBLIC Node *memo_find(unsigned long id, Node *prog, unsigned long hash,
+		       int nargs, Node *args)
+{
+    Memo *m;
+    int i;
+
+    m = memos ? &memos[hash & (MEMOMAX - 1)] : 0;
+    if (!m || m->nargs != nargs + 1 || m->hash != hash || m->id != id ||
+	(!m->stable && m->epoch != MEMOEPOCH) || !memo_same(&m->prog, prog)) {
+	memo_misses++;
+	return 0;
+    }
+    for (i = 0; i < nargs; i++, args = args->next)
+	if (!equal_aux(&m->arg[i], args)) {
+	    memo_misses++;
+	    return 0;
+	}
+    memo_hits++;
+    return &m->result;
+}
+
+PUBLIC void memo_store(unsigned long id, Node *prog, unsigned long hash,
+		       int nargs, Node *args, Node *result)
+{
+    Memo *m;
+    int i;
+
+    if (!memos) {
+	if ((memos = malloc(MEMOMAX * sizeof(Memo))) == 0)
+	    execerror("memory", "memo");
+	memset(memos, 0, MEMOMAX * sizeof(Memo));
+    }
+    m = &memos[hash & (MEMOMAX - 1)];
+    if (!m->nargs)
+	memo_count++;
+    else if (m->hash != hash || m->id != id)
+	memo_evictions++;
+    m->id = id;
+    m->hash = hash;
+    m->epoch = MEMOEPOCH;
+    m->nargs = nargs + 1;
+    m->stable = memo_stable(result) && (!prog || memo_stable(prog));
+    memo_keep(&m->prog, prog);
+    for (i = 0; i < nargs; i++, args = args->next) {
+	m->arg[i].op = args->op;
+	m->arg[i].u = args->u;
+	m->arg[i].next = 0;
+	m->stable = m->stable && memo_stable(args);
+    }
+    m->result.op = result->op;
+    m->result.u = result->u;
+    m->result.next = 0;
+}
+
+/*
+    memo_known tells whether the quotation prog, with hash id, has been
+    found pure before; memo_learn records that it is, so that it need not
+    be checked again.
+*/
+PUBLIC int memo_known(unsigned long id, Node *prog)
+{
+    int i = id % MEMOPURE;
+
+    return memo_pure[i].id == id && (memo_pure[i].epoch == MEMOEPOCH ||
+				     memo_stable(prog)) &&
+	   memo_same(&memo_pure[i].prog, prog);
+}
+
+PUBLIC void memo_learn(unsigned long id, Node *prog)
+{
+    int i = id % MEMOPURE;
+
+    memo_pure[i].id = id;
+    memo_pure[i].epoch = MEMOEPOCH;
+    memo_keep(&memo_pure[i].prog, prog);
+}
+
+/*
+    memo_clear empties the cache, as when a definition has changed.
+*/
+PUBLIC void memo_clear(void)
+{
+    if (memos && memo_count)
+	memset(memos, 0, MEMOMAX * sizeof(Memo));
+    memset(memo_pure, 0, sizeof(memo_pure));
+    memo_count = 0;
+}
+
+PUBLIC void memo_stats(long *hits, long *misses, long *count, long *evictions)
+{
+    *hits = memo_hits;
+    *misses = memo_misses;
+    *count = memo_count;
+    *evictions = memo_evictions;
+}
+/* END of MEMO.C */
@@ -0,0 +1,353 @@
+/* FILE: ordered.c */
+/*
+ *  module  : ordered.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+Ordered sets and maps are weight balanced trees, ordered by Compare. A
+tree keeps its size in every node, and neither side of a node may be
+more than DELTA times as heavy as the other; an insertion or deletion
+that breaks this is repaired with a single or a double rotation, as
+decided by RATIO, so that the depth stays logarithmic. The sizes also
+give the i-th element in logarithmic time. Trees are never modified:
+an update copies the path from the root and shares the rest, so that
+older trees remain valid. The empty tree is a null pointer; in a set
+the values are not used.
+
+Union, intersection and difference take the elements of both trees in
+order, merge them, and build a perfectly balanced tree of the result.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+#define DELTA		3
+#define RATIO		2
+
+PRIVATE long ord_size(Otree *t)
+{
+    return t ? t->size : 0;
+}
+
+PRIVATE Otree *ord_node(Node *key, Node *val, Otree *left, Otree *right)
+{
+    Otree *t;
+
+    if ((t = malloc(sizeof(Otree))) == 0)
+	execerror("memory", "ordered");
+    t->epoch = 0;
+    t->size = ord_size(left) + ord_size(right) + 1;
+    t->key.op = key->op;
+    t->key.u = key->u;
+    t->key.next = 0;
+    if (val)
+	t->val = *val;
+    else
+	memset(&t->val, 0, sizeof(Node));
+    t->val.next = 0;
+    t->left = left;
+    t->right = right;
+    return t;
+}
+
+/*
+    ord_balance builds a node of which one side may have become too
+    heavy by one insertion or deletion.
+*/
+PRIVATE Otree *ord_balance(Node *key, Node *val, Otree *l, Otree *r)
+{
+    long ln = ord_size(l), rn = ord_size(r);
+    Otree *x;
+
+    if (ln + rn > 1 && rn > DELTA * ln) {
+	if (ord_size(r->left) < RATIO * ord_size(r->right))
+	    return ord_node(&r->key, &r->val,
+			    ord_node(key, val, l, r->left), r->right);
+	x = r->left;
+	return ord_node(&x->key, &x->val, ord_node(key, val, l, x->left),
+			ord_node(&r->key, &r->val, x->right, r->right));
+    }
+    if (ln + rn > 1 && ln > DELTA * rn) {
+	if (ord_size(l->right) < RATIO * ord_size(l->left))
+	    return ord_node(&l->key, &l->val,
+			    l->left, ord_node(key, val, l->right, r));
+	x = l->right;
+	return ord_node(&x->key, &x->val,
+			ord_node(&l->key, &l->val, l->left, x->left),
+			ord_node(key, val, x->right, r));
+    }
+    return ord_node(key, val, l, r);
+}
+
+PRIVATE int ord_cmp(Node *a, Node *b, char *name)
+{
+    double d;
+    int error;
+
+    d = Compare(a, b, &error);
+    if (error)
+	execerror("comparable values", name);
+    return d < 0 ? -1 : d > 0;
+}
+
+/*
+    ord_insert adds key, or replaces it and its value when it is there.
+*/
+PUBLIC Otree *ord_insert(Otree *t, Node *key, Node *val, char *name)
+{
+    int c;
+
+    if (!t)
+	return ord_node(key, val, 0, 0);
+    if ((c = ord_cmp(key, &t->key, name)) < 0)
+	return ord_balance(&t->key, &t->val,
+			   ord_insert(t->left, key, val, name), t->right);
+    if (c > 0)
+	return ord_balance(&t->key, &t->val,
+			   t->left, ord_insert(t->right, key, val, name));
+    return ord_node(key, val, t->left, t->right);
+}
+
+PRIVATE Otree *ord_delmin(Otree *t)
+{
+    if (!t->left)
+	return t->right;
+    return ord_balance(&t->key, &t->val, ord_delmin(t->left), t->right);
+}
+
+PRIVATE Otree *ord_delmax(Otree *t)
+{
+    if (!t->right)
+	return t->left;
+    return ord_balance(&t->key, &t->val, t->left, ord_delmax(t->right));
+}
+
+/*
+    ord_glue joins the sides of a deleted node, with the nearest element
+    of the heavier side in between.
+*/
+PRIVATE Otree *ord_glue(Otree *l, Otree *r)
+{
+    Otree *m;
+
+    if (!l)
+	return r;
+    if (!r)
+	return l;
+    if (l->size > r->size) {
+	for (m = l; m->right; m = m->right)
+	    ;
+	return ord_balance(&m->key, &m->val, ord_delmax(l), r);
+    }
+    for (m = r; m->left; m = m->left)
+	;
+    return ord_balance(&m->key, &m->val, l, ord_delmin(r));
+}
+
+PUBLIC Otree *ord_delete(Otree *t, Node *key, char *name)
+{
+    Otree *s;
+    int c;
+
+    if (!t)
+	return 0;
+    if ((c = ord_cmp(key, &t->key, name)) < 0) {
+	if ((s = ord_delete(t->left, key, name)) == t->left)
+	    return t;				/* not there */
+	return ord_balance(&t->key, &t->val, s, t->right);
+    }
+    if (c > 0) {
+	if ((s = ord_delete(t->right, key, name)) == t->right)
+	    return t;
+	return ord_balance(&t->key, &t->val, t->left, s);
+    }
+    return ord_glue(t->left, t->right);
+}
+
+/*
+    ord_find delivers the node of key, or 0 when it is not there.
+*/
+PUBLIC Otree *ord_find(Otree *t, Node *key, char *name)
+{
+    int c;
+
+    while (t && (c = ord_cmp(key, &t->key, name)) != 0)
+	t = c < 0 ? t->left : t->right;
+    return t;
+}
+
+/*
+    ord_nth delivers the i-th key in the order, and its value in val, or
+    0 when there are not that many.
+*/
+PUBLIC Node *ord_nth(Otree *t, long i, Node **val)
+{
+    while (t) {
+	if (i < ord_size(t->left))
+	    t = t->left;
+	else if (i == ord_size(t->left)) {
+	    if (val)
+		*val = &t->val;
+	    return &t->key;
+	} else {
+	    i -= ord_size(t->left) + 1;
+	    t = t->right;
+	}
+    }
+    return 0;
+}
+
+/*
+    ord_make builds a set of the members of a list, or, when pairs is
+    set, a map of the pairs [key value] in the list.
+*/
+PUBLIC Otree *ord_make(Node *n, int pairs, char *name)
+{
+    Otree *t = 0;
+
+    for (; n; n = n->next)
+	if (!pairs)
+	    t = ord_insert(t, n, 0, name);
+	else if (n->op != LIST_ || !n->u.lis || !n->u.lis->next)
+	    execerror("pair [key value]", name);
+	else
+	    t = ord_insert(t, n->u.lis, n->u.lis->next, name);
+    return t;
+}
+
+/*
+    ord_list builds the list of the keys, from the last one.
+*/
+PUBLIC Node *ord_list(Otree *t)
+{
+    Node *n = 0, *key;
+    long i;
+
+    for (i = ord_size(t) - 1; i >= 0; i--) {
+	key = ord_nth(t, i, 0);
+	n = newnode(key->op, key->u, n);
+    }
+    return n;
+}
+
+PRIVATE void ord_fill(Otree *t, Otree **cell, long *count)
+{
+    for (; t; t = t->right) {
+	ord_fill(t->left, cell, count);
+	cell[(*count)++] = t;
+    }
+}
+
+PRIVATE Otree **ord_cells(Otree *t)
+{
+    Otree **cell;
+    long count = 0;
+
+    if ((cell = malloc((ord_size(t) + 1) * sizeof(Otree *))) == 0)
+	execerror("memory", "ordered");
+    ord_fill(t, cell, &count);
+    return cell;
+}
+
+PRIVATE Otree *ord_build(Otree **cell, long lo, long hi)
+{
+    long mid;
+
+    if (lo >= hi)
+	return 0;
+    mid = lo + (hi - lo) / 2;
+    return ord_node(&cell[mid]->key, &cell[mid]->val,
+		    ord_build(cell, lo, mid), ord_build(cell, mid + 1, hi));
+}
+
+/*
+    ord_combine delivers the union of a and b when oper is 'u', the
+    intersection for 'i' and the difference for 'd'. A key in both
+    keeps the value it has in a.
+*/
+PUBLIC Otree *ord_combine(Otree *a, Otree *b, int oper, char *name)
+{
+    Otree **x, **y, **z, *t;
+    long i = 0, j = 0, k = 0, m = ord_size(a), n = ord_size(b);
+    int c;
+
+    x = ord_cells(a);
+    y = ord_cells(b);
+    if ((z = malloc((m + n + 1) * sizeof(Otree *))) == 0)
+	execerror("memory", name);
+    while (i < m && j < n)
+	if ((c = ord_cmp(&x[i]->key, &y[j]->key, name)) < 0) {
+	    if (oper != 'i')
+		z[k++] = x[i];
+	    i++;
+	} else if (c > 0) {
+	    if (oper == 'u')
+		z[k++] = y[j];
+	    j++;
+	} else {
+	    if (oper != 'd')
+		z[k++] = x[i];
+	    i++;
+	    j++;
+	}
+    if (oper != 'i')
+	while (i < m)
+	    z[k++] = x[i++];
+    if (oper == 'u')
+	while (j < n)
+	    z[k++] = y[j++];
+    t = ord_build(z, 0, k);
+    free(x);
+    free(y);
+    free(z);
+    return t;
+}
+
+/*
+    ord_equal tests whether a and b have equal keys, and, when pairs is
+    set, equal values.
+*/
+PUBLIC int ord_equal(Otree *a, Otree *b, int pairs)
+{
+    Otree **x, **y;
+    long i;
+    int ok = 1;
+
+    if (a == b)
+	return 1;
+    if (ord_size(a) != ord_size(b))
+	return 0;
+    x = ord_cells(a);
+    y = ord_cells(b);
+    for (i = 0; ok && i < ord_size(a); i++)
+	ok = equal_aux(&x[i]->key, &y[i]->key) &&
+	     (!pairs || equal_aux(&x[i]->val, &y[i]->val));
+    free(x);
+    free(y);
+    return ok;
+}
+
+#ifndef GC_BDW
+/*
+    ord_forward updates keys and values after they have been copied by
+    the garbage collector, visiting shared subtrees only once.
+*/
+PUBLIC void ord_forward(Otree *t, long epoch)
+{
+    for (; t && t->epoch != epoch; t = t->right) {
+	t->epoch = epoch;
+	forward(t->key.op, &t->key.u);
+	forward(t->val.op, &t->val.u);
+	ord_forward(t->left, epoch);
+    }
+}
+#endif
+/* END of ORDERED.C */
@@ -0,0 +1,443 @@
+/* FILE: parallel.c */
+/*
+ *  module  : parallel.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+pmap and pfilter divide a list over workers, one for each processor.
+A worker is a process: a forked copy of the interpreter that runs the
+program on its part of the list, sends back the results over a pipe
+and exits. The parent reads the parts in order and builds the result
+list from them.
+
+A result is sent as a record: its type and its value, and for a list
+first its members and then their number. Numbers, characters, truth
+values, sets, strings and lists of these can be sent; for any other
+result, and when a worker fails, par_run gives up and the caller runs
+the program itself, that will then report the error if there is one.
+*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L			/* fdopen, fork	*/
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc_atomic
+#    define free(X)
+#endif
+
+#define PARMIN		8		/* members per worker	*/
+
+/*
+    VALS is the stack of the values that have been received and WALK
+    points into a list. Both must be seen by the garbage collector.
+*/
+#ifdef SINGLE
+#define par_vals	(joy_context->par_vals)
+#define par_walk	(joy_context->par_walk)
+#define VALS		par_vals
+#define WALK		par_walk
+#define KEEP(x)		par_walk = x
+#define DROP		par_walk = 0
+#else
+#define VALS		dump1
+#define WALK		dump2->u.lis
+#define KEEP(x)		dump2 = LIST_NEWNODE(x,dump2)
+#define DROP		dump2 = dump2->next
+#endif
+
+#ifndef _WIN32
+static int par_worker;				/* of the process	*/
+#define par_depth	(joy_context->par_depth)
+#define par_pid		(joy_context->par_pid)	/* jobs of par_fork	*/
+#define par_fp		(joy_context->par_fp)
+#define par_out		(joy_context->par_out)
+
+PUBLIC int par_workers(void)
+{
+    long n;
+
+    if (par_worker || (n = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+	return 1;
+    return n > PARMAX ? PARMAX : n;
+}
+
+/*
+    par_maxdepth is the depth of recursion up to which pbinrec hands the
+    first branch to a worker. Unless it has been set, it is such that
+    there are about as many workers as processors.
+*/
+PUBLIC long par_maxdepth(void)
+{
+    long depth, n;
+
+    if (par_depth >= 0)
+	return par_depth;
+    for (depth = 0, n = par_workers(); n > 1; n = (n + 1) / 2)
+	depth++;
+    return depth;
+}
+
+PUBLIC void par_setdepth(long depth)
+{
+    par_depth = depth < 0 ? -1 : depth > PARMAX ? PARMAX : depth;
+}
+
+/*
+    par_exit ends a worker after a run time error; par_run notices it.
+*/
+PUBLIC void par_exit(void)
+{
+    if (par_worker)
+	_exit(1);
+}
+
+/*
+    par_reap ends the jobs that are still running when an error or abort
+    leaves the program that started them, so that their slots are free
+    again and no process is left behind. A worker ends as well.
+*/
+PUBLIC void par_reap(void)
+{
+    int job, status;
+
+    for (job = 0; job < PARMAX; job++)
+	if (par_fp[job]) {
+	    fclose(par_fp[job]);
+	    par_fp[job] = 0;
+	    kill(par_pid[job], SIGKILL);
+	    waitpid(par_pid[job], &status, 0);
+	}
+    par_exit();
+}
+
+PRIVATE int par_send(FILE *fp, Node *n)
+{
+    long size, count;
+    Node *m;
+
+    switch (n->op) {
+    case LIST_:
+	for (count = 0, m = n->u.lis; m; m = m->next, count++)
+	    if (!par_send(fp, m))
+		return 0;
+	putc(LIST_, fp);
+	return fwrite(&count, sizeof(count), 1, fp) == 1;
+    case BOOLEAN_:
+    case CHAR_:
+    case INTEGER_:
+	putc(n->op, fp);
+	return fwrite(&n->u.num, sizeof(n->u.num), 1, fp) == 1;
+    case SET_:
+	putc(n->op, fp);
+	return fwrite(&n->u.set, sizeof(n->u.set), 1, fp) == 1;
+    case FLOAT_:
+	putc(n->op, fp);
+	return fwrite(&n->u.dbl, sizeof(n->u.dbl), 1, fp) == 1;
+    case STRING_:
+	size = strlen(n->u.str);
+	putc(n->op, fp);
+	return fwrite(&size, sizeof(size), 1, fp) == 1 &&
+	       fwrite(n->u.str, 1, size, fp) == (size_t)size;
+    default:
+	return 0;
+    }
+}
+
+/*
+    par_list replaces the top count values by the list of them.
+*/
+PRIVATE void par_list(long count)
+{
+    Node *n;
+
+    KEEP(NULL);
+    while (count--) {
+	n = newnode(VALS->op, VALS->u, WALK);
+	WALK = n;
+	VALS = VALS->next;
+    }
+    bucket.lis = WALK;
+    VALS = newnode(LIST_, bucket, VALS);
+    DROP;
+}
+
+/*
+    par_recv pushes the results of a worker on VALS and counts them in
+    depth, the number of values that VALS has grown by.
+*/
+PRIVATE int par_recv(FILE *fp, long *depth)
+{
+    int op;
+    long count;
+    char *str;
+
+    while ((op = getc(fp)) != EOF) {
+	switch (op) {
+	case LIST_:
+	    if (fread(&count, sizeof(count), 1, fp) != 1 || count > *depth)
+		return 0;
+	    par_list(count);
+	    *depth -= count;
+	    break;
+	case BOOLEAN_:
+	case CHAR_:
+	case INTEGER_:
+	    if (fread(&bucket.num, sizeof(bucket.num), 1, fp) != 1)
+		return 0;
+	    break;
+	case SET_:
+	    if (fread(&bucket.set, sizeof(bucket.set), 1, fp) != 1)
+		return 0;
+	    break;
+	case FLOAT_:
+	    if (fread(&bucket.dbl, sizeof(bucket.dbl), 1, fp) != 1)
+		return 0;
+	    break;
+	case STRING_:
+	    if (fread(&count, sizeof(count), 1, fp) != 1 || count < 0 ||
+		(str = malloc(count + 1)) == 0 ||
+		fread(str, 1, count, fp) != (size_t)count)
+		return 0;
+	    str[count] = '\0';
+	    bucket.str = str;
+	    break;
+	default:
+	    return 0;
+	}
+	if (op != LIST_)
+	    VALS = newnode(op, bucket, VALS);
+	(*depth)++;
+    }
+    return 1;
+}
+
+/*
+    par_work is what a worker does: it runs the program on the members
+    lo up to hi of the list and sends the results, or for a filter the
+    outcomes of the test, one byte each.
+*/
+PRIVATE void par_work(FILE *fp, long lo, long hi, int filter)
+{
+    long i;
+    int ok = 1;
+
+    par_worker = 1;
+    VALS = LIST_NEWNODE(stk, VALS);		/* [P] A .. */
+    KEEP(stk->next->u.lis);
+    for (i = 0; i < lo; i++)
+	WALK = WALK->next;
+    for (; ok && i < hi; i++) {
+	stk = newnode(WALK->op, WALK->u, VALS->u.lis->next->next);
+	exeterm(VALS->u.lis->u.lis);
+	if (stk == NULL)
+	    ok = 0;
+	else if (filter)
+	    ok = putc(stk->u.num != 0, fp) != EOF;
+	else
+	    ok = par_send(fp, stk);
+	WALK = WALK->next;
+    }
+    _exit(!ok || fflush(fp) != 0);
+}
+
+/*
+    par_fork starts a job. It delivers 0 in the worker, that must end
+    with par_done, and a job number above 0 in the parent, that must
+    wait for it with par_join, or -1 when no worker could be started.
+*/
+PUBLIC int par_fork(void)
+{
+    int fd[2], job, k, status;
+
+    for (job = 0; job < PARMAX && par_fp[job]; job++)
+	;
+    if (job == PARMAX || pipe(fd))
+	return -1;
+    fflush(stdout);
+    if ((par_pid[job] = fork()) == 0) {
+	par_worker = 1;
+	close(fd[0]);
+	for (k = 0; k < PARMAX; k++)		/* not the jobs of this one */
+	    if (par_fp[k]) {
+		fclose(par_fp[k]);
+		par_fp[k] = 0;
+	    }
+	if ((par_out = fdopen(fd[1], "wb")) == 0)
+	    _exit(1);
+	return 0;
+    }
+    close(fd[1]);
+    if (par_pid[job] < 0 || (par_fp[job] = fdopen(fd[0], "rb")) == 0) {
+	close(fd[0]);
+	if (par_pid[job] > 0)
+	    waitpid(par_pid[job], &status, 0);
+	return -1;
+    }
+    return job + 1;
+}
+
+/*
+    par_done sends the value n, or a failure if there is none, from a
+    worker to its parent and ends the worker.
+*/
+PUBLIC void par_done(Node *n)
+{
+    _exit(!n || !par_send(par_out, n) || fflush(par_out) != 0);
+}
+
+/*
+    par_join waits for the job and pushes the value it sent on the stack.
+    It delivers 0, and leaves the stack alone, when the worker failed.
+*/
+PUBLIC int par_join(int job)
+{
+    long depth = 0;
+    int status, ok;
+
+    job--;
+    ok = par_recv(par_fp[job], &depth) && depth == 1;
+    fclose(par_fp[job]);
+    par_fp[job] = 0;
+    if (waitpid(par_pid[job], &status, 0) < 0 || !WIFEXITED(status) ||
+	WEXITSTATUS(status))
+	ok = 0;
+    if (ok)
+	stk = newnode(VALS->op, VALS->u, stk);
+    while (depth--)
+	VALS = VALS->next;
+    return ok;
+}
+
+/*
+    par_run does A [P] map, or filter, with workers, for a list A. It
+    leaves the result on the stack and delivers 1, or delivers 0 and
+    leaves the stack as it was.
+*/
+PUBLIC int par_run(int filter)
+{
+    pid_t pid[PARMAX];
+    FILE *fp[PARMAX];
+    char *keep = 0;
+    int fd[2], workers, status, ok = 1, k, w;
+    long i, size, depth = 0;
+    Node *n;
+
+    for (size = 0, n = stk->next->u.lis; n; n = n->next)
+	size++;
+    if ((workers = par_workers()) > size / PARMIN)
+	workers = size / PARMIN;
+    if (workers < 2)
+	return 0;
+    fflush(stdout);
+    for (w = 0; w < workers; w++) {
+	if (pipe(fd))
+	    break;
+	if ((pid[w] = fork()) == 0) {
+	    close(fd[0]);
+	    if ((fp[w] = fdopen(fd[1], "wb")) == 0)
+		_exit(1);
+	    par_work(fp[w], w * size / workers, (w + 1) * size / workers,
+		     filter);
+	}
+	close(fd[1]);
+	if (pid[w] < 0 || (fp[w] = fdopen(fd[0], "rb")) == 0) {
+	    close(fd[0]);
+	    if (pid[w] > 0)
+		waitpid(pid[w], &status, 0);
+	    break;
+	}
+    }
+    if (w < workers)
+	ok = 0;
+    if (ok && filter && (keep = malloc(size)) == 0)
+	ok = 0;
+    for (k = 0; k < w; k++) {
+	if (ok && filter)
+	    ok = fread(keep + k * size / workers, 1,
+		       (k + 1) * size / workers - k * size / workers, fp[k])
+		 == (size_t)((k + 1) * size / workers - k * size / workers);
+	else if (ok)
+	    ok = par_recv(fp[k], &depth);
+	fclose(fp[k]);
+	if (waitpid(pid[k], &status, 0) < 0 || !WIFEXITED(status) ||
+	    WEXITSTATUS(status))
+	    ok = 0;
+    }
+    if (ok && !filter && depth != size)
+	ok = 0;
+    if (!ok) {
+	free(keep);
+	while (depth--)
+	    VALS = VALS->next;
+	return 0;
+    }
+    if (filter) {
+	KEEP(stk->next->u.lis);
+	for (i = 0; i < size; i++, WALK = WALK->next)
+	    if (keep[i]) {
+		VALS = newnode(WALK->op, WALK->u, VALS);
+		depth++;
+	    }
+	DROP;
+	free(keep);
+    }
+    par_list(depth);
+    stk = newnode(LIST_, VALS->u, stk->next->next);
+    VALS = VALS->next;
+    return 1;
+}
+#else
+PUBLIC int par_workers(void)
+{
+    return 1;
+}
+
+PUBLIC long par_maxdepth(void)
+{
+    return 0;
+}
+
+PUBLIC void par_setdepth(long depth)
+{
+}
+
+PUBLIC void par_exit(void)
+{
+}
+
+PUBLIC void par_reap(void)
+{
+}
+
+PUBLIC int par_fork(void)
+{
+    return -1;
+}
+
+PUBLIC void par_done(Node *n)
+{
+}
+
+PUBLIC int par_join(int job)
+{
+    return 0;
+}
+
+PUBLIC int par_run(int filter)
+{
+    return 0;
+}
+#endif
+/* END of PARALLEL.C */
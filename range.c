@@ -0,0 +1,136 @@
+/* FILE: range.c */
+/*
+ *  module  : range.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A range holds the integers or characters lo, lo + by, lo + 2 * by, ..
+as far as hi, without making them: the size, the i-th element and the
+membership of a value are computed from the three numbers. A range with
+a negative step counts down, and a range that does not reach hi from
+lo is empty. Ranges are never modified.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc_atomic
+#endif
+
+/*
+    rng_count delivers the number of elements of the range from lo to hi
+    in steps of by. It counts in unsigned long, where hi - lo cannot
+    overflow.
+*/
+PRIVATE unsigned long rng_count(long lo, long hi, long by)
+{
+    if (by > 0)
+	return lo > hi ? 0 :
+	       ((unsigned long)hi - (unsigned long)lo) / by + 1;
+    return lo < hi ? 0 :
+	   ((unsigned long)lo - (unsigned long)hi) / (0 - (unsigned long)by) + 1;
+}
+
+/*
+    rng_make delivers the range from lo to hi in steps of by, that must
+    not be 0, of integers or characters as type says. A range with more
+    elements than a long can count is refused.
+*/
+PUBLIC Range *rng_make(Operator type, long lo, long hi, long by)
+{
+    Range *r;
+
+    if (rng_count(lo, hi, by) > LONG_MAX)
+	execerror("smaller range", "rmake");
+    if ((r = malloc(sizeof(Range))) == 0)
+	execerror("memory", "range");
+    r->type = type;
+    r->lo = lo;
+    r->hi = hi;
+    r->by = by;
+    return r;
+}
+
+PUBLIC long rng_size(Range *r)
+{
+    return rng_count(r->lo, r->hi, r->by);
+}
+
+/*
+    rng_nth delivers the i-th element, for i below the size. The element
+    lies between lo and hi, but lo + i * by is computed in unsigned long,
+    as the product may not fit.
+*/
+PUBLIC long rng_nth(Range *r, long i)
+{
+    return (long)((unsigned long)r->lo + (unsigned long)i * r->by);
+}
+
+PUBLIC int rng_member(Range *r, long x)
+{
+    if (r->by > 0) {
+	if (x < r->lo || x > r->hi)
+	    return 0;
+	return ((unsigned long)x - (unsigned long)r->lo) % r->by == 0;
+    }
+    if (x > r->lo || x < r->hi)
+	return 0;
+    return ((unsigned long)r->lo - (unsigned long)x) %
+	   (0 - (unsigned long)r->by) == 0;
+}
+
+/*
+    rng_equal tests whether a and b have the same elements, in the same
+    order, regardless of how they were made.
+*/
+PUBLIC int rng_equal(Range *a, Range *b)
+{
+    long n = rng_size(a);
+
+    if (a->type != b->type || n != rng_size(b))
+	return 0;
+    return !n || (a->lo == b->lo && (n == 1 || a->by == b->by));
+}
+
+PUBLIC unsigned long rng_hash(Range *r)
+{
+    long n = rng_size(r);
+    unsigned long h = 19 * 31 + n;
+
+    if (n)
+	h = h * 31 + r->lo;
+    if (n > 1)
+	h = h * 31 + r->by;
+    return h;
+}
+
+PUBLIC void rng_write(Range *r, FILE *stm)
+{
+    Node n;
+    long size = rng_size(r);
+
+    fprintf(stm, "range:[");
+    n.op = r->type;
+    n.next = 0;
+    if (size) {
+	n.u.num = r->lo;
+	writefactor(&n, stm);
+	if (size > 1 && r->by != 1) {
+	    n.u.num = rng_nth(r, 1);
+	    fprintf(stm, " ");
+	    writefactor(&n, stm);
+	}
+	if (size > 1) {
+	    n.u.num = rng_nth(r, size - 1);
+	    fprintf(stm, " .. ");
+	    writefactor(&n, stm);
+	}
+    }
+    fprintf(stm, "]");
+}
+/* END of RANGE.C */
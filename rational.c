@@ -0,0 +1,240 @@
+/* FILE: rational.c */
+/*
+ *  module  : rational.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A rational is a fraction in lowest terms, with a positive denominator
+other than 1; numerator and denominator are integers, either INTEGER_
+or BIGNUM_. Fractions that reduce to a whole number are delivered as an
+integer, so that a RATIONAL_ is never equal to an INTEGER_. The functions
+below accept integers and rationals and deliver the kind that fits the
+result. Common factors are removed with the binary gcd of num_gcd.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#    define free(X)
+#endif
+
+static Node one = { { 1 }, INTEGER_, 0 };
+
+PRIVATE void parts(Node *a, Node **num, Node **den)
+{
+    if (a->op == RATIONAL_) {
+	*num = &a->u.rat->num;
+	*den = &a->u.rat->den;
+    } else {
+	*num = a;
+	*den = &one;
+    }
+}
+
+PRIVATE int negative(Node *n)
+{
+    return n->op == BIGNUM_ ? n->u.bnum->size < 0 : n->u.num < 0;
+}
+
+PRIVATE int isone(Node *n)
+{
+    return n->op != BIGNUM_ && n->u.num == 1;
+}
+
+PRIVATE void mul(Node *a, Node *b, Node *r)
+{
+    r->op = num_mul(a, b, &r->u);
+    r->next = 0;
+}
+
+PRIVATE void quotient(Node *a, Node *b, Node *q, Node *r)
+{
+    q->op = num_div(a, b, &q->u, &r->op, &r->u);
+    q->next = r->next = 0;
+}
+
+/*
+    rat_make delivers num/den in lowest terms; den must not be zero.
+*/
+PUBLIC Operator rat_make(Node *num, Node *den, Types *u)
+{
+    Node n, d, g, r;
+    Rational *rat;
+
+    n = *num;
+    d = *den;
+    if (negative(&d)) {
+	n.op = num_neg(num, &n.u);
+	d.op = num_neg(den, &d.u);
+    }
+    g.op = num_gcd(&n, &d, &g.u);
+    if (!isone(&g)) {
+	quotient(&n, &g, &n, &r);
+	quotient(&d, &g, &d, &r);
+    }
+    if (isone(&d)) {
+	*u = n.u;
+	return n.op;
+    }
+    if ((rat = malloc(sizeof(Rational))) == 0)
+	execerror("memory", "rational");
+    rat->num = n;
+    rat->den = d;
+    u->rat = rat;
+    return RATIONAL_;
+}
+
+/*
+    rat_arith computes a OPER b, where OPER is one of + - * /.
+    The divisor must not be zero.
+*/
+PUBLIC Operator rat_arith(Node *a, Node *b, int oper, Types *u)
+{
+    Node *an, *ad, *bn, *bd, x, y, n, d;
+
+    parts(a, &an, &ad);
+    parts(b, &bn, &bd);
+    switch (oper) {
+    case '+':
+    case '-':
+	if (ad == &one && bd == &one)
+	    return num_add(a, b, oper, u);
+	mul(an, bd, &x);
+	mul(bn, ad, &y);
+	n.op = num_add(&x, &y, oper, &n.u);
+	mul(ad, bd, &d);
+	break;
+    case '*':
+	if (ad == &one && bd == &one)
+	    return num_mul(a, b, u);
+	mul(an, bn, &n);
+	mul(ad, bd, &d);
+	break;
+    default:
+	mul(an, bd, &n);
+	mul(ad, bn, &d);
+	break;
+    }
+    n.next = 0;
+    return rat_make(&n, &d, u);
+}
+
+PUBLIC Operator rat_neg(Node *a, Types *u)
+{
+    Node *an, *ad, n;
+    Rational *rat;
+
+    parts(a, &an, &ad);
+    if (ad == &one)
+	return num_neg(a, u);
+    n.op = num_neg(an, &n.u);
+    n.next = 0;
+    if ((rat = malloc(sizeof(Rational))) == 0)
+	execerror("memory", "rational");
+    rat->num = n;
+    rat->den = *ad;
+    u->rat = rat;
+    return RATIONAL_;
+}
+
+PUBLIC int rat_sign(Node *a)
+{
+    Node *an, *ad;
+
+    parts(a, &an, &ad);
+    if (negative(an))
+	return -1;
+    return an->op == BIGNUM_ || an->u.num;
+}
+
+/*
+    rat_round delivers the integer nearest to a in the direction given
+    by mode: 'f'loor, 'c'eiling or 't'runcate.
+*/
+PUBLIC Operator rat_round(Node *a, int mode, Types *u)
+{
+    Node *an, *ad, q, r;
+
+    parts(a, &an, &ad);
+    if (ad == &one) {
+	*u = a->u;
+	return a->op;
+    }
+    quotient(an, ad, &q, &r);
+    if (mode == 'f' && negative(&r))
+	return num_add(&q, &one, '-', u);
+    if (mode == 'c' && !negative(&r))
+	return num_add(&q, &one, '+', u);
+    *u = q.u;
+    return q.op;
+}
+
+PUBLIC int rat_compare(Node *a, Node *b)
+{
+    Node *an, *ad, *bn, *bd, x, y;
+
+    parts(a, &an, &ad);
+    parts(b, &bn, &bd);
+    if (ad == &one && bd == &one)
+	return num_compare(a, b);
+    mul(an, bd, &x);
+    mul(bn, ad, &y);
+    return num_compare(&x, &y);
+}
+
+PUBLIC double rat_double(Node *a)
+{
+    Node *an, *ad;
+
+    parts(a, &an, &ad);
+    return num_double(an) / num_double(ad);
+}
+
+/*
+    rat_parse reads the fraction num/den, both written as integers.
+    It delivers ILLEGAL_ when the denominator is zero.
+*/
+PUBLIC Operator rat_parse(char *num, char *den, Types *u)
+{
+    Node n, d;
+
+    n.op = num_parse(num, &n.u);
+    d.op = num_parse(den, &d.u);
+    n.next = d.next = 0;
+    if (d.op != BIGNUM_ && d.u.num == 0)
+	return ILLEGAL_;
+    return rat_make(&n, &d, u);
+}
+
+PUBLIC char *rat_string(Node *a)
+{
+    Node *an, *ad;
+    char *num, *den, *str;
+
+    parts(a, &an, &ad);
+    num = num_string(an);
+    if (ad == &one)
+	return num;
+    den = num_string(ad);
+    if ((str = malloc(strlen(num) + strlen(den) + 2)) == 0)
+	execerror("memory", "rational");
+    sprintf(str, "%s/%s", num, den);
+    free(num);
+    free(den);
+    return str;
+}
+
+PUBLIC void rat_write(Node *a, FILE *stm)
+{
+    char *str;
+
+    str = rat_string(a);
+    fputs(str, stm);
+    free(str);
+}
+/* END of RATIONAL.C */
@@ -8,35 +8,33 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <errno.h>
 #include "globals.h"
-#ifdef strdup
-#undef strdup
-#endif
-#ifdef GC_BDW
-#include <gc.h>
-#define strdup GC_strdup
-#else
-#define strdup my_strdup
-#endif
 
-static struct {
-    FILE *fp;
-    char *name;
-    int linenum;
-} infile[INPSTACKMAX];
-static int ilevel = 0;
-static int linenumber = 0;
-static char linbuf[INPLINEMAX + 1];
-static int linelength = 0, currentcolumn = 0;
-#if 0
-static int errorcount = 0;
-#endif
-static int ch = ' ';
+#define infile		(joy_context->infile)
+#define ilevel		(joy_context->ilevel)
+#define linenumber	(joy_context->linenumber)
+#define linbuf		(joy_context->linbuf)
+#define linelength	(joy_context->linelength)
+#define currentcolumn	(joy_context->currentcolumn)
+#define errorcount	(joy_context->errorcount)
+#define ch		(joy_context->ch)
+#define srctext		(joy_context->srctext)
+#define tokrec		(joy_context->tokrec)
+#define tokend		(joy_context->tokend)
 
 PUBLIC void inilinebuffer(char *str)
 {
     infile[0].fp = srcfile;
     infile[0].name = str;
+    infile[0].cache = 0;
+    infile[0].started = 1;
+    infile[0].replay = 0;
+    if (tokend)
+	cache_free(tokend);
+    tokrec = tokend = 0;
+    ilevel = linenumber = linelength = currentcolumn = errorcount = 0;
+    ch = ' ';
 }
 
 PRIVATE void putline(void)
@@ -54,6 +52,28 @@ PRIVATE void putline(void)
     putchar('\n');
 }
 
+/*
+    gettextline reads a line of the text of joy_eval. The text ends with a
+    period, so that the last term need not have one.
+*/
+PRIVATE int gettextline(void)
+{
+    int i = 0;
+
+    if (!srctext)
+	return 0;
+    if (!*srctext) {
+	strcpy(linbuf, ".\n");
+	srctext = 0;
+	return 1;
+    }
+    while (*srctext && i < INPLINEMAX - 1)
+	if ((linbuf[i++] = *srctext++) == '\n')
+	    break;
+    linbuf[i] = '\0';
+    return 1;
+}
+
 PRIVATE void getch(void)
 {
     if (currentcolumn == linelength) {
@@ -62,12 +82,15 @@ Again:
 #endif
 	currentcolumn = linelength = 0;
 	linenumber++;
-	if (fgets(linbuf, INPLINEMAX, srcfile))
+	if (srcfile ? fgets(linbuf, INPLINEMAX, srcfile) != 0 :
+		      gettextline()) {
 	    linelength = strlen(linbuf);
-	else if (ilevel > 0) {
-	    fclose(infile[ilevel--].fp);
-	    srcfile = infile[ilevel].fp;
-	    linenumber = infile[ilevel].linenum;
+	    infile[ilevel].started = 1;
+	} else if (ilevel > 0)
+	    endinclude(1);
+	else if (joy_context->embedded) {	/* end of joy_eval */
+	    joy_context->status = JOY_OK;
+	    longjmp(joy_context->begin, 1);
 	} else
 	    quit_();
 	linbuf[linelength++] = ' ';  /* to help getsym for numbers */
@@ -93,6 +116,19 @@ PUBLIC void error(char *message)
 {
     int i;
 
+    if (joy_context->embedded) {		/* keep the first */
+	if (errorcount++)
+	    return;
+#ifdef USE_SNPRINTF
+	snprintf(joy_context->errmsg, INPLINEMAX, "line %d: %s", linenumber,
+		 message);
+#else
+	sprintf(joy_context->errmsg, "line %d: %.*s", linenumber,
+		INPLINEMAX - 20, message);
+#endif
+	return;
+    }
+    errorcount++;
     putline();
     if (echoflag > 1)
 	putchar('\t');
@@ -102,30 +138,85 @@ PUBLIC void error(char *message)
 	else
 	    putchar(' ');
     printf("^\n\t%s\n", message);
-#if 0
-    errorcount++;
-#endif
 }
 
+/*
+    restofline tells whether the rest of the line is blank.
+*/
+PRIVATE int restofline(void)
+{
+    int i;
+
+    if (ch > ' ')
+	return 0;
+    for (i = currentcolumn; i < linelength; i++)
+	if (linbuf[i] > ' ')
+	    return 0;
+    return 1;
+}
+
+/*
+    doinclude reads the file filnam after the rest of the line. When that
+    is blank and the file has a cache, see cache.c, the symbols are taken
+    from the cache; otherwise they are kept in a new one.
+*/
 PUBLIC int doinclude(char *filnam)
 {
     FILE *fp;
+    Cache *cache;
 
     if (ilevel+1 == INPSTACKMAX)
 	execerror("fewer include files", "include");
     infile[ilevel].fp = srcfile;
     infile[ilevel].linenum = linenumber;
+    if (cachedir && !echoflag && restofline() &&
+	(cache = cache_open(filnam)) != 0) {
+	currentcolumn = linelength;
+	linenumber = 0;
+	infile[++ilevel].fp = srcfile = 0;
+	infile[ilevel].name = filnam;
+	infile[ilevel].linenum = 0;
+	infile[ilevel].cache = cache;
+	infile[ilevel].started = infile[ilevel].replay = 1;
+	return 1;
+    }
     linenumber = 0;
     if ((fp = fopen(filnam, "r")) != 0) {
 	infile[++ilevel].fp = srcfile = fp;
 	infile[ilevel].name = filnam;
 	infile[ilevel].linenum = 0;
+	infile[ilevel].cache = cachedir ? cache_new(filnam, errorcount) : 0;
+	infile[ilevel].started = infile[ilevel].replay = 0;
 	return 1;
     }
     execerror("valid file name", "include");
     return -1; /* not reached */
 }
 
+/*
+    endinclude returns to the file that did the include. When the file
+    was read to the end, done, its cache is written.
+*/
+PUBLIC void endinclude(int done)
+{
+    Cache *cache;
+
+    if (infile[ilevel].fp)
+	fclose(infile[ilevel].fp);
+    if ((cache = infile[ilevel].cache) != 0) {
+	if (infile[ilevel].replay || !done)
+	    cache_free(cache);
+	else if (cache == tokrec)		/* still in getsym */
+	    tokend = cache;
+	else
+	    cache_end(cache, errorcount);
+	infile[ilevel].cache = 0;
+    }
+    ilevel--;
+    srcfile = infile[ilevel].fp;
+    linenumber = infile[ilevel].linenum;
+}
+
 #ifdef FGET_FROM_FILE
 PUBLIC void redirect(FILE *fp)
 {
@@ -134,19 +225,8 @@ PUBLIC void redirect(FILE *fp)
     infile[++ilevel].fp = fp;
     infile[ilevel].name = 0;
     infile[ilevel].linenum = 0;
-}
-#endif
-
-#ifndef GC_BDW
-char *my_strdup(char *str)
-{
-    char *ptr;
-    size_t leng;
-
-    leng = strlen(str);
-    if ((ptr = malloc(leng + 1)) != 0)
-	strcpy(ptr, str);
-    return ptr;
+    infile[ilevel].cache = 0;
+    infile[ilevel].started = infile[ilevel].replay = 0;
 }
 #endif
 
@@ -195,14 +275,43 @@ PRIVATE int peek(void)
     return linbuf[currentcolumn];
 }
 
-PUBLIC void getsym(void)
+/*
+    tokfile gives the cache of the file that has the line with the symbol
+    that starts at ch. An include that has not started comes after that
+    line, so that the cache of the line cannot be used.
+*/
+PRIVATE Cache *tokfile(void)
+{
+    int i;
+
+    if (infile[ilevel].started)
+	return infile[ilevel].cache;
+    if (ch == '#' || (ch == '(' && peek() == '*'))
+	return 0;
+    for (i = ilevel - 1; !infile[i].started; i--)
+	;
+    if (infile[i].cache)
+	cache_fail(infile[i].cache);
+    return 0;
+}
+
+PRIVATE void scan(void)
 {
     int i = 0;
     char string[INPLINEMAX];
 
 Start:
-    while (ch <= ' ')
+    tokrec = 0;
+    while (ch <= ' ') {
+	if (currentcolumn == linelength && infile[ilevel].replay) {
+	    if (cache_next(infile[ilevel].cache))
+		return;
+	    endinclude(1);
+	    continue;
+	}
 	getch();
+    }
+    tokrec = tokfile();
     switch (ch) {
     case '(':
 	getch();
@@ -268,7 +377,7 @@ Start:
 	}
 	string[i] = '\0';
 	getch();
-	numb = (size_t)strdup(string);
+	numb = (size_t)intern(string, 0);
 	symb = STRING_;
 	return;
     case '-': /* PERHAPS unary minus */
@@ -302,6 +411,20 @@ Start:
 	    }
 	    while (isdigit(ch))
 		getch();
+	    if (ch == '/' && isdigit(peek())) {
+		getch();
+		next = currentcolumn - 1;
+		while (isdigit(ch))
+		    getch();
+		symb = rat_parse(&linbuf[start], &linbuf[next], &bignumb);
+		if (symb == ILLEGAL_) {
+		    error("non-zero denominator expected");
+		    symb = INTEGER_;
+		    numb = 0;
+		} else if (symb == INTEGER_)
+		    numb = bignumb.num;
+		return;
+	    }
 	    if (ch == '.' && isdigit(peek())) {
 		do
 		    getch();
@@ -318,12 +441,15 @@ Start:
 		return;
 	    }
 done:
+	    errno = 0;
 #ifdef BIT_32
 	    numb = strtol(&linbuf[start], NULL, 0);
 #else
 	    numb = strtoll(&linbuf[start], NULL, 0);
 #endif
 	    symb = INTEGER_;
+	    if (errno == ERANGE)
+		symb = num_parse(&linbuf[start], &bignumb);
 	    return;
 	}
 	/* ELSE '-' is not unary minus, fall through */
@@ -390,3 +516,17 @@ done:
 	return;
     }
 }
+
+/*
+    getsym reads the next symbol, and keeps it in the cache of the file.
+*/
+PUBLIC void getsym(void)
+{
+    scan();
+    if (tokrec)
+	cache_add(tokrec);
+    if (tokend) {
+	cache_end(tokend, errorcount);
+	tokend = 0;
+    }
+}
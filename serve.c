@@ -0,0 +1,147 @@
+/* FILE: serve.c */
+/*
+ *  module  : serve.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+joy --serve name listens on the Unix domain socket name. The libraries
+have been read by then, see joy.c; each connection gets a forked copy of
+the interpreter, that shares their definitions with the server until it
+changes them, and starts with an empty stack. The copy reads a program
+from the connection as joy reads its file, writes the output to it, and
+ends at the end of the program.
+
+A request that runs longer than the time limit is stopped with a message,
+and one that needs more memory than the limit fails as it would when
+the memory runs out. A request that crashes ends only its own process.
+*/
+#ifndef _WIN32
+#define _XOPEN_SOURCE 600			/* sigaltstack	*/
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+
+#define SERVEMAX	64		/* waiting connections	*/
+#define SERVESTACK	65536		/* for serve_signal	*/
+
+/*
+    serve_signal ends a request that took too long or crashed, and tells
+    the client. It runs on a stack of its own, because the crash may be
+    a stack that has overflowed.
+*/
+PRIVATE void serve_signal(int sig)
+{
+    static char timeout[] = "run time error: time limit exceeded\n",
+		crash[] = "run time error: the request crashed\n";
+
+    if (sig == SIGALRM) {
+	if (write(1, timeout, sizeof(timeout) - 1) < 0)
+	    _exit(2);
+    } else if (write(1, crash, sizeof(crash) - 1) < 0)
+	_exit(2);
+    _exit(1);
+}
+
+/*
+    serve_request makes the connection conn the input and output of the
+    process, and sets the limits of the request.
+*/
+PRIVATE void serve_request(int conn, int seconds, long megabytes)
+{
+    static char stack[SERVESTACK];
+    struct rlimit lim;
+    struct sigaction act;
+    stack_t alt;
+
+    signal(SIGCHLD, SIG_DFL);			/* par_join waits	*/
+    if ((srcfile = fdopen(conn, "r")) == 0 || dup2(conn, 1) < 0 ||
+	dup2(conn, 2) < 0)
+	_exit(1);
+    alt.ss_sp = stack;
+    alt.ss_size = SERVESTACK;
+    alt.ss_flags = 0;
+    sigaltstack(&alt, 0);
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = serve_signal;
+    act.sa_flags = SA_ONSTACK;
+    sigaction(SIGSEGV, &act, 0);
+    sigaction(SIGBUS, &act, 0);
+    sigaction(SIGFPE, &act, 0);
+    sigaction(SIGALRM, &act, 0);
+    if (megabytes > 0) {
+	lim.rlim_cur = lim.rlim_max = (rlim_t)megabytes << 20;
+	setrlimit(RLIMIT_AS, &lim);
+    }
+    if (seconds > 0)
+	alarm(seconds);
+    inilinebuffer(0);
+    stk = 0;
+}
+
+/*
+    serve accepts connections on the socket name. It returns only in the
+    process of a request, that then reads and runs the program.
+*/
+PUBLIC void serve(char *name, int seconds, long megabytes)
+{
+    struct sockaddr_un addr;
+    struct sigaction act;
+    struct stat st;
+    int sock, conn;
+    pid_t pid;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(name) >= sizeof(addr.sun_path)) {
+	printf("the socket name '%s' is too long.\n", name);
+	exit(0);
+    }
+    strcpy(addr.sun_path, name);
+    if (!stat(name, &st) && S_ISSOCK(st.st_mode))	/* left by a server */
+	unlink(name);
+    if ((sock = socket(AF_UNIX, SOCK_STREAM, 0)) < 0 ||
+	bind(sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+	listen(sock, SERVEMAX)) {
+	printf("failed to serve on '%s'.\n", name);
+	exit(0);
+    }
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = SIG_IGN;			/* no zombies	*/
+    act.sa_flags = SA_NOCLDWAIT;
+    sigaction(SIGCHLD, &act, 0);
+    signal(SIGPIPE, SIG_IGN);
+    fflush(stdout);
+    for (;;) {
+	if ((conn = accept(sock, 0, 0)) < 0)
+	    continue;
+	if ((pid = fork()) == 0) {
+	    close(sock);
+	    signal(SIGPIPE, SIG_DFL);
+	    serve_request(conn, seconds, megabytes);
+	    return;
+	}
+	if (pid < 0 && write(conn, "failed to start the request\n", 28) < 0)
+	    perror("serve");
+	close(conn);
+    }
+}
+#else
+PUBLIC void serve(char *name, int seconds, long megabytes)
+{
+    printf("joy --serve is not available on this system.\n");
+    exit(0);
+}
+#endif
+/* END of SERVE.C */
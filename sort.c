@@ -0,0 +1,62 @@
+/* FILE: sort.c */
+/*
+ *  module  : sort.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+Both sorts are stable merge sorts, top down, that take an element of the
+right half before one of the left half only when it is strictly less.
+sort_list sorts list cells by relinking them: it neither allocates nor
+copies, so the cells must be fresh. sort_index sorts an array of indices
+for a comparison that may run a program, during which the cells may be
+moved by the garbage collector.
+*/
+#include <stdio.h>
+#include "globals.h"
+
+PUBLIC Node *sort_list(Node *list, long n, int (*less)(Node *, Node *))
+{
+    Node head, *left, *right, *tail;
+    long i;
+
+    if (n < 2)
+	return list;
+    for (tail = list, i = 1; i < n / 2; i++)
+	tail = tail->next;
+    right = tail->next;
+    tail->next = 0;
+    left = sort_list(list, n / 2, less);
+    right = sort_list(right, n - n / 2, less);
+    for (tail = &head; left && right; tail = tail->next)
+	if (less(right, left)) {
+	    tail->next = right;
+	    right = right->next;
+	} else {
+	    tail->next = left;
+	    left = left->next;
+	}
+    tail->next = left ? left : right;
+    return head.next;
+}
+
+PUBLIC void sort_index(long *index, long *temp, long n, int (*less)(long, long))
+{
+    long i, j, k, half = n / 2;
+
+    if (n < 2)
+	return;
+    sort_index(index, temp, half, less);
+    sort_index(index + half, temp, n - half, less);
+    for (i = 0, j = half, k = 0; i < half && j < n; k++)
+	if (less(index[j], index[i]))
+	    temp[k] = index[j++];
+	else
+	    temp[k] = index[i++];
+    while (i < half)
+	temp[k++] = index[i++];
+    for (i = 0; i < k; i++)
+	index[i] = temp[i];
+}
+/* END of SORT.C */
@@ -0,0 +1,111 @@
+/* FILE: stream.c */
+/*
+ *  module  : stream.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A stream is a lazy list: it holds its first element, the head, and what
+is needed to make the rest when it is asked for, which depends on the
+kind of stream:
+
+    'l'	the rest of a list, in state
+    'u'	the head, prog applied to it, as long as test holds
+    'm'	prog applied to the head of the stream src
+    'f'	the head of src, of which the elements that fail test are skipped
+    'z'	the pairs of the heads of src and src2
+    'c'	the stream or list that prog delivers
+
+The rest is a new stream, so streams are never modified and can be
+shared, and an element that has been passed is garbage. The heads are
+computed by the interpreter, that runs the programs; here the streams
+are only built. The empty stream is a null pointer.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#endif
+
+PRIVATE void str_node(Node *dest, Node *src)
+{
+    if (src) {
+	dest->op = src->op;
+	dest->u = src->u;
+    } else
+	memset(dest, 0, sizeof(Node));
+    dest->next = 0;
+}
+
+/*
+    str_new delivers a stream of the kind given; head is 0 when it is
+    still to be computed from src.
+*/
+PUBLIC Stream *str_new(int kind, Node *head, Node *prog, Node *test,
+		       Stream *src, Stream *src2)
+{
+    Stream *s;
+
+    if ((s = malloc(sizeof(Stream))) == 0)
+	execerror("memory", "stream");
+    s->epoch = 0;
+    s->kind = kind;
+    str_node(&s->head, head);
+    str_node(&s->state, 0);
+    str_node(&s->prog, prog);
+    str_node(&s->test, test);
+    s->src = src;
+    s->src2 = src2;
+    return s;
+}
+
+/*
+    str_list delivers the stream of the members of a list.
+*/
+PUBLIC Stream *str_list(Node *list)
+{
+    Stream *s;
+
+    if (!list)
+	return 0;
+    s = str_new('l', list, 0, 0, 0, 0);
+    s->state.op = LIST_;
+    s->state.u.lis = list;
+    return s;
+}
+
+/*
+    str_write shows the head only, because the rest may be endless.
+*/
+PUBLIC void str_write(Stream *s, FILE *stm)
+{
+    fprintf(stm, "stream:[");
+    if (s) {
+	writefactor(&s->head, stm);
+	fprintf(stm, " ..");
+    }
+    fprintf(stm, "]");
+}
+
+#ifndef GC_BDW
+/*
+    str_forward updates a stream, and the streams it is made from, after
+    the nodes it refers to have been copied by the garbage collector.
+*/
+PUBLIC void str_forward(Stream *s, long epoch)
+{
+    for (; s && s->epoch != epoch; s = s->src) {
+	s->epoch = epoch;
+	forward(s->head.op, &s->head.u);
+	forward(s->state.op, &s->state.u);
+	forward(s->prog.op, &s->prog.u);
+	forward(s->test.op, &s->test.u);
+	str_forward(s->src2, epoch);
+    }
+}
+#endif
+/* END of STREAM.C */
@@ -0,0 +1,567 @@
+/* FILE: task.c */
+/*
+ *  module  : task.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+spawn hands a program, with a copy of the stack, to a task and join
+waits for the task and pushes its result. The tasks are run by a pool
+of threads, one for each processor, that is started by the first spawn.
+Each thread runs its own context, see context.c, so that it has its own
+stack, dumps and node memory and allocates without a lock.
+
+Every thread of the pool has a queue of tasks. A task spawned by a
+thread of the pool goes to the end of its own queue, another one goes to
+the queues in turn. A thread takes the last task of its own queue and
+when that is empty, the first task of another queue. A task that no
+thread has taken yet when it is joined is taken out of its queue and
+run by the thread that joins it, on a stack of its own. When all the
+threads wait, in join or for a channel, while there are tasks that none
+has taken, the pool grows by a thread, up to PARMAX. When libjoy closes
+its last context the pool is stopped, see libjoy.c.
+
+Values do not move from one context to another: they are written into
+cells, a list as its members followed by their number, and built again
+by the context that needs them. Numbers, characters, truth values, sets,
+strings, files, symbols and lists of these can be handed over, and
+bignums, rationals, arrays, ranges and channels, that live outside of
+node memory. Dictionaries, vectors, deques, heaps, ordered sets and maps
+and streams cannot.
+
+A task that fails is done; join then repeats the run time error, quit or
+abort of the task. A task must not read or write definitions, and it
+must not read from the input.
+*/
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L			/* pthread_atfork */
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include "globals.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+#ifdef GC_BDW
+#    define GC_THREADS
+#    include <gc.h>
+#    define TASK_ALLOC(n)	GC_malloc_uncollectable(n)
+#    define TASK_FREE(p)	GC_free(p)
+#else
+#    define TASK_ALLOC(n)	malloc(n)
+#    define TASK_FREE(p)	free(p)
+#endif
+
+#define TASKMIN		16		/* slots in a queue	*/
+
+enum { TASK_WAITING, TASK_RUNNING, TASK_DONE };
+
+typedef struct Task
+  { long id;
+    int state, status;				/* status when done	*/
+    long size;
+    Cell *cells;				/* program, or result	*/
+    int queue;					/* -1 if in none	*/
+    char message[INPLINEMAX / 2], op[INPLINEMAX / 2];
+    struct Task *next; } Task;
+
+typedef struct Queue
+  { JoyContext *context;			/* of the thread	*/
+    Task **task;
+    long first, last, size; } Queue;
+
+static Task *tasks;				/* not joined yet	*/
+static long task_last;				/* handle		*/
+
+#ifndef _WIN32
+static Queue queues[PARMAX];
+static pthread_t threads[PARMAX];
+static int queue_count, queue_next, task_started, task_forked;
+static int task_atfork, task_stopping;
+static int task_blocked;			/* threads that wait	*/
+static THREAD int task_self;			/* 1 + queue of thread	*/
+static pthread_mutex_t task_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t task_work = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t task_done = PTHREAD_COND_INITIALIZER;
+#define LOCK		pthread_mutex_lock(&task_lock)
+#define UNLOCK		pthread_mutex_unlock(&task_lock)
+#else
+#define LOCK
+#define UNLOCK
+#endif
+
+/*
+    task_count gives the number of cells of the value n.
+*/
+PRIVATE long task_count(Node *n, char *name)
+{
+    long size = 1;
+
+    switch (n->op) {
+    case LIST_:
+	for (n = n->u.lis; n; n = n->next)
+	    size += task_count(n, name);
+	break;
+    case DICT_:
+    case VECTOR_:
+    case DEQUE_:
+    case HEAP_:
+    case ORDSET_:
+    case ORDMAP_:
+    case STREAM_:
+	execerror("plain values", name);
+	break;
+    }
+    return size;
+}
+
+PRIVATE Cell *task_fill(Cell *cell, Node *n)
+{
+    long count = 0;
+    Node *m;
+
+    if (n->op == LIST_) {
+	for (m = n->u.lis; m; m = m->next, count++)
+	    cell = task_fill(cell, m);
+	cell->u.num = count;
+    } else
+	cell->u = n->u;
+    cell->op = n->op;
+    return cell + 1;
+}
+
+/*
+    task_stack writes the values of the stack n, the deepest first.
+*/
+PRIVATE Cell *task_stack(Cell *cell, Node *n)
+{
+    if (n) {
+	cell = task_stack(cell, n->next);
+	cell = task_fill(cell, n);
+    }
+    return cell;
+}
+
+/*
+    task_cells writes the value n into new cells, and gives their number
+    in size.
+*/
+PUBLIC Cell *task_cells(Node *n, long *size, char *name)
+{
+    Cell *cells;
+
+    *size = task_count(n, name);
+    if ((cells = TASK_ALLOC(*size * sizeof(Cell))) == 0)
+	execerror("memory", name);
+    task_fill(cells, n);
+    return cells;
+}
+
+PUBLIC void task_free(Cell *cells)
+{
+    TASK_FREE(cells);
+}
+
+/*
+    task_load pushes the values in the cells on the stack.
+*/
+PUBLIC void task_load(Cell *cell, long size)
+{
+    for (; size--; cell++)
+	if (cell->op == LIST_)
+	    make_list(cell->u.num);
+	else
+	    stk = newnode(cell->op, cell->u, stk);
+}
+
+/*
+    task_exec runs the task on the stack, that holds only the result
+    afterwards.
+*/
+PRIVATE void task_exec(Task *t)
+{
+    Node *n;
+
+    stk = NULL;
+    task_load(t->cells, t->size);
+    TASK_FREE(t->cells);
+    t->cells = 0;
+    n = stk->u.lis;
+    stk = stk->next;
+    exeterm(n);
+    if (stk == NULL)
+	execerror("result of task", "join");
+}
+
+#ifndef _WIN32
+/*
+    task_run is how a thread of the pool runs a task. The context of the
+    thread is embedded, so that an error ends up here with a status.
+*/
+PRIVATE void task_run(Task *t)
+{
+    joy_context->status = JOY_ABORT;
+    if (setjmp(joy_context->begin) == 0) {
+	task_exec(t);
+	t->cells = task_cells(stk, &t->size, "join");
+	joy_context->status = JOY_OK;
+    }
+    if (joy_context->status != JOY_OK && t->cells) {
+	TASK_FREE(t->cells);
+	t->cells = 0;
+    }
+    if (joy_context->status == JOY_ERROR) {
+	strcpy(t->message, joy_context->errmess);
+	strcpy(t->op, joy_context->errop);
+    }
+    t->status = joy_context->status;
+    stk = NULL;
+#ifndef SINGLE
+    conts = dump = dump1 = dump2 = dump3 = dump4 = dump5 = NULL;
+#endif
+}
+
+/*
+    task_take gives a waiting task for queue k, or 0. The caller must
+    hold the lock.
+*/
+PRIVATE Task *task_take(int k)
+{
+    Queue *q = &queues[k];
+    Task *t;
+    int i;
+
+    if (q->first < q->last)
+	t = q->task[--q->last];
+    else {
+	for (i = 1; i < queue_count; i++) {
+	    q = &queues[(k + i) % queue_count];
+	    if (q->first < q->last)
+		break;
+	}
+	if (i == queue_count)
+	    return 0;
+	t = q->task[q->first++];
+    }
+    t->state = TASK_RUNNING;
+    t->queue = -1;
+    return t;
+}
+
+PRIVATE void *task_worker(void *arg)
+{
+    Queue *q = arg;
+    Task *t;
+
+    task_self = q - queues + 1;
+    joy_context = q->context;
+    joy_context->embedded = 1;
+    tracegc = 0;
+    LOCK;
+    for (;;) {
+	while ((t = task_take(task_self - 1)) == 0 && !task_stopping)
+	    pthread_cond_wait(&task_work, &task_lock);
+	if (!t)
+	    break;
+	UNLOCK;
+	task_run(t);
+	LOCK;
+	t->state = TASK_DONE;
+	pthread_cond_broadcast(&task_done);
+    }
+    UNLOCK;
+    return 0;
+}
+
+/*
+    A process that has been forked has no pool: its tasks are run by
+    join, but tasks that the pool was running then are lost.
+*/
+PRIVATE void task_prepare(void)
+{
+    LOCK;
+}
+
+PRIVATE void task_parent(void)
+{
+    UNLOCK;
+}
+
+PRIVATE void task_child(void)
+{
+    task_forked = 1;
+    queue_count = 0;
+    UNLOCK;
+}
+
+/*
+    task_grow adds a thread to the pool, with the lock held, and delivers
+    0 when it cannot.
+*/
+PRIVATE int task_grow(void)
+{
+    Queue *q = &queues[queue_count];
+
+    if (queue_count == PARMAX || task_stopping ||
+	(q->context = joy_context_new()) == 0)
+	return 0;
+    if (pthread_create(&threads[queue_count], 0, task_worker, q)) {
+	joy_context_free(q->context);
+	return 0;
+    }
+    queue_count++;
+    return 1;
+}
+
+/*
+    task_start starts the pool, with the lock held.
+*/
+PRIVATE void task_start(void)
+{
+    int n;
+
+    task_started = 1;
+    if (!task_atfork) {
+	if (pthread_atfork(task_prepare, task_parent, task_child))
+	    return;
+	task_atfork = 1;
+    }
+    for (n = par_workers(); queue_count < n && task_grow(); )
+	;
+}
+
+/*
+    task_block counts a thread of the pool that is going to wait, with
+    the lock held. When they all wait while there are tasks that none has
+    taken, these may be what they wait for: another thread is started.
+*/
+PRIVATE void task_block(void)
+{
+    int k;
+
+    if (++task_blocked < queue_count)
+	return;
+    for (k = 0; k < queue_count && queues[k].first == queues[k].last; k++)
+	;
+    if (k < queue_count)
+	task_grow();
+}
+
+/*
+    task_wait is called with 1 before a thread waits for a channel and
+    with 0 after.
+*/
+PUBLIC void task_wait(int on)
+{
+    if (!task_self)
+	return;
+    LOCK;
+    if (on)
+	task_block();
+    else
+	task_blocked--;
+    UNLOCK;
+}
+
+PRIVATE void task_queue(Task *t)
+{
+    Queue *q;
+    Task **task;
+    long size;
+
+    if (!task_started && !task_forked)
+	task_start();
+    if (!queue_count)
+	return;
+    t->queue = task_self ? task_self - 1 : queue_next++ % queue_count;
+    q = &queues[t->queue];
+    if (q->last == q->size) {
+	if (q->first > 0) {
+	    memmove(q->task, q->task + q->first,
+		    (q->last - q->first) * sizeof(Task *));
+	    q->last -= q->first;
+	    q->first = 0;
+	} else {
+	    size = q->size ? 2 * q->size : TASKMIN;
+	    if ((task = realloc(q->task, size * sizeof(Task *))) == 0) {
+		t->queue = -1;
+		return;
+	    }
+	    q->task = task;
+	    q->size = size;
+	}
+    }
+    q->task[q->last++] = t;
+    if (task_blocked == queue_count)
+	task_grow();
+    pthread_cond_signal(&task_work);
+}
+
+/*
+    task_unqueue takes a waiting task out of its queue.
+*/
+PRIVATE void task_unqueue(Task *t)
+{
+    Queue *q;
+    long i;
+
+    if (t->queue < 0)
+	return;
+    q = &queues[t->queue];
+    for (i = q->first; q->task[i] != t; i++)
+	;
+    memmove(q->task + i, q->task + i + 1, (q->last - i - 1) * sizeof(Task *));
+    q->last--;
+    t->queue = -1;
+}
+#endif
+
+/*
+    task_stop ends the pool: the threads run the tasks that are left and
+    then exit. The tasks that have not been joined are disposed of, and a
+    later spawn starts the pool again.
+*/
+PUBLIC void task_stop(void)
+{
+    Task *t;
+#ifndef _WIN32
+    int k, count;
+
+    LOCK;
+    task_stopping = 1;
+    pthread_cond_broadcast(&task_work);
+    count = queue_count;
+    UNLOCK;
+    for (k = 0; k < count; k++)
+	pthread_join(threads[k], 0);
+    LOCK;
+    for (k = 0; k < count; k++) {
+	joy_context_free(queues[k].context);
+	free(queues[k].task);
+	memset(&queues[k], 0, sizeof(Queue));
+    }
+    queue_count = queue_next = task_blocked = 0;
+    task_started = task_stopping = 0;
+#else
+    LOCK;
+#endif
+    while ((t = tasks) != 0) {
+	tasks = t->next;
+	if (t->cells)
+	    TASK_FREE(t->cells);
+	free(t);
+    }
+    UNLOCK;
+}
+
+/*
+    task_spawn turns .. [P] into .. T, where T is the handle of a task
+    that runs P on a copy of the stack.
+*/
+PUBLIC void task_spawn(void)
+{
+    Task *t;
+    Cell *cells;
+    Node *n;
+    long size;
+
+    for (size = 0, n = stk; n; n = n->next)
+	size += task_count(n, "spawn");
+    if ((cells = TASK_ALLOC(size * sizeof(Cell))) == 0)
+	execerror("memory", "spawn");
+    if ((t = malloc(sizeof(Task))) == 0) {
+	TASK_FREE(cells);
+	execerror("memory", "spawn");
+    }
+    t->cells = cells;
+    t->size = size;
+    task_stack(t->cells, stk);
+    t->state = TASK_WAITING;
+    t->queue = -1;
+    LOCK;
+    t->id = ++task_last;
+    t->next = tasks;
+    tasks = t;
+#ifndef _WIN32
+    task_queue(t);
+#endif
+    UNLOCK;
+    stk = INTEGER_NEWNODE(t->id, stk->next);
+}
+
+/*
+    task_join pushes the result of the task with handle id. A task that
+    has not been taken yet is run here, with the stack kept aside.
+*/
+PUBLIC void task_join(long id)
+{
+    Task task, *t, **p;
+    char message[INPLINEMAX / 2], op[INPLINEMAX / 2];
+    int status;
+
+    LOCK;
+    for (p = &tasks; *p && (*p)->id != id; p = &(*p)->next)
+	;
+    if ((t = *p) == 0) {
+	UNLOCK;
+	execerror("task handle", "join");
+    }
+    *p = t->next;
+    if (t->state == TASK_WAITING) {
+#ifndef _WIN32
+	task_unqueue(t);
+#endif
+	UNLOCK;
+	task = *t;				/* an error leaves here */
+	free(t);
+#ifdef SINGLE
+	{
+	    Node *save = stk;
+
+	    task_exec(&task);
+	    stk = newnode(stk->op, stk->u, save);
+	}
+#else
+	dump1 = LIST_NEWNODE(stk, dump1);
+	task_exec(&task);
+	stk = newnode(stk->op, stk->u, dump1->u.lis);
+	dump1 = dump1->next;
+#endif
+	return;
+    }
+#ifndef _WIN32
+    if (t->state != TASK_DONE) {
+	if (task_forked) {
+	    UNLOCK;
+	    execerror("task of this process", "join");
+	}
+	if (task_self)
+	    task_block();
+	while (t->state != TASK_DONE)
+	    pthread_cond_wait(&task_done, &task_lock);
+	if (task_self)
+	    task_blocked--;
+    }
+#endif
+    UNLOCK;
+    if ((status = t->status) == JOY_OK) {
+	task_load(t->cells, t->size);
+	TASK_FREE(t->cells);
+	free(t);
+	return;
+    }
+    if (status == JOY_ERROR) {
+	strcpy(message, t->message);
+	strcpy(op, t->op);
+    }
+    free(t);
+    if (status == JOY_ERROR)
+	execerror(message, op);
+    if (status == JOY_QUIT)
+	quit_();
+    abortexecution_();
+}
+/* END of TASK.C */
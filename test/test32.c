@@ -0,0 +1,85 @@
+/*
+    test32: libjoy, the interpreter in the process of another program.
+*/
+#include <stdio.h>
+#include "joy.h"
+
+static int twice(JoyContext *c)
+{
+    joy_int n;
+    int status;
+
+    if ((status = joy_pop_integer(c, &n)) != JOY_OK)
+	return status;
+    return joy_push_integer(c, 2 * n);
+}
+
+static void show(JoyContext *c, int status)
+{
+    joy_int n;
+    double d;
+    const char *s;
+    long i, count;
+
+    printf("status %d %s\n", status, joy_error(c));
+    while (joy_depth(c))
+	switch (joy_type(c)) {
+	case JOY_INTEGER:
+	    joy_pop_integer(c, &n);
+	    printf("integer %lld\n", (long long)n);
+	    break;
+	case JOY_FLOAT:
+	    joy_pop_float(c, &d);
+	    printf("float %g\n", d);
+	    break;
+	case JOY_STRING:
+	    joy_pop_string(c, &s);
+	    printf("string %s\n", s);
+	    break;
+	case JOY_LIST:
+	    joy_pop_list(c, &count);
+	    printf("list of %ld:", count);
+	    for (i = 0; i < count; i++) {
+		joy_pop_integer(c, &n);
+		printf(" %lld", (long long)n);
+	    }
+	    printf("\n");
+	    break;
+	default:
+	    printf("type %d\n", joy_type(c));
+	    joy_eval(c, "pop");
+	    break;
+	}
+}
+
+int main(void)
+{
+    JoyContext *c, *d;
+
+    c = joy_open();
+    d = joy_open();
+    show(c, joy_eval(c, "2 3 + 1.5 \"abc\""));
+    show(c, joy_eval(c, "DEFINE sq == dup *. 7 sq [1 2 3] [sq] map"));
+    show(c, joy_register(c, "twice", twice));
+    show(d, joy_eval(d, "21 twice 5 sq"));
+    show(d, joy_eval(d, "'a twice"));
+    show(c, joy_eval(c, "1 [2 3] + 4"));
+    show(c, joy_eval(c, "10 20 quit 30"));
+    show(c, joy_eval(c, "{1 x} 2"));
+    show(c, joy_eval_file(c, "no such file"));
+    joy_push_integer(d, 4);
+    joy_push_integer(d, 5);
+    joy_push_integer(d, 6);
+    joy_push_list(d, 2);
+    show(d, joy_eval(d, "[twice] map"));
+    joy_push_string(d, "xyz");
+    show(d, joy_eval(d, "size"));
+    show(c, joy_eval(c, "[6 7 *] spawn join [1 'a +] spawn join"));
+    show(d, joy_eval(d, "[100 sq] spawn pop"));
+    joy_close(d);
+    joy_close(c);
+    c = joy_open();
+    show(c, joy_eval(c, "[2 3 *] spawn join"));
+    joy_close(c);
+    return 0;
+}
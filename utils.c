@@ -14,15 +14,15 @@
 #endif
 
 #ifndef GC_BDW
-static Node
-    memory[MEMORYMAX],
-    *memoryindex = memory,
-    *mem_low = memory,
-    *mem_mid;
+#define memory		(joy_context->memory)
+#define memoryindex	(joy_context->memoryindex)
+#define mem_low		(joy_context->mem_low)
+#define mem_mid		(joy_context->mem_mid)
 #define MEM_HIGH (MEMORYMAX-1)
-static int direction = 1;
-static int nodesinspected, nodescopied;
-static int start_gc_clock;
+#define direction	(joy_context->direction)
+#define nodesinspected	(joy_context->nodesinspected)
+#define nodescopied	(joy_context->nodescopied)
+#define start_gc_clock	(joy_context->start_gc_clock)
 #endif
 
 PUBLIC void inimem1(void)
@@ -79,8 +79,8 @@ PRIVATE Node *copy(Node *n)
 	printf("copy ..\n");
     if (n == NULL)
 	return NULL;
-    if (n < mem_low)
-	return n; /* later: combine with previous line */
+    if (n < mem_low || n > &memory[MEM_HIGH])
+	return n; /* definitions, maybe of another context */
     if (n->op == ILLEGAL_) {
 	printf("copy: illegal node  ");
 	printnode(n);
@@ -101,6 +101,52 @@ PRIVATE Node *copy(Node *n)
     case SET_:
 	temp->u.set = n->u.set;
 	break;
+    case BIGSET_:
+	temp->u.big = n->u.big;
+	break;
+    case BIGNUM_:
+	temp->u.bnum = n->u.bnum;
+	break;
+    case RATIONAL_:
+	temp->u.rat = n->u.rat;
+	break;
+    case FLOATARRAY_:
+	temp->u.farr = n->u.farr;
+	break;
+    case INTARRAY_:
+	temp->u.iarr = n->u.iarr;
+	break;
+    case RANGE_:
+	temp->u.rng = n->u.rng;
+	break;
+    case CHANNEL_:
+	temp->u.chan = n->u.chan;
+	break;
+    case DICT_:
+	temp->u.dict = n->u.dict;
+	forward(DICT_, &temp->u);
+	break;
+    case VECTOR_:
+	temp->u.vec = n->u.vec;
+	forward(VECTOR_, &temp->u);
+	break;
+    case DEQUE_:
+	temp->u.deq = n->u.deq;
+	forward(DEQUE_, &temp->u);
+	break;
+    case HEAP_:
+	temp->u.heap = n->u.heap;
+	forward(HEAP_, &temp->u);
+	break;
+    case ORDSET_:
+    case ORDMAP_:
+	temp->u.ord = n->u.ord;
+	forward(temp->op, &temp->u);
+	break;
+    case STREAM_:
+	temp->u.stream = n->u.stream;
+	forward(STREAM_, &temp->u);
+	break;
     case STRING_:
 	temp->u.str = n->u.str;
 	break;
@@ -127,6 +173,40 @@ PRIVATE Node *copy(Node *n)
     }
     return temp;
 }
+
+/*
+    forward updates a value that is kept outside of memory, such as the
+    pairs in a dictionary, after the nodes it refers to have been copied.
+*/
+PUBLIC void forward(Operator op, Types *u)
+{
+    switch (op) {
+    case LIST_:
+	u->lis = copy(u->lis);
+	break;
+    case DICT_:
+	dict_forward(u->dict, gc_epoch);
+	break;
+    case VECTOR_:
+	vec_forward(u->vec, gc_epoch);
+	break;
+    case DEQUE_:
+	deq_forward(u->deq, gc_epoch);
+	break;
+    case HEAP_:
+	heap_forward(u->heap, gc_epoch);
+	break;
+    case ORDSET_:
+    case ORDMAP_:
+	ord_forward(u->ord, gc_epoch);
+	break;
+    case STREAM_:
+	str_forward(u->stream, gc_epoch);
+	break;
+    default:
+	break;
+    }
+}
 #endif
 
 #ifndef GC_BDW
@@ -136,6 +216,7 @@ PRIVATE void gc1(char *mess)
     if (tracegc > 1)
 	printf("begin %s garbage collection\n", mess);
     direction = -direction;
+    gc_epoch++;
     memoryindex = (direction == 1) ? mem_low : &memory[MEM_HIGH];
 /*
     if (tracegc > 1) {
@@ -156,7 +237,7 @@ PRIVATE void gc1(char *mess)
 	    printf("new %s = ", NAME);				\
 	    writeterm(X, stdout); printf("\n"); } }
 
-    COP(stk, "stk"); COP(prog, "prog"); COP(conts, "conts");
+    COP(stk, "stk"); COP(joy_context->prog, "prog"); COP(conts, "conts");
     COP(dump, "dump"); COP(dump1, "dump1"); COP(dump2, "dump2");
     COP(dump3, "dump3"); COP(dump4, "dump4"); COP(dump5, "dump5");
 }
@@ -208,8 +289,7 @@ PUBLIC Node *newnode(Operator o, Types u, Node *r)
 #ifndef GC_BDW
     if (memoryindex == mem_mid) {
 	gc1("automatic");
-	if (o == LIST_)
-	    u.lis = copy(u.lis);
+	forward(o, &u);
 	r = copy(r);
 	gc2("automatic");
 	if ((direction ==  1 && memoryindex >= mem_mid) ||
@@ -244,7 +324,8 @@ PUBLIC void memoryindex_(void)
 
 PUBLIC void readfactor(void)	/* read a JOY factor		*/
 {
-    long set = 0;
+    Bigset *set = 0;
+    Operator op;
 
     switch (symb) {
     case ATOM:
@@ -285,16 +366,23 @@ D(  printf("found field: %s\n", mod_fields->name); )
 	bucket.num = numb;
 	stk = newnode(symb, bucket, stk);
 	return;
+    case BIGNUM_:
+    case RATIONAL_:
+	stk = newnode(symb, bignumb, stk);
+	return;
     case FLOAT_:
 	stk = FLOAT_NEWNODE(dblf, stk);
 	return;
     case LBRACE:
 	while (getsym(), symb != RBRACE)
-	    if (symb == CHAR_ || symb == INTEGER_)
-		set = set | (1 << numb);
-	    else
+	    if (symb != CHAR_ && symb != INTEGER_)
 		error("numeric expected in set");
-	stk = SET_NEWNODE(set, stk);
+	    else if (numb < 0 || numb >= BIGSETMAX)
+		error("set member out of range");
+	    else
+		set = set_add(set, numb);
+	op = set_make(set, &bucket);
+	stk = newnode(op, bucket, stk);
 	return;
     case LBRACK:
 	getsym();
@@ -356,8 +444,8 @@ PUBLIC void readterm(void)
 PUBLIC void writefactor(Node *n, FILE *stm)
 {
     char *p;
-    int i;
-    long set;
+    long i;
+    Node *key, *val;
 
     if (n == NULL)
 	execerror("non-empty stack", "print");
@@ -372,19 +460,27 @@ PUBLIC void writefactor(Node *n, FILE *stm)
 	fprintf(stm, "%lld", n->u.num);
 #endif
 	return;
+    case BIGNUM_:
+	num_write(n, stm);
+	return;
+    case RATIONAL_:
+	rat_write(n, stm);
+	return;
+    case FLOATARRAY_:
+    case INTARRAY_:
+	arr_write(n, stm);
+	return;
     case FLOAT_:
 	fprintf(stm, "%g", n->u.dbl);
 	return;
     case SET_:
-	set = n->u.set;
+    case BIGSET_:
 	fprintf(stm, "{");
-	for (i = 0; i < SETSIZE; i++)
-	    if (set & (1 << i)) {
-		fprintf(stm, "%d", i);
-		set = set & ~(1 << i);
-		if (set != 0)
-		    fprintf(stm, " ");
-	    }
+	for (i = set_next(n, 0); i >= 0; i = set_next(n, i + 1)) {
+	    fprintf(stm, "%ld", i);
+	    if (set_next(n, i + 1) >= 0)
+		fprintf(stm, " ");
+	}
 	fprintf(stm, "}");
 	return;
     case CHAR_:
@@ -419,6 +515,65 @@ PUBLIC void writefactor(Node *n, FILE *stm)
 	else
 	    fprintf(stm, "file:%p", (void *)n->u.fil);
 	return;
+    case DICT_:
+	fprintf(stm, "dict:[");
+	for (i = 0; (key = dict_nth(n->u.dict, i, &val)) != NULL; i++) {
+	    if (i)
+		fprintf(stm, " ");
+	    fprintf(stm, "[");
+	    writefactor(key, stm);
+	    fprintf(stm, " ");
+	    writefactor(val, stm);
+	    fprintf(stm, "]");
+	}
+	fprintf(stm, "]");
+	return;
+    case VECTOR_:
+	fprintf(stm, "vector:[");
+	for (i = 0; i < vec_size(n->u.vec); i++) {
+	    if (i)
+		fprintf(stm, " ");
+	    writefactor(vec_at(n->u.vec, i), stm);
+	}
+	fprintf(stm, "]");
+	return;
+    case DEQUE_:
+	deq_write(n->u.deq, stm);
+	return;
+    case HEAP_:
+	fprintf(stm, "heap:%ld", n->u.heap->count);
+	return;
+    case ORDSET_:
+	fprintf(stm, "oset:[");
+	for (i = 0; (key = ord_nth(n->u.ord, i, 0)) != NULL; i++) {
+	    if (i)
+		fprintf(stm, " ");
+	    writefactor(key, stm);
+	}
+	fprintf(stm, "]");
+	return;
+    case ORDMAP_:
+	fprintf(stm, "omap:[");
+	for (i = 0; (key = ord_nth(n->u.ord, i, &val)) != NULL; i++) {
+	    if (i)
+		fprintf(stm, " ");
+	    fprintf(stm, "[");
+	    writefactor(key, stm);
+	    fprintf(stm, " ");
+	    writefactor(val, stm);
+	    fprintf(stm, "]");
+	}
+	fprintf(stm, "]");
+	return;
+    case STREAM_:
+	str_write(n->u.stream, stm);
+	return;
+    case RANGE_:
+	rng_write(n->u.rng, stm);
+	return;
+    case CHANNEL_:
+	chan_write(n->u.chan, stm);
+	return;
     default:
 	fprintf(stm, "%s", symtab[(int)n->op].name);
 	return;
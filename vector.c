@@ -0,0 +1,262 @@
+/* FILE: vector.c */
+/*
+ *  module  : vector.c
+ *  version : 1.1
+ *  date    : 10/19/26
+ */
+
+/*
+A vector is a trie with VWIDTH branches per level. The leaves hold the
+elements, VWIDTH at a time; the last ones are kept apart in a tail, so
+that appending only copies the tail, and touches the trie once every
+VWIDTH elements. Looking up element i follows the bits of i, VBITS at a
+time, from the root down. Vectors are never modified: an update copies
+the path from the root to the leaf and shares everything else, so that
+the old vector remains valid. The empty vector is a null pointer.
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "globals.h"
+#ifdef GC_BDW
+#    include <gc.h>
+#    define malloc GC_malloc
+#endif
+
+#define VBITS		5
+#define VWIDTH		(1 << VBITS)
+#define VMASK		(VWIDTH - 1)
+
+typedef struct Vnode {
+    long epoch;					/* of the last forward	*/
+    union {
+	struct Vnode *sub[VWIDTH];
+	Node elem[VWIDTH];
+    } u;
+} Vnode;
+
+PRIVATE Vnode *alloc_vnode(Vnode *from)
+{
+    Vnode *n;
+
+    if ((n = malloc(sizeof(Vnode))) == 0)
+	execerror("memory", "vector");
+    if (from)
+	memcpy(n, from, sizeof(Vnode));
+    else
+	memset(n, 0, sizeof(Vnode));
+    n->epoch = 0;
+    return n;
+}
+
+PRIVATE Vector *alloc_vector(Vector *from)
+{
+    Vector *v;
+
+    if ((v = malloc(sizeof(Vector))) == 0)
+	execerror("memory", "vector");
+    if (from)
+	*v = *from;
+    else
+	memset(v, 0, sizeof(Vector));
+    v->epoch = 0;
+    return v;
+}
+
+PRIVATE long tail_offset(Vector *v)
+{
+    return v->count < VWIDTH ? 0 : ((v->count - 1) >> VBITS) << VBITS;
+}
+
+PRIVATE void set_elem(Node *e, Node *x)
+{
+    e->op = x->op;
+    e->u = x->u;
+    e->next = 0;
+}
+
+PUBLIC long vec_size(Vector *v)
+{
+    return v ? v->count : 0;
+}
+
+/*
+    vec_at delivers element i, which must exist. The element stays where
+    it is, because vectors are not moved by the garbage collector.
+*/
+PUBLIC Node *vec_at(Vector *v, long i)
+{
+    Vnode *n;
+    int shift;
+
+    if (i >= tail_offset(v))
+	return &v->tail->u.elem[i & VMASK];
+    for (n = v->root, shift = v->shift; shift > 0; shift -= VBITS)
+	n = n->u.sub[(i >> shift) & VMASK];
+    return &n->u.elem[i & VMASK];
+}
+
+PRIVATE Vnode *new_path(int shift, Vnode *leaf)
+{
+    Vnode *n;
+
+    if (shift == 0)
+	return leaf;
+    n = alloc_vnode(0);
+    n->u.sub[0] = new_path(shift - VBITS, leaf);
+    return n;
+}
+
+PRIVATE Vnode *push_tail(Vnode *parent, int shift, long count, Vnode *leaf)
+{
+    Vnode *n, *child;
+    int i;
+
+    n = alloc_vnode(parent);
+    i = ((count - 1) >> shift) & VMASK;
+    if (shift == VBITS)
+	n->u.sub[i] = leaf;
+    else if ((child = parent ? parent->u.sub[i] : 0) != 0)
+	n->u.sub[i] = push_tail(child, shift - VBITS, count, leaf);
+    else
+	n->u.sub[i] = new_path(shift - VBITS, leaf);
+    return n;
+}
+
+PUBLIC Vector *vec_push(Vector *v, Node *x)
+{
+    Vector *w;
+    Vnode *root;
+    long off;
+
+    w = alloc_vector(v);
+    if (!v) {
+	w->shift = VBITS;
+	w->tail = alloc_vnode(0);
+    } else if ((off = tail_offset(v)) > v->count - VWIDTH) {
+	w->tail = alloc_vnode(v->tail);		/* room in the tail */
+	set_elem(&w->tail->u.elem[v->count - off], x);
+	w->count++;
+	return w;
+    } else {					/* move the tail down */
+	if ((v->count >> VBITS) > (1L << v->shift)) {
+	    root = alloc_vnode(0);
+	    root->u.sub[0] = v->root;
+	    root->u.sub[1] = new_path(v->shift, v->tail);
+	    w->shift += VBITS;
+	} else
+	    root = push_tail(v->root, v->shift, v->count, v->tail);
+	w->root = root;
+	w->tail = alloc_vnode(0);
+    }
+    set_elem(&w->tail->u.elem[0], x);
+    w->count++;
+    return w;
+}
+
+PRIVATE Vnode *assoc(Vnode *n, int shift, long i, Node *x)
+{
+    Vnode *m;
+
+    m = alloc_vnode(n);
+    if (shift == 0)
+	set_elem(&m->u.elem[i & VMASK], x);
+    else
+	m->u.sub[(i >> shift) & VMASK] =
+	    assoc(n->u.sub[(i >> shift) & VMASK], shift - VBITS, i, x);
+    return m;
+}
+
+/*
+    vec_assign replaces element i, or appends when i is the size.
+*/
+PUBLIC Vector *vec_assign(Vector *v, long i, Node *x)
+{
+    Vector *w;
+
+    if (i == vec_size(v))
+	return vec_push(v, x);
+    w = alloc_vector(v);
+    if (i >= tail_offset(v)) {
+	w->tail = alloc_vnode(v->tail);
+	set_elem(&w->tail->u.elem[i & VMASK], x);
+    } else
+	w->root = assoc(v->root, v->shift, i, x);
+    return w;
+}
+
+/*
+    vec_make builds a vector of the elements of a list. The vector is
+    not yet shared, so the tail is filled in place.
+*/
+PUBLIC Vector *vec_make(Node *n)
+{
+    Vector *v = 0;
+    long off;
+
+    for (; n; n = n->next)
+	if (v && (off = tail_offset(v)) > v->count - VWIDTH)
+	    set_elem(&v->tail->u.elem[v->count++ - off], n);
+	else
+	    v = vec_push(v, n);
+    return v;
+}
+
+/*
+    vec_list builds the list of the elements of a vector, from the end.
+*/
+PUBLIC Node *vec_list(Vector *v)
+{
+    Node *n = 0, *e;
+    long i;
+
+    for (i = vec_size(v) - 1; i >= 0; i--) {
+	e = vec_at(v, i);
+	n = newnode(e->op, e->u, n);
+    }
+    return n;
+}
+
+PUBLIC int vec_equal(Vector *a, Vector *b)
+{
+    long i;
+
+    if (a == b)
+	return 1;
+    if (vec_size(a) != vec_size(b))
+	return 0;
+    for (i = 0; i < a->count; i++)
+	if (!equal_aux(vec_at(a, i), vec_at(b, i)))
+	    return 0;
+    return 1;
+}
+
+#ifndef GC_BDW
+PRIVATE void forward_vnode(Vnode *n, int shift, long epoch)
+{
+    int i;
+
+    if (!n || n->epoch == epoch)
+	return;
+    n->epoch = epoch;
+    for (i = 0; i < VWIDTH; i++)
+	if (shift)
+	    forward_vnode(n->u.sub[i], shift - VBITS, epoch);
+	else
+	    forward(n->u.elem[i].op, &n->u.elem[i].u);
+}
+
+/*
+    vec_forward updates the elements of a vector after they have been
+    copied by the garbage collector, visiting shared parts only once.
+*/
+PUBLIC void vec_forward(Vector *v, long epoch)
+{
+    if (!v || v->epoch == epoch)
+	return;
+    v->epoch = epoch;
+    forward_vnode(v->root, v->shift, epoch);
+    forward_vnode(v->tail, 0, epoch);
+}
+#endif
+/* END of VECTOR.C */